@@ -0,0 +1,47 @@
+# PGO训练负载（由pgo-train目标调用）：
+# 生成浅水、深水合成数据，依次以Green、Mix、DeepByRed、DeepOutLas模式处理，再运行一遍基准测试。
+# 输入：LIDAR SYNTH BENCH WORK_DIR PROFILE_DIR [LLVM_PROFDATA]
+cmake_minimum_required(VERSION 3.18)
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+function(run)
+	execute_process(COMMAND ${ARGN} WORKING_DIRECTORY ${WORK_DIR} RESULT_VARIABLE result OUTPUT_QUIET)
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "PGO training step failed (${result}): ${ARGN}")
+	endif()
+endfunction()
+
+# 命令行批处理：文件、模式，入射角默认为0
+function(process file mode)
+	execute_process(COMMAND ${LIDAR} ${WORK_DIR}/${file} --mode ${mode} --no-stats
+		WORKING_DIRECTORY ${WORK_DIR} RESULT_VARIABLE result OUTPUT_QUIET)
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "PGO training run failed (${result}): ${file} mode ${mode}")
+	endif()
+endfunction()
+
+message(STATUS "Generating synthetic training data in ${WORK_DIR}")
+run(${SYNTH} shallow.bin --frames 200 --corrupt 0.01 --seed 1 --truth -)
+run(${SYNTH} deep.bin --frames 2000 --deep --seed 2 --truth -)
+
+foreach(mode 1 3)
+	message(STATUS "Training: shallow.bin mode ${mode}")
+	process(shallow.bin ${mode})
+endforeach()
+foreach(mode 6 7)
+	message(STATUS "Training: deep.bin mode ${mode}")
+	process(deep.bin ${mode})
+endforeach()
+
+message(STATUS "Training: benchmark")
+run(${BENCH} --min-time 0.05 --repetitions 1 --json ${WORK_DIR}/bench.json)
+
+# Clang的原始剖析数据需合并为.profdata；GCC直接使用目录中的.gcda
+if(LLVM_PROFDATA)
+	file(GLOB raw ${PROFILE_DIR}/*.profraw)
+	if(raw)
+		run(${LLVM_PROFDATA} merge -output=${PROFILE_DIR}/default.profdata ${raw})
+	endif()
+endif()
+message(STATUS "PGO profile written to ${PROFILE_DIR}")
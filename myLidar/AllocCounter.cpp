@@ -0,0 +1,89 @@
+/*************************************************
+Description:ڴ
+**************************************************/
+#include "AllocCounter.h"
+
+#ifdef LIDAR_COUNT_ALLOC
+
+#include <stdlib.h>
+#include <new>
+
+static thread_local size_t threadAllocCount = 0;	//ǰ̵߳Ķڴ
+
+
+#if defined(__GLIBC__)
+//תglibcʵֻ֣ӼfreeҪ滻
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *p, size_t size);
+
+extern "C" void *malloc(size_t size) __THROW
+{
+	threadAllocCount++;
+	return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size) __THROW
+{
+	threadAllocCount++;
+	return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *p, size_t size) __THROW
+{
+	threadAllocCount++;
+	return __libc_realloc(p, size);
+}
+#endif
+
+
+void *operator new(size_t size)
+{
+#if !defined(__GLIBC__)
+	threadAllocCount++;				//glibcmalloc
+#endif
+	void *p = malloc(size ? size : 1);
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+	free(p);
+}
+
+
+size_t GetThreadAllocCount()
+{
+	return threadAllocCount;
+}
+
+#else
+
+size_t GetThreadAllocCount()
+{
+	return 0;
+}
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef AllocCounter_H
+#define AllocCounter_H
+
+#include <stddef.h>
+
+
+//ڴLIDAR_COUNT_ALLOCʱCMakeѡMYLIDAR_COUNT_ALLOC滻ȫoperator new
+//glibcͬʱ滻malloccallocreallocC루levmarҲ룻ƽֻ̨ͳoperator new
+//ͳƵǰ̵߳ȷ֡·ûжڴ룻
+//δúʱͳƣΪ0
+size_t GetThreadAllocCount();
+
+
+#endif
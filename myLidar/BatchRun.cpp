@@ -0,0 +1,557 @@
+/*************************************************
+Description:
+                вһļͨĿ¼Ҫ룻
+                ļһ̳߳أͬʱȡļȴļ
+                ļǰ׺дĿ¼дȫļĻͳ
+**************************************************/
+#define _CRT_SECURE_NO_WARNINGS
+#include "BatchRun.h"
+#include "ReadFile.h"
+#include "WorkerPool.h"
+#include "Platform.h"
+#include "BufferedFile.h"
+#include "Trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <set>
+#include <thread>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#include <direct.h>
+#else
+#include <glob.h>
+#endif
+
+extern float angle;
+
+static const char *modeNames[BatchModeCount] = { "blue", "green", "all", "mix", "output", "deep", "deepred", "deeplas" };
+
+
+void PrintBatchUsage()
+{
+	printf("Usage: myLidar <input>... --mode MODE [options]\n"
+		"       myLidar                 interactive menu\n"
+		"  <input>                 raw file, wildcard (\"survey/*.bin\") or directory (all files in it)\n"
+		"  --mode MODE             blue, green, all, mix, output, deep, deepred, deeplas (or 0-7 as in the menu)\n"
+		"  --angle A               laser incidence angle in degrees (default 0)\n"
+		"  --threads N             processing threads, 0 for all cores, 1 for frame by frame (default 0)\n"
+		"  --batch N               frames per parallel batch (default 256)\n"
+		"  --readers N             files read at the same time, largest first (default 1)\n"
+		"  --format FMT            result format: text or binary (default text)\n"
+		"  --background            write full buffers on a background writer thread\n"
+		"  --direct                bypass the system cache when writing (Linux O_DIRECT)\n"
+		"  --write-buffer MB       write buffer size in MB (default 4)\n"
+		"  --out DIR               output directory (default current); names are prefixed with the input name\n"
+		"  --summary PATH          combined statistics JSON (default <out>/SurveyStats.json)\n"
+		"  --no-stats              do not write the statistics JSON files\n"
+		"  --sample SECONDS        print statistics samples to stderr at this interval\n"
+		"  --counters              per-stage hardware counters (frame by frame only)\n"
+		"  --trace PATH            write a Chrome trace timeline\n"
+		"  --isa NAME              scalar, sse4.2, avx2 or avx512 (default: detected)\n"
+		"  --progress              print percentage progress\n"
+		"  --interactive           use the menu with the options above\n");
+}
+
+
+const char *BatchModeName(int mode)
+{
+	return (mode >= 0 && mode < BatchModeCount) ? modeNames[mode] : "unknown";
+}
+
+
+//ģʽ˵
+static int parseMode(const char *text)
+{
+	for (int i = 0; i < BatchModeCount; i++)
+	{
+		if (strcmp(text, modeNames[i]) == 0)
+			return i;
+	}
+	char *end;
+	long value = strtol(text, &end, 10);
+	if (*text != '\0' && *end == '\0' && value >= 0 && value < BatchModeCount)
+		return (int)value;
+	return -1;
+}
+
+
+/*************************************************
+Function:       
+Description:	--ͷĲΪ룻ĬϲӡٷֱȽȣ־е˸
+Input:          argc,argv:в
+Output:			options:ѡǷɹ
+*************************************************/
+bool ParseBatchArgs(int argc, char *argv[], BatchOptions &options)
+{
+	options.stats.progress = false;
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strncmp(argv[i], "--", 2) != 0)
+			options.inputs.push_back(argv[i]);
+		else if (strcmp(argv[i], "--mode") == 0 && hasValue)
+		{
+			options.mode = parseMode(argv[++i]);
+			if (options.mode < 0)
+			{
+				printf("Unknown mode %s.\n", argv[i]);
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--angle") == 0 && hasValue)
+			options.angle = (float)atof(argv[++i]);
+		else if (strcmp(argv[i], "--threads") == 0 && hasValue)
+			options.threads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--batch") == 0 && hasValue)
+			options.batchSize = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--readers") == 0 && hasValue)
+			options.readers = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--format") == 0 && hasValue)
+		{
+			i++;
+			if (strcmp(argv[i], "text") == 0)
+				options.format = OUTPUT_TEXT;
+			else if (strcmp(argv[i], "binary") == 0)
+				options.format = OUTPUT_BINARY;
+			else
+			{
+				printf("Unknown format %s.\n", argv[i]);
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--background") == 0)
+			options.write.background = true;
+		else if (strcmp(argv[i], "--direct") == 0)
+			options.write.direct = true;
+		else if (strcmp(argv[i], "--write-buffer") == 0 && hasValue)
+		{
+			int megabytes = atoi(argv[++i]);
+			if (megabytes <= 0)
+			{
+				printf("Invalid write buffer size %s.\n", argv[i]);
+				return false;
+			}
+			options.write.bufferSize = (size_t)megabytes << 20;
+		}
+		else if (strcmp(argv[i], "--out") == 0 && hasValue)
+			options.outDir = argv[++i];
+		else if (strcmp(argv[i], "--summary") == 0 && hasValue)
+			options.summaryPath = argv[++i];
+		else if (strcmp(argv[i], "--no-stats") == 0)
+			options.stats.enabled = false;
+		else if (strcmp(argv[i], "--sample") == 0 && hasValue)
+			options.stats.sampleInterval = atof(argv[++i]);
+		else if (strcmp(argv[i], "--counters") == 0)
+			options.stats.counters = true;
+		else if (strcmp(argv[i], "--trace") == 0 && hasValue)
+			options.tracePath = argv[++i];
+		else if (strcmp(argv[i], "--isa") == 0 && hasValue)
+			options.isa = argv[++i];
+		else if (strcmp(argv[i], "--progress") == 0)
+			options.stats.progress = true;
+		else if (strcmp(argv[i], "--interactive") == 0)
+		{
+			options.interactive = true;
+			options.stats.progress = true;
+		}
+		else
+		{
+			PrintBatchUsage();
+			return false;
+		}
+	}
+	if (options.interactive)
+		return true;
+	if (options.inputs.empty() || options.mode < 0 || options.threads < 0 || options.batchSize <= 0 || options.readers <= 0)
+	{
+		PrintBatchUsage();
+		return false;
+	}
+	return true;
+}
+
+
+static bool isDirectory(const string &path)
+{
+	struct stat info;
+	return stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFMT) == S_IFDIR;
+}
+
+
+static bool isRegularFile(const string &path)
+{
+	struct stat info;
+	return stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFMT) == S_IFREG;
+}
+
+
+static string joinPath(const string &dir, const string &name)
+{
+	if (dir.empty())
+		return name;
+	char last = dir[dir.size() - 1];
+	return (last == '/' || last == '\\') ? dir + name : dir + "/" + name;
+}
+
+
+//·еļĿ¼չ
+static string fileStem(const string &path)
+{
+	size_t slash = path.find_last_of("/\\");
+	string name = slash == string::npos ? path : path.substr(slash + 1);
+	size_t dot = name.find_last_of('.');
+	return (dot == string::npos || dot == 0) ? name : name.substr(0, dot);
+}
+
+
+//ͨƥͨļ
+static void matchFiles(const string &pattern, vector<string> &files)
+{
+#ifdef _WIN32
+	size_t slash = pattern.find_last_of("/\\");
+	string dir = slash == string::npos ? "" : pattern.substr(0, slash + 1);
+	_finddata_t data;
+	intptr_t handle = _findfirst(pattern.c_str(), &data);
+	if (handle == -1)
+		return;
+	do {
+		if (!(data.attrib & _A_SUBDIR))
+			files.push_back(dir + data.name);
+	} while (_findnext(handle, &data) == 0);
+	_findclose(handle);
+#else
+	glob_t result;
+	if (glob(pattern.c_str(), 0, NULL, &result) == 0)
+	{
+		for (size_t i = 0; i < result.gl_pathc; i++)
+		{
+			if (isRegularFile(result.gl_pathv[i]))
+				files.push_back(result.gl_pathv[i]);
+		}
+	}
+	globfree(&result);
+#endif
+}
+
+
+/*************************************************
+Function:       չ
+Description:	Ŀ¼ȡеȫͨļĿ¼*?[ʱͨƥ䣬
+				ƥļظȥԭʧʱڴʱ
+Input:          inputs:е
+Output:			ļб
+*************************************************/
+vector<string> ExpandInputs(const vector<string> &inputs)
+{
+	vector<string> files;
+	for (size_t i = 0; i < inputs.size(); i++)
+	{
+		const string &input = inputs[i];
+		bool directory = isDirectory(input);
+		if (!directory && input.find_first_of("*?[") == string::npos)
+		{
+			files.push_back(input);
+			continue;
+		}
+
+		vector<string> matched;
+		matchFiles(directory ? joinPath(input, "*") : input, matched);
+		if (matched.empty())
+			printf("No files match %s.\n", input.c_str());
+		sort(matched.begin(), matched.end());
+		files.insert(files.end(), matched.begin(), matched.end());
+	}
+
+	//ͬһļƥʱֻһ
+	vector<string> unique;
+	set<string> seen;
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		if (seen.insert(files[i]).second)
+			unique.push_back(files[i]);
+	}
+	return unique;
+}
+
+
+static bool makeDirectory(const string &path)
+{
+	if (path.empty() || isDirectory(path))
+		return true;
+#ifdef _WIN32
+	return _mkdir(path.c_str()) == 0;
+#else
+	return mkdir(path.c_str(), 0755) == 0;
+#endif
+}
+
+
+static uint64_t fileBytes(const string &path)
+{
+	FILE *fp = fopen(path.c_str(), "rb");
+	if (fp == NULL)
+		return 0;
+	_fseeki64(fp, 0L, SEEK_END);
+	uint64_t bytes = (uint64_t)_ftelli64(fp);
+	fclose(fp);
+	return bytes;
+}
+
+
+//һļĴ
+struct BatchFile
+{
+	string input;
+	string prefix;				//ļǰ׺
+	uint64_t bytes;
+	double seconds;
+	bool ok;
+	int start;					//ʼ˳
+	RunTotals totals;			//ģʽĺϼͳ
+};
+
+
+//ģʽһļ
+static bool processFile(BatchFile &file, const BatchOptions &options, WorkerPool *pool)
+{
+	StatsOptions stats = options.stats;
+	stats.totals = &file.totals;
+	ReadFile reader;
+	reader.setStatsOptions(stats);
+	reader.setOutputFormat(options.format);
+	reader.setWriteOptions(options.write);
+	reader.setOutputPrefix(file.prefix);
+	reader.setWorkerPool(pool, options.batchSize);
+	if (!reader.setFilename(file.input.c_str()))
+		return false;
+
+	switch (options.mode)
+	{
+	case BATCH_BLUE:
+		reader.readBlueAll();
+		break;
+	case BATCH_GREEN:
+		reader.readGreenAll();
+		break;
+	case BATCH_ALL:
+		reader.readBlueAll();
+		reader.readGreenAll();
+		break;
+	case BATCH_MIX:
+		reader.readMix();
+		break;
+	case BATCH_OUTPUT_DATA:
+		reader.outputData();
+		break;
+	case BATCH_DEEP:
+		reader.readDeep();
+		break;
+	case BATCH_DEEP_BY_RED:
+		reader.readDeepByRed();
+		break;
+	case BATCH_DEEP_OUT_LAS:
+		reader.readDeepOutLas();
+		break;
+	default:
+		return false;
+	}
+	return true;
+}
+
+
+//дһͳƺϼƵJSONֶΣţseparatorΪֶμķָ
+static void writeTotals(FILE *fp, const RunTotals &totals, const char *separator)
+{
+	fprintf(fp, "\"frames\": %llu%s\"lmIterations\": %llu%s\"rejectedShots\": %llu%s\"resyncBytes\": %llu%s",
+		(unsigned long long)totals.frames, separator, (unsigned long long)totals.iterations, separator,
+		(unsigned long long)totals.rejected, separator, (unsigned long long)totals.resyncBytes, separator);
+	fprintf(fp, "\"processSeconds\": %.6f%s\"stageSeconds\": {", totals.seconds, separator);
+	for (int i = 0; i < StageCount; i++)
+		fprintf(fp, "%s\"%s\": %.6f", i ? ", " : "", StageName(i), totals.stageNs[i] * 1e-9);
+	fprintf(fp, "}");
+}
+
+
+/*************************************************
+Function:       дͳ
+Description:	ȫļĺϼƣ֡LM׶κʱȣ͸ļĽ
+				secondsΪӵһļʼһļʱ䣬fileSecondsΪļʱ֮
+Input:          path:JSON· options:ѡ threads:߳ readers:ͬʱȡļ
+				files:ļ˳ seconds:ʱ
+Output:			Ƿдɹ
+*************************************************/
+static bool writeSummary(const string &path, const BatchOptions &options, int threads, int readers, const vector<BatchFile> &files, double seconds)
+{
+	FILE *fp = fopen(path.c_str(), "w");
+	if (fp == NULL)
+		return false;
+	uint64_t bytes = 0;
+	double fileSeconds = 0;
+	int failed = 0;
+	RunTotals totals;
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		bytes += files[i].bytes;
+		fileSeconds += files[i].seconds;
+		failed += files[i].ok ? 0 : 1;
+		totals.add(files[i].totals);
+	}
+	fprintf(fp, "{\n  \"mode\": \"%s\",\n  \"threads\": %d,\n  \"readers\": %d,\n  \"batchSize\": %d,\n",
+		BatchModeName(options.mode), threads, readers, options.batchSize);
+	fprintf(fp, "  \"files\": %d,\n  \"failed\": %d,\n  \"bytes\": %llu,\n  \"seconds\": %.6f,\n  \"fileSeconds\": %.6f,\n  \"bytesPerSecond\": %.1f,\n",
+		(int)files.size(), failed, (unsigned long long)bytes, seconds, fileSeconds, seconds > 0 ? bytes / seconds : 0.0);
+	fprintf(fp, "  ");
+	writeTotals(fp, totals, ",\n  ");
+	fprintf(fp, ",\n  \"inputs\": [");
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		const BatchFile &file = files[i];
+		fprintf(fp, "%s\n    {\"file\": \"%s\", \"prefix\": \"%s\", \"status\": \"%s\", \"start\": %d, \"bytes\": %llu, \"seconds\": %.6f,\n     ",
+			i ? "," : "", JsonEscape(file.input).c_str(), JsonEscape(file.prefix).c_str(), file.ok ? "ok" : "failed",
+			file.start, (unsigned long long)file.bytes, file.seconds);
+		writeTotals(fp, file.totals, ", ");
+		fprintf(fp, "}");
+	}
+	fprintf(fp, "\n  ]\n}\n");
+	return fclose(fp) == 0;
+}
+
+
+/*************************************************
+Function:       
+Description:	չͬһ̳߳شļÿļĽͳJSON
+				дĿ¼£ļǰ"<ļ>_"ͬʱټţ
+				ͬʱȡreadersļȡ߳ȡһļļ֡õ̳߳أ
+				ļСӴСʼֻʣһļڴȡ̵߳ȴԼ
+				һ֡ʱҲ봦̳߳Ӧٽ̡߳ӡļʱͺϼͳƣдJSON
+Input:          options:ѡ
+Output:			شʧܵļʧܻΪգ
+*************************************************/
+int RunBatch(const BatchOptions &options)
+{
+	vector<string> inputs = ExpandInputs(options.inputs);
+	if (inputs.empty())
+	{
+		printf("No input files.\n");
+		return 1;
+	}
+	if (!makeDirectory(options.outDir))
+	{
+		printf("Cannot create output directory %s.\n", options.outDir.c_str());
+		return (int)inputs.size();
+	}
+
+	angle = options.angle;
+	int count = (int)inputs.size();
+	int readers = min(options.readers, count);
+	unique_ptr<WorkerPool> pool;
+	if (options.threads != 1)
+	{
+		int total = options.threads > 0 ? options.threads : (int)thread::hardware_concurrency();
+		pool.reset(new WorkerPool(max(total - readers + 1, 1)));
+	}
+	int threads = (pool ? pool->threads() : 1) + readers - 1;
+	printf("Processing %d files in %s mode with %d threads, %d at a time.\n", count, BatchModeName(options.mode), threads, readers);
+
+	vector<BatchFile> files(inputs.size());
+	set<string> prefixes;
+	for (int i = 0; i < count; i++)
+	{
+		BatchFile &file = files[i];
+		file.input = inputs[i];
+		string stem = fileStem(file.input);
+		file.prefix = joinPath(options.outDir, stem + "_");
+		for (int n = 2; !prefixes.insert(file.prefix).second; n++)
+			file.prefix = joinPath(options.outDir, stem + "_" + to_string(n) + "_");
+		file.bytes = fileBytes(file.input);
+		file.ok = false;
+		file.seconds = 0;
+	}
+
+	//˳ͬʱȡļʱļȿʼСͬİ˳
+	vector<int> order(count);
+	for (int i = 0; i < count; i++)
+		order[i] = i;
+	if (readers > 1)
+	{
+		stable_sort(order.begin(), order.end(), [&](int a, int b) { return files[a].bytes > files[b].bytes; });
+	}
+
+	atomic<int> next(0);
+	auto readerMain = [&]()
+	{
+		for (;;)
+		{
+			int n = next.fetch_add(1);
+			if (n >= count)
+				return;
+			BatchFile &file = files[order[n]];
+			file.start = n + 1;
+			printf("\n[%d/%d] %s\n", n + 1, count, file.input.c_str());
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			file.ok = processFile(file, options, pool.get());
+			file.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+			if (readers > 1)
+				printf("[%d/%d] %s %s in %.3f s.\n", n + 1, count, file.input.c_str(), file.ok ? "done" : "failed", file.seconds);
+		}
+	};
+
+	//̨д߳Ϊļãдͳȫļӡһ
+	ResetWriterStats();
+	chrono::steady_clock::time_point batchStart = chrono::steady_clock::now();
+	vector<thread> readerThreads;
+	for (int i = 1; i < readers; i++)
+	{
+		readerThreads.push_back(thread([&]()
+		{
+			TraceThreadName("reader");
+			readerMain();
+		}));
+	}
+	readerMain();
+	for (size_t i = 0; i < readerThreads.size(); i++)
+		readerThreads[i].join();
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - batchStart).count();
+	if (options.write.background)
+		PrintWriterStats();
+
+	uint64_t bytes = 0;
+	int failed = 0;
+	RunTotals totals;
+	printf("\nBatch summary:\n");
+	for (int i = 0; i < count; i++)
+	{
+		const BatchFile &file = files[i];
+		printf("  %-40s %s %10.1f MB %9.3f s %10llu frames\n", file.input.c_str(), file.ok ? "ok    " : "failed",
+			file.bytes / 1048576.0, file.seconds, (unsigned long long)file.totals.frames);
+		bytes += file.bytes;
+		failed += file.ok ? 0 : 1;
+		totals.add(file.totals);
+	}
+	printf("%d files, %d failed, %.1f MB in %.3f s (%.1f MB/s).\n", count, failed,
+		bytes / 1048576.0, seconds, seconds > 0 ? bytes / 1048576.0 / seconds : 0.0);
+	printf("%llu frames, %llu LM iterations, %llu rejected, %llu resync bytes.\n", (unsigned long long)totals.frames,
+		(unsigned long long)totals.iterations, (unsigned long long)totals.rejected, (unsigned long long)totals.resyncBytes);
+	uint64_t stageTotal = 0;
+	for (int i = 0; i < StageCount; i++)
+		stageTotal += totals.stageNs[i];
+	for (int i = 0; i < StageCount; i++)
+	{
+		if (totals.stageNs[i] > 0)
+			printf("  %-9s %10.3f s %6.1f%%\n", StageName(i), totals.stageNs[i] * 1e-9, 100.0 * totals.stageNs[i] / stageTotal);
+	}
+
+	string summaryPath = options.summaryPath;
+	if (summaryPath.empty() && options.stats.enabled)
+		summaryPath = joinPath(options.outDir, "SurveyStats.json");
+	if (!summaryPath.empty() && !writeSummary(summaryPath, options, threads, readers, files, seconds))
+		printf("Cannot write %s.\n", summaryPath.c_str());
+	return failed;
+}
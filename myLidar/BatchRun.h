@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "ResultSink.h"
+#include "RunStats.h"
+using namespace std;
+
+
+//ģʽ뽻˵ͬ
+enum BatchMode
+{
+	BATCH_BLUE = 0,
+	BATCH_GREEN,
+	BATCH_ALL,
+	BATCH_MIX,
+	BATCH_OUTPUT_DATA,
+	BATCH_DEEP,
+	BATCH_DEEP_BY_RED,
+	BATCH_DEEP_OUT_LAS,
+	BatchModeCount
+};
+
+
+//ѡ
+struct BatchOptions
+{
+	vector<string> inputs;		//ļͨĿ¼Ŀ¼µȫļ
+	int mode;					//ģʽBatchMode-1Ϊδָ
+	float angle;				//ǣ㣩
+	int threads;				//߳0Ϊ1Ϊ֡
+	int batchSize;				//ÿд֡
+	int readers;				//ͬʱȡļ洢ã1ʱȴļ
+	OutputFormat format;		//ˮʽ
+	WriteOptions write;			//дļѡ̨дֱд̡С
+	string outDir;				//Ŀ¼ΪǰĿ¼ļǰļ
+	string summaryPath;			//ȫļĻͳJSONʱΪĿ¼µSurveyStats.json--no-statsʱд
+	string tracePath;			//Chrome traceʱߣΪ¼
+	string isa;					//ȵָΪCPUѡ
+	StatsOptions stats;			//ļͳѡ
+	bool interactive;			//ʹý˵
+
+	BatchOptions() : mode(-1), angle(0), threads(0), batchSize(256), readers(1), format(OUTPUT_TEXT), interactive(false) {}
+};
+
+
+void PrintBatchUsage();
+bool ParseBatchArgs(int argc, char *argv[], BatchOptions &options);	//Уʱӡԭ򲢷false
+const char *BatchModeName(int mode);			//ģʽbluegreenȣ
+vector<string> ExpandInputs(const vector<string> &inputs);	//չͨĿ¼ڰļ
+int RunBatch(const BatchOptions &options);		//ļһ̳߳أͬʱreadersļشʧܵļ
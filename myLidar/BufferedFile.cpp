@@ -0,0 +1,545 @@
+/*************************************************
+Description:󻺳˳дļ
+**************************************************/
+#include "BufferedFile.h"
+#include "Platform.h"
+#include "Trace.h"
+#include <string.h>
+#include <errno.h>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define StreamChunkSize 4096		//ÿδļȡõֽ
+
+typedef chrono::steady_clock WriterClock;
+
+
+static double secondsSince(WriterClock::time_point start)
+{
+	return chrono::duration<double>(WriterClock::now() - start).count();
+}
+
+
+//̨д̣߳ļдĻύ˳Ŷд̡
+//һ̨дļʱһرʱ˳
+class WriterThread
+{
+public:
+	WriterThread() : m_users(0), m_stop(false) { reset(); }
+
+	void attach();
+	void detach();
+	void submit(BufferedFile *file, int index, size_t size);
+	void wait(BufferedFile *file, int index);
+	void record(size_t size, double writeSeconds);	//¼ͬд̵߳ȴд̹̣
+	WriterStats stats();
+	void reset();
+
+private:
+	struct Job
+	{
+		BufferedFile *file;
+		int index;
+		size_t size;
+	};
+
+	void run();
+
+	mutex m_mutex;
+	condition_variable m_cond;
+	thread m_thread;
+	deque<Job> m_queue;
+	int m_users;			//̨дļ
+	bool m_stop;
+
+	WriterStats m_stats;
+	uint64_t m_depthSum;	//ύʱг֮
+	uint64_t m_submits;
+};
+
+static WriterThread writerThread;
+
+
+void WriterThread::attach()
+{
+	lock_guard<mutex> lock(m_mutex);
+	if (m_users++ == 0)
+	{
+		m_stop = false;
+		m_thread = thread(&WriterThread::run, this);
+	}
+}
+
+
+void WriterThread::detach()
+{
+	thread finished;
+	{
+		lock_guard<mutex> lock(m_mutex);
+		if (--m_users == 0)
+		{
+			m_stop = true;
+			finished.swap(m_thread);
+		}
+	}
+	m_cond.notify_all();
+	if (finished.joinable())
+	{
+		finished.join();
+	}
+}
+
+
+void WriterThread::submit(BufferedFile *file, int index, size_t size)
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		file->m_pending[index] = true;
+		m_queue.push_back({ file, index, size });
+		int depth = (int)m_queue.size();
+		TraceCounter("writerQueue", depth);
+		if (depth > m_stats.maxQueueDepth)
+		{
+			m_stats.maxQueueDepth = depth;
+		}
+		m_depthSum += depth;
+		m_submits++;
+	}
+	m_cond.notify_all();
+}
+
+
+void WriterThread::wait(BufferedFile *file, int index)
+{
+	unique_lock<mutex> lock(m_mutex);
+	if (!file->m_pending[index])
+	{
+		return;
+	}
+
+	TraceScope trace("writerStall");
+	WriterClock::time_point start = WriterClock::now();
+	m_cond.wait(lock, [file, index] { return !file->m_pending[index]; });
+	m_stats.stalls++;
+	m_stats.stallSeconds += secondsSince(start);
+}
+
+
+void WriterThread::record(size_t size, double writeSeconds)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_stats.buffers++;
+	m_stats.bytes += size;
+	m_stats.writeSeconds += writeSeconds;
+	m_stats.stalls++;
+	m_stats.stallSeconds += writeSeconds;
+}
+
+
+void WriterThread::run()
+{
+	TraceThreadName("writer");
+	unique_lock<mutex> lock(m_mutex);
+	while (true)
+	{
+		m_cond.wait(lock, [this] { return !m_queue.empty() || m_stop; });
+		if (m_queue.empty())
+		{
+			break;
+		}
+
+		Job job = m_queue.front();
+		m_queue.pop_front();
+		TraceCounter("writerQueue", (int64_t)m_queue.size());
+		lock.unlock();
+		WriterClock::time_point start = WriterClock::now();
+		{
+			TraceScope trace("writeOut");
+			job.file->writeOut(job.index, job.size);
+		}
+		double seconds = secondsSince(start);
+		lock.lock();
+
+		job.file->m_pending[job.index] = false;
+		m_stats.buffers++;
+		m_stats.bytes += job.size;
+		m_stats.writeSeconds += seconds;
+		m_cond.notify_all();
+	}
+}
+
+
+WriterStats WriterThread::stats()
+{
+	lock_guard<mutex> lock(m_mutex);
+	WriterStats s = m_stats;
+	s.meanQueueDepth = m_submits ? (double)m_depthSum / m_submits : 0;
+	return s;
+}
+
+
+void WriterThread::reset()
+{
+	lock_guard<mutex> lock(m_mutex);
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_depthSum = 0;
+	m_submits = 0;
+}
+
+
+WriterStats GetWriterStats()
+{
+	return writerThread.stats();
+}
+
+
+void ResetWriterStats()
+{
+	writerThread.reset();
+}
+
+
+void PrintWriterStats()
+{
+	WriterStats stats = GetWriterStats();
+	printf("\nWriter: %llu buffers, %.1f MB in %.3f s, queue depth mean %.2f max %d, stalled %llu times for %.3f s.\n",
+		(unsigned long long)stats.buffers, stats.bytes / 1048576.0, stats.writeSeconds,
+		stats.meanQueueDepth, stats.maxQueueDepth, (unsigned long long)stats.stalls, stats.stallSeconds);
+}
+
+
+BufferedFile::BufferedFile()
+{
+	m_file = NULL;
+	m_buffer[0] = m_buffer[1] = NULL;
+	m_capacity[0] = m_capacity[1] = 0;
+	m_active = 0;
+	m_used = 0;
+	m_error = false;
+	m_background = false;
+	m_direct = false;
+	m_pending[0] = m_pending[1] = false;
+}
+
+
+BufferedFile::~BufferedFile()
+{
+	close();
+}
+
+
+/*************************************************
+Function:       ļ
+Description:    ֱдֻLinux¿ãʧܻļϵͳ֧ʱͨʽд
+Input:          path:ļ· mode:fopenĴ򿪷ʽıļ"w"Աƽ̨з
+                options:̨дֱд̺ͻС
+Output:         Ƿ򿪳ɹ
+*************************************************/
+bool BufferedFile::open(const char *path, const char *mode, const WriteOptions &options)
+{
+	close();
+	m_file = fopen(path, mode);
+	if (m_file == NULL)
+	{
+		printf("\nFailed to open %s for writing!\n", path);
+		return false;
+	}
+	//ɱฺ𣬹رstdioĻ
+	setvbuf(m_file, NULL, _IONBF, 0);
+
+	m_direct = false;
+#ifdef __linux__
+	if (options.direct)
+	{
+		int fd = fileno(m_file);
+		int flags = fcntl(fd, F_GETFL);
+		m_direct = flags != -1 && fcntl(fd, F_SETFL, flags | O_DIRECT) == 0;
+	}
+#endif
+
+	//Сȡֽ֤дʱֱд̵Ҫ
+	size_t bufferSize = (options.bufferSize + DirectAlignment - 1) / DirectAlignment * DirectAlignment;
+	allocBuffer(0, bufferSize, 0);
+	m_active = 0;
+	m_used = 0;
+	m_error = false;
+	m_background = options.background;
+	m_pending[0] = m_pending[1] = false;
+	if (m_background)
+	{
+		allocBuffer(1, bufferSize, 0);
+		writerThread.attach();
+	}
+	return true;
+}
+
+
+void BufferedFile::allocBuffer(int index, size_t size, size_t keep)
+{
+	vector<char> storage(size + DirectAlignment);
+	uintptr_t address = (uintptr_t)storage.data();
+	char *buffer = (char *)((address + DirectAlignment - 1) / DirectAlignment * DirectAlignment);
+	if (keep > 0)
+	{
+		memcpy(buffer, m_buffer[index], keep);
+	}
+	m_storage[index].swap(storage);
+	m_buffer[index] = buffer;
+	m_capacity[index] = size;
+}
+
+
+void BufferedFile::write(const void *data, size_t size)
+{
+	char *p = reserve(size);
+	memcpy(p, data, size);
+	m_used += size;
+}
+
+
+char *BufferedFile::reserve(size_t size)
+{
+	if (m_used + size > m_capacity[m_active])
+	{
+		flushBuffer(false);
+		//д볬ʣռʱǰ̨̲߳
+		if (m_used + size > m_capacity[m_active])
+		{
+			allocBuffer(m_active, (m_used + size + DirectAlignment - 1) / DirectAlignment * DirectAlignment, m_used);
+		}
+	}
+	return m_buffer[m_active] + m_used;
+}
+
+
+void BufferedFile::flushBuffer(bool all)
+{
+	//ֱдʱֻдĲ֣볤ȵβƵһ黺ͷ
+	size_t size = m_used;
+	if (m_direct && !all)
+	{
+		size = m_used / DirectAlignment * DirectAlignment;
+	}
+	size_t tail = m_used - size;
+	if (size == 0)
+	{
+		return;
+	}
+
+	TraceScope trace("flushBuffer");
+	if (!m_background)
+	{
+		WriterClock::time_point start = WriterClock::now();
+		writeOut(m_active, size);
+		writerThread.record(size, secondsSince(start));
+		memmove(m_buffer[m_active], m_buffer[m_active] + size, tail);
+		m_used = tail;
+		return;
+	}
+
+	//ǰ齻̨̣߳תдһ飨һδдʱȴ
+	int next = m_active ^ 1;
+	writerThread.submit(this, m_active, size);
+	waitBuffer(next);
+	memcpy(m_buffer[next], m_buffer[m_active] + size, tail);
+	m_active = next;
+	m_used = tail;
+}
+
+
+void BufferedFile::waitBuffer(int index)
+{
+	if (m_background)
+	{
+		writerThread.wait(this, index);
+	}
+}
+
+
+/*************************************************
+Function:       ѻдļ
+Description:    ֱдʱȰ볤д鲿֣볤ȵβΪͨд룻
+                ļϵͳֱ֧дʱΪͨд
+Input:          index: size:ֽ
+Output:
+*************************************************/
+void BufferedFile::writeOut(int index, size_t size)
+{
+	const char *data = m_buffer[index];
+#ifdef __linux__
+	if (m_direct)
+	{
+		size_t aligned = size / DirectAlignment * DirectAlignment;
+		size_t done = 0;
+		while (done < aligned)
+		{
+			ssize_t n = ::write(fileno(m_file), data + done, aligned - done);
+			if (n <= 0)
+			{
+				if (n < 0 && errno == EINTR)
+				{
+					continue;
+				}
+				break;
+			}
+			done += n;
+		}
+		data += done;
+		size -= done;
+
+		//βҪ֮дļƫҲٶ
+		if (size > 0)
+		{
+			disableDirect();
+		}
+	}
+#endif
+	if (size > 0 && fwrite(data, 1, size, m_file) != size)
+	{
+		m_error = true;
+	}
+}
+
+
+void BufferedFile::disableDirect()
+{
+#ifdef __linux__
+	if (m_direct)
+	{
+		int fd = fileno(m_file);
+		int flags = fcntl(fd, F_GETFL);
+		if (flags != -1)
+		{
+			fcntl(fd, F_SETFL, flags & ~O_DIRECT);
+		}
+		m_direct = false;
+	}
+#endif
+}
+
+
+/*************************************************
+Function:       дд
+Description:    деݣٶλoffsetд룬֮صļβ˳д
+Input:          offset:ļƫ data: size:ֽ
+Output:         Ƿдɹ
+*************************************************/
+bool BufferedFile::rewrite(uint64_t offset, const void *data, size_t size)
+{
+	if (m_file == NULL)
+	{
+		return false;
+	}
+
+	flushBuffer(true);
+	waitBuffer(0);
+	waitBuffer(1);
+	disableDirect();
+	bool ok = _fseeki64(m_file, offset, SEEK_SET) == 0
+		&& fwrite(data, 1, size, m_file) == size
+		&& _fseeki64(m_file, 0, SEEK_END) == 0;
+	if (!ok)
+	{
+		m_error = true;
+	}
+	return ok;
+}
+
+
+bool BufferedFile::close()
+{
+	if (m_file == NULL)
+	{
+		return !m_error;
+	}
+
+	flushBuffer(true);
+	if (m_background)
+	{
+		waitBuffer(0);
+		waitBuffer(1);
+		writerThread.detach();
+		m_background = false;
+	}
+
+	if (fclose(m_file) != 0)
+	{
+		m_error = true;
+	}
+	m_file = NULL;
+	m_direct = false;
+	return !m_error;
+}
+
+
+void BufferedStreamBuf::release()
+{
+	if (pbase() != NULL)
+	{
+		m_file.commit(pptr() - pbase());
+	}
+	setp(NULL, NULL);
+}
+
+
+BufferedStreamBuf::int_type BufferedStreamBuf::overflow(int_type ch)
+{
+	release();
+	if (!m_file.isOpen())
+	{
+		return traits_type::eof();
+	}
+
+	char *p = m_file.reserve(StreamChunkSize);
+	setp(p, p + StreamChunkSize);
+	if (!traits_type::eq_int_type(ch, traits_type::eof()))
+	{
+		*pptr() = traits_type::to_char_type(ch);
+		pbump(1);
+	}
+	return traits_type::not_eof(ch);
+}
+
+
+int BufferedStreamBuf::sync()
+{
+	release();
+	return 0;
+}
+
+
+BufferedOStream::BufferedOStream() : ostream(NULL), m_streamBuf(m_file)
+{
+	rdbuf(&m_streamBuf);
+}
+
+
+BufferedOStream::~BufferedOStream()
+{
+	close();
+}
+
+
+bool BufferedOStream::open(const char *path, const WriteOptions &options)
+{
+	bool ok = m_file.open(path, "w", options);
+	if (!ok)
+	{
+		setstate(ios::failbit);
+	}
+	return ok;
+}
+
+
+bool BufferedOStream::close()
+{
+	m_streamBuf.release();
+	return m_file.close();
+}
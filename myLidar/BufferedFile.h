@@ -0,0 +1,114 @@
+#ifndef BufferedFile_H
+#define BufferedFile_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <atomic>
+#include <ostream>
+using namespace std;
+
+
+#define DefaultWriteBufferSize (4 << 20)	//ĬдС4MB
+#define DirectAlignment 4096				//ֱдʱַд볤ȵĶֽ
+
+
+//дļѡ
+struct WriteOptions
+{
+	bool background;		//дĻ̨д߳д
+	bool direct;			//ƹϵͳֱд̣Linux O_DIRECT֧ʱԶΪͨд룩
+	size_t bufferSize;		//ÿ黺С
+
+	WriteOptions() : background(false), direct(false), bufferSize(DefaultWriteBufferSize) {}
+};
+
+
+//дͳƣļϼƣ
+struct WriterStats
+{
+	uint64_t buffers;			//дĻ
+	uint64_t bytes;				//дֽ
+	double writeSeconds;		//д̺ʱ
+	uint64_t stalls;			//̵߳ȴд̵Ĵ
+	double stallSeconds;		//̵߳ȴд̵ʱ
+	int maxQueueDepth;			//̨де󳤶
+	double meanQueueDepth;		//ύʱеƽ
+};
+
+WriterStats GetWriterStats();	//ȡдͳ
+void ResetWriterStats();		//дͳ
+void PrintWriterStats();		//ӡдͳƣ̨дĶгȡ̵߳ȴд̵ʱ䣩
+
+
+//󻺳˳дļдڴ滺ʱд
+//̨дʱÿļʹ黺дһ齻ļõĺ̨д̣߳
+//̼߳дһ飬ֻ鶼δдʱŵȴ
+class BufferedFile
+{
+public:
+	BufferedFile();
+	~BufferedFile();
+
+	bool open(const char *path, const char *mode = "wb", const WriteOptions &options = WriteOptions());
+	bool isOpen() const { return m_file != NULL; }
+	void write(const void *data, size_t size);	//д
+	char *reserve(size_t size);					//֤ʣռ䲻sizeдλ
+	void commit(size_t size) { m_used += size; }	//ȷreserve֮ʵдֽ
+	bool rewrite(uint64_t offset, const void *data, size_t size);	//ддݣļͷеͳ
+	bool close();								//дʣݲرգǷȫдɹ
+
+private:
+	friend class WriterThread;
+
+	void flushBuffer(bool all);					//дǰֱдʱallΪfalseֻд벿֣
+	void waitBuffer(int index);					//ȴ̨߳дָ
+	void writeOut(int index, size_t size);		//ѻдļ
+	void allocBuffer(int index, size_t size, size_t keep);	//Ҫ仺ǰkeepֽ
+	void disableDirect();						//Ϊͨд
+
+	FILE *m_file;
+	vector<char> m_storage[2];					//ڴ棨ֻں̨дʱʹõڶ飩
+	char *m_buffer[2];							//Ļʼλ
+	size_t m_capacity[2];						//
+	int m_active;								//ǰдĻ
+	size_t m_used;								//ǰֽ
+	atomic<bool> m_error;						//Ƿд
+	bool m_background;							//Ƿ̨д
+	atomic<bool> m_direct;						//Ƿֱд̣д߳ڲ֧ʱΪͨд룩
+	bool m_pending[2];							//Ƿں̨дУд̵߳
+};
+
+
+//BufferedFileΪײ壺ʽֱдļsyncendlд
+class BufferedStreamBuf : public streambuf
+{
+public:
+	BufferedStreamBuf(BufferedFile &file) : m_file(file) {}
+	void release();								//ȷдַ
+
+protected:
+	int_type overflow(int_type ch);
+	int sync();
+
+private:
+	BufferedFile &m_file;
+};
+
+
+//BufferedFileΪײ÷fstreamͬ
+class BufferedOStream : public ostream
+{
+public:
+	BufferedOStream();
+	~BufferedOStream();
+	bool open(const char *path, const WriteOptions &options = WriteOptions());	//ıʽ
+	bool close();
+
+private:
+	BufferedFile m_file;
+	BufferedStreamBuf m_streamBuf;
+};
+
+
+#endif
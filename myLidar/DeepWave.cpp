@@ -4,6 +4,8 @@ Date:2019-01-02
 Description:ˮˮ
 **************************************************/
 #include "DeepWave.h"
+#include "Trace.h"
+#include "SimdKernels.h"
 #include <numeric>
 #include <algorithm>
 
@@ -11,6 +13,7 @@ Description:
 #define MaxPulseIntensity 800
 #define MinPulseWidth 1
 #define MaxPulseWidth 20
+#define DeepPeakReserve 64	//ֵԤĸ
 
 #define TimeDifference 8	//UTCʱ
 
@@ -26,7 +29,7 @@ Description:
 
 extern float angle;
 
-bool DeepWave::ostreamFlag = BLUE;
+thread_local bool DeepWave::ostreamFlag = BLUE;
 
 
 //ƽ
@@ -231,7 +234,7 @@ float calculateDeepSigma(const vector<float> &resultSet)
 	double mean = sum / resultSet.size(); //ֵ  
 
 	double accum = 0.0;
-	for each (float d in resultSet)
+	for (float d : resultSet)
 	{
 		accum += (d - mean)*(d - mean);
 	}
@@ -242,160 +245,247 @@ float calculateDeepSigma(const vector<float> &resultSet)
 }
 
 
+//βڵۼӺֻͣǰ
+struct TailSum
+{
+	int len;		//ڳȣĩβ
+	double sum;		//ݺ
+	double sumSq;	//ƽ
+
+	void extend(const float *wave, int n, int newLen)
+	{
+		for (; len < newLen; len++)
+		{
+			double d = wave[n - 1 - len];
+			sum += d;
+			sumSq += d * d;
+		}
+	}
+};
+
+
+//ۼӺͼ׼calculateDeepSigmaһ£ʱNaN
+static float sigmaFromSums(double sum, double sumSq, int count)
+{
+	if (count < 2)
+	{
+		return NAN;
+	}
+	double accum = sumSq - sum * sum / count;
+	if (accum < 0)
+	{
+		accum = 0;
+	}
+	return (float)sqrt(accum / (count - 1));
+}
+
+
 /*************************************************
-Function:       ֵ㷨
-Description:    https://www.mathworks.com/help/signal/ref/findpeaks.html
-Input:          飬СͻС
-Output:         ֵλ
+Function:       ˮβ޳ĳ
+Description:    ɺǰѰҼСֵ㣬Ƚ [L,KK)  [KK,end) ݵı׼
+                ׼ֻβۼӺʹһα
+                begin|______k__KK__|end
+                begin|_____L___KK__|end
+Input:          wave:ͨԭʼ n:ݳ
+Output:         ֵΪβ޳ݸ
 *************************************************/
-vector<int> FindLocalMaxima(vector<float> dataVector, int minProminence, int maxProminence, int minWidth, int maxWidth)
+int DeepTrimLength(const float *wave, int n)
 {
-	int dataVectorSize = dataVector.size();
-	vector<int>localMaximaIndex, localMaximaValue, prominenceValue, inRangeLocalMaxima;
-	int j;
-	int currentValue, nextValue, prevValue;
-	int totalLocalMaxima;
-	int prevLocalMaximaIndex;
-	int nextLocalMaximaIndex;
-	int prevHigherLocalMaximaValue;
-	int nextHigherLocalMaximaValue;
-	int leftWidth, rightWidth, width;
-	int prevMinimum, nextMinimum, minimumValue;
-	int prominence;
-	int i = 1;
-	/********************* FIND LOCAL MAXIMA ***************************/
-	while (i<dataVectorSize-1)
-	{
-		j = 1;
-		currentValue = dataVector[i];
-		prevValue = dataVector[i - 1];
-		nextValue = dataVector[i + j];
+	int k = 60, kk = 50, l = 60;//Ȥ˵
+	TailSum tailKK = { 0, 0, 0 };	//ĩβkk
+	TailSum tailL = { 0, 0, 0 };	//ĩβl
 
-		if ((prevValue<currentValue) && (currentValue >= nextValue))
+	//ǰȡ
+	for (int i = 60; i < n - 60; i++)
+	{
+		if (wave[n - (i - 1)] > wave[n - i] && wave[n - i] < wave[n - (i + 1)])
 		{
-			while ((currentValue == nextValue) && ((i + j)<dataVectorSize-1))
+			k = i;
+			int j = i + 6;/**/
+			if (j < n - 66 && wave[n - (j - 1)] < wave[n - j] && wave[n - j] > wave[n - (j + 1)])
 			{
-				j++;
-				nextValue = dataVector[i + j];
+				l = j;
 			}
-			if (currentValue>nextValue)
+			if (l > k)
 			{
-				localMaximaIndex.push_back(i);
-				localMaximaValue.push_back(currentValue);
+				tailKK.extend(wave, n, kk);
+				tailL.extend(wave, n, l);
+				float Sv1 = sigmaFromSums(tailKK.sum, tailKK.sumSq, kk);
+				float Sv2 = sigmaFromSums(tailL.sum - tailKK.sum, tailL.sumSq - tailKK.sumSq, l - kk);
+				kk = k;
+				if (Sv2 > 2 * Sv1)//ֵ
+				{
+					break;
+				}
 			}
 		}
-		i += j;
 	}
 
-	totalLocalMaxima = localMaximaIndex.size();
-	prominenceValue.erase(prominenceValue.begin(), prominenceValue.end());
+	return kk < n ? kk : n;
+}
 
-	/********************* GET PROMINENCE ***************************/
-	for (i = 0; i<totalLocalMaxima; i++)
+
+/*************************************************
+Function:       Ļλ
+Description:    ջɨ裺ջֻȵǰߵķ弰һջԪ֮Сֵλã
+                ڵǰԪزϲֵһɨõÿһĻ
+Input:          data: n:ݳ peakIndex:ֵλ fromLeft:trueΪףfalseΪһ stack:õջռ
+Output:         baseIndex:ÿӦһСֵλ
+*************************************************/
+static void getPeakBase(const float *data, int n, const vector<int> &peakIndex, bool fromLeft, vector<int> &baseIndex, vector<PeakWorkspace::StackItem> &stack)
+{
+	stack.clear();
+	int peakCount = (int)peakIndex.size();
+	baseIndex.resize(peakCount);
+
+	int cursor = fromLeft ? 0 : n - 1;	//δСֵһλ
+	int step = fromLeft ? 1 : -1;
+	for (int t = 0; t < peakCount; t++)
 	{
-		prevLocalMaximaIndex = i - 1;
-		nextLocalMaximaIndex = i + 1;
-		prevHigherLocalMaximaValue = 0;
-		nextHigherLocalMaximaValue = 0;
+		int k = fromLeft ? t : peakCount - 1 - t;
+		int p = peakIndex[k];
 
-		if (prevLocalMaximaIndex >= 0)
+		//һ뱾֮Сֵ
+		int v = cursor;
+		for (; cursor != p; cursor += step)
 		{
-			while ((prevLocalMaximaIndex >= 1) && (localMaximaValue[prevLocalMaximaIndex] <= localMaximaValue[i]))
-			{
-				prevLocalMaximaIndex--;
-			}
-			if (localMaximaValue[prevLocalMaximaIndex]>localMaximaValue[i]) {
-				prevHigherLocalMaximaValue = localMaximaValue[prevLocalMaximaIndex];
-			}
-			else {
-				prevHigherLocalMaximaValue = 0;
-			}
+			if (data[cursor] < data[v])
+				v = cursor;
 		}
-		if (nextLocalMaximaIndex<totalLocalMaxima)
+		cursor = p + step;
+
+		//ڱķ岻ɱ߽磬ϲֵ
+		while (!stack.empty() && stack.back().height <= data[p])
+		{
+			if (data[stack.back().valley] < data[v])
+				v = stack.back().valley;
+			stack.pop_back();
+		}
+		baseIndex[k] = v;
+		stack.push_back({ data[p], v });
+	}
+}
+
+
+/*************************************************
+Function:       ֵ㷨
+Description:    https://www.mathworks.com/help/signal/ref/findpeaks.html
+                findpeaksһ£ƽȡ˵㣬˵㲻Ϊ壻ͻһнϸΪο
+                ΪͻȴԲֵõĿȡɵջֹͣʱ
+Input:          data: n:ݳȣСͻС
+Output:         ֵλ
+*************************************************/
+vector<int> FindLocalMaxima(const float *data, int n, float minProminence, float maxProminence, float minWidth, float maxWidth)
+{
+	PeakWorkspace ws;
+	vector<int> peaks;
+	FindLocalMaxima(data, n, minProminence, maxProminence, minWidth, maxWidth, ws, peaks);
+	return peaks;
+}
+
+
+/*************************************************
+Function:       ֵ㷨м飩
+Description:    ͬϣмд÷ṩظʱڴ
+Input:          data: n:ݳȣСͻС ws:м
+Output:         peaks:ֵλ
+*************************************************/
+void FindLocalMaxima(const float *data, int n, float minProminence, float maxProminence, float minWidth, float maxWidth, PeakWorkspace &ws, vector<int> &peaks)
+{
+	vector<int> &localMaximaIndex = ws.localMaxima;
+	vector<int> &leftBase = ws.leftBase;
+	vector<int> &rightBase = ws.rightBase;
+	vector<int> &inRangeLocalMaxima = peaks;
+	localMaximaIndex.clear();
+	inRangeLocalMaxima.clear();
+
+	//ݳԤݳȲʱظòڴ
+	ws.reserve(n);
+	inRangeLocalMaxima.reserve(n / 2 + 1);
+
+	/********************* FIND LOCAL MAXIMA ***************************/
+	int i = 1;
+	while (i < n - 1)
+	{
+		if (data[i - 1] < data[i])
 		{
-			while ((nextLocalMaximaIndex<totalLocalMaxima - 1) && (localMaximaValue[nextLocalMaximaIndex] <= localMaximaValue[i]))//
+			//ƽȵ
+			int j = i + 1;
+			while (j < n && data[j] == data[i])
 			{
-				nextLocalMaximaIndex++;
-			}
-			if (localMaximaValue[nextLocalMaximaIndex]>localMaximaValue[i]) {
-				nextHigherLocalMaximaValue = localMaximaValue[nextLocalMaximaIndex];
+				j++;
 			}
-			else {
-				nextHigherLocalMaximaValue = 0;
+			if (j < n && data[j] < data[i])
+			{
+				localMaximaIndex.push_back(i);
 			}
+			i = j;
 		}
-		prevMinimum = dataVector[localMaximaIndex[i]];
-		nextMinimum = dataVector[localMaximaIndex[i]];
-		minimumValue = dataVector[localMaximaIndex[i]];
-		if ((prevHigherLocalMaximaValue == 0) && (nextHigherLocalMaximaValue == 0))
+		else
 		{
-			for (j = 0; j<dataVectorSize; j++)
-			{
-				if (dataVector[j]<minimumValue)
-					minimumValue = dataVector[j];
-			}
+			i++;
+		}
+	}
 
+	/********************* GET PROMINENCE ***************************/
+	getPeakBase(data, n, localMaximaIndex, true, leftBase, ws.stack);
+	getPeakBase(data, n, localMaximaIndex, false, rightBase, ws.stack);
 
-		}
-		else
+	for (int k = 0; k < (int)localMaximaIndex.size(); k++)
+	{
+		int p = localMaximaIndex[k];
+		float baseValue = data[leftBase[k]] > data[rightBase[k]] ? data[leftBase[k]] : data[rightBase[k]];
+		float prominence = data[p] - baseValue;
+		if (prominence < minProminence || prominence > maxProminence)
 		{
-			if (prevLocalMaximaIndex<0)
-			{
-				for (j = localMaximaIndex[i]; j >= 0; j--)
-				{
-					if (dataVector[j]<prevMinimum)
-						prevMinimum = dataVector[j];
-				}
+			continue;
+		}
 
-			}
-			else
-			{
-				for (j = localMaximaIndex[i]; j>localMaximaValue[prevLocalMaximaIndex]; j--)
-				{
-					if (dataVector[j]<prevMinimum)
-						prevMinimum = dataVector[j];
-				}
+		/*************************** GET WIDTH ********************************/
+		float refHeight = data[p] - prominence / 2;
+		bool tooWide = false;
 
-			}
-			if (nextLocalMaximaIndex >= totalLocalMaxima - 1)
+		//ཻ
+		int j = p;
+		while (j >= leftBase[k] && data[j] > refHeight)
+		{
+			if (p - j > maxWidth)
 			{
-				for (j = localMaximaIndex[i]; j<dataVectorSize; j++)
-				{
-					if (dataVector[j]<nextMinimum)
-						nextMinimum = dataVector[j];
-				}
-
+				tooWide = true;
+				break;
 			}
-			else
-			{
-				for (j = localMaximaIndex[i]; j<localMaximaIndex[nextLocalMaximaIndex]; j++)
-				{
-					if (dataVector[j]<nextMinimum)
-						nextMinimum = dataVector[j];
-				}
+			j--;
+		}
+		if (tooWide)
+		{
+			continue;
+		}
+		float xLeft = (j < leftBase[k]) ? (float)leftBase[k] : j + (refHeight - data[j]) / (data[j + 1] - data[j]);
 
+		//Ҳཻ
+		j = p;
+		while (j <= rightBase[k] && data[j] > refHeight)
+		{
+			if (j - p > maxWidth)
+			{
+				tooWide = true;
+				break;
 			}
-			minimumValue = prevMinimum>nextMinimum ? prevMinimum : nextMinimum;
+			j++;
 		}
-		prominence = localMaximaValue[i] - minimumValue;
-		/*************************** GET WIDTH ********************************/
-		j = 1;
-		while (((localMaximaIndex[i] - j)>0) && (dataVector[localMaximaIndex[i] - j] - minimumValue>(prominence) / 2)) { j++; }
-		leftWidth = j;
-		j = 1;
-		while (((localMaximaIndex[i] + j)<dataVectorSize) && (dataVector[localMaximaIndex[i] + j] - minimumValue>(prominence) / 2)) { j++; }
-		rightWidth = j;
-		width = leftWidth + rightWidth;
+		if (tooWide)
+		{
+			continue;
+		}
+		float xRight = (j > rightBase[k]) ? (float)rightBase[k] : j - (refHeight - data[j]) / (data[j - 1] - data[j]);
 
 		/********************* IS THE PEAK IN RANGE? ***************************/
-		if ((localMaximaValue[i] - minimumValue >= minProminence) && (localMaximaValue[i] - minimumValue <= maxProminence) && (width >= minWidth) && (width <= maxWidth))
+		float width = xRight - xLeft;
+		if (width >= minWidth && width <= maxWidth)
 		{
-			inRangeLocalMaxima.push_back(localMaximaIndex[i]);
+			inRangeLocalMaxima.push_back(p);
 		}
-
 	}
-
-	return inRangeLocalMaxima;
 }
 
 
@@ -425,18 +515,8 @@ Output:
 *************************************************/
 void deep_jacexpfun2(double *p, double *jac, int m, int n, void *data)
 {
-	register int i, j;
-	//дſ˱Ⱦ
-	for (i = j = 0; i<n; ++i)
-	{
-		jac[j++] = exp(-(i - p[1])*(i - p[1]) / (2 * p[2])*p[2]);
-		jac[j++] = p[0] * (i - p[1]) / (p[2] * p[2])*exp(-(i - p[1])*(i - p[1]) / (2 * p[2] * p[2]));
-		jac[j++] = p[0] * (i - p[1])*(i - p[1]) / (p[2] * p[2] * p[2])*exp(-(i - p[1])*(i - p[1]) / (2 * p[2] * p[2]));
-
-		jac[j++] = exp(-(i - p[4])*(i - p[4]) / (2 * p[5])*p[5]);
-		jac[j++] = p[3] * (i - p[4]) / (p[5] * p[5])*exp(-(i - p[4])*(i - p[4]) / (2 * p[5] * p[5]));
-		jac[j++] = p[3] * (i - p[4])*(i - p[4]) / (p[5] * p[5] * p[5])*exp(-(i - p[4])*(i - p[4]) / (2 * p[5] * p[5]));
-	}
+	//ǳˮ˹ģͬCPUֵָ֧ѡʵ
+	Kernels().gaussJacobian(p, 2, jac, n);
 }
 
 
@@ -445,11 +525,18 @@ void deep_jacexpfun2(double *p, double *jac, int m, int n, void *data)
 DeepWave::DeepWave()
 {
 	m_time = { 0,0,0,0,0,0 };
+	m_unixTime = 0;
 	m_BlueDeepNoise = 0;
 	m_GreenDeepNoise = 0;
 	blueDeepDepth = 0;
 	greenDeepDepth = 0;
 	redTime = 0;
+	waterTime = 0;
+	InitGPSDayCache(&m_DayCache);
+
+	//ֵԤͨʹʱҲ֡
+	m_BlueDeepPra.reserve(DeepPeakReserve);
+	m_GreenDeepPra.reserve(DeepPeakReserve);
 }
 
 
@@ -458,6 +545,30 @@ DeepWave::~DeepWave()
 }
 
 
+/*************************************************
+Function:       λ
+Description:    ָΪչʱ״̬ͬһ֡ʱÿ֡ʼ
+Input:          
+Output:         
+*************************************************/
+void DeepWave::Reset()
+{
+	m_time = { 0,0,0,0,0,0 };
+	m_unixTime = 0;
+	m_RedDeep.clear();
+	m_BlueDeep.clear();
+	m_GreenDeep.clear();
+	m_BlueDeepNoise = 0;
+	m_GreenDeepNoise = 0;
+	m_BlueDeepPra.clear();
+	m_GreenDeepPra.clear();
+	blueDeepDepth = 0;
+	greenDeepDepth = 0;
+	redTime = 0;
+	waterTime = 0;
+}
+
+
 /*************************************************
 Function:       ȡԭʼǳˮͨĶλز
 Description:    
@@ -466,21 +577,16 @@ Output:
 *************************************************/
 void DeepWave::GetDeepData(HS_Lidar & hs)
 {
-	//GPS->UTC->BeiJing
-	PGPSTIME pgt = new GPSTIME;
-	PCOMMONTIME pct = new COMMONTIME;
-	pgt->wn = (int)hs.header.nGPSWeek;
-	pgt->tow.sn = (long)hs.header.dGPSSecond;
-	pgt->tow.tos = 0;
-	GPSTimeToCommonTime(pgt, pct);
-	m_time.year = pct->year;
-	m_time.month = pct->month;
-	m_time.day = pct->day;
-	m_time.hour = pct->hour + TimeDifference;	//ֱתΪʱ
-	m_time.minute = pct->minute;
-	m_time.second = pct->second;
-	delete pgt;
-	delete pct;
+	//GPS->UTC->BeiJingͬһGPSڵֻ֡
+	COMMONTIME ct;
+	GPSTimeToCommonTimeCached((int)hs.header.nGPSWeek, hs.header.dGPSSecond, &m_DayCache, &ct);
+	m_time.year = ct.year;
+	m_time.month = ct.month;
+	m_time.day = ct.day;
+	m_time.hour = ct.hour + TimeDifference;	//ֱתΪʱ
+	m_time.minute = ct.minute;
+	m_time.second = (int)ct.second;
+	GPSTimeToUnixNs(&hs.header.nGPSWeek, &hs.header.dGPSSecond, &m_unixTime, 1);
 
 	//ȡ⡢ͨˮ
 	vector<int >::iterator it;//
@@ -496,6 +602,15 @@ void DeepWave::GetDeepData(HS_Lidar & hs)
 	{
 		m_GreenDeep.push_back((float)*it);
 	}
+
+	//˲ֵĻ޳ǰĳԤЧ֡仯ʱ
+	size_t deepLength = max(m_BlueDeep.size(), m_GreenDeep.size());
+	m_FilterBuffer1.reserve(deepLength);
+	m_FilterBuffer2.reserve(deepLength);
+	m_FilterBuffer3.reserve(deepLength);
+	m_ResolveBuffer.reserve(deepLength);
+	m_PeakWorkspace.reserve((int)deepLength);
+	m_Peaks.reserve(deepLength / 2 + 1);
 }
 
 
@@ -507,84 +622,35 @@ Output:         
 *************************************************/
 void DeepWave::DeepFilter(vector<float> &srcWave, float &noise)
 {
-	//ЧݵĽȡ¼뼫Сֵݱ׼ı仯
-	//begin|______k__KK__|end
-	//begin|_____L___KK__|end
-	int k = 60, kk = 50, l = 60;//Ȥ˵
-
-	//ǰȡ
-	for (unsigned int i = 60; i < srcWave.size() - 60; i++)
-	{
-		if (srcWave.at(srcWave.size() - (i - 1)) > srcWave.at(srcWave.size() - i) && srcWave.at(srcWave.size() - i) < srcWave.at(srcWave.size() - (i + 1)))
-		{
-			k = i;
-			for (unsigned int j = i + 6/**/; j < srcWave.size() - 66; j++)
-			{
-				if (srcWave.at(srcWave.size() - (j - 1)) < srcWave.at(srcWave.size() - j) && srcWave.at(srcWave.size() - j) > srcWave.at(srcWave.size() - (j + 1)))
-					l = j;
-				break;
-			}
-			if (l > k)
-			{
-				vector<float> v1(srcWave.end() - kk, srcWave.end());
-				vector<float> v2(srcWave.end() - l, srcWave.end()-kk);
-				kk = k; 
-				float Sv1 = calculateDeepSigma(v1);
-				float Sv2 = calculateDeepSigma(v2);
-				if (Sv2 > 2 * Sv1)//ֵ
-				{
-					break;
-				}
-					
-			}
-		}
-	}
+	TraceScope trace("DeepFilter");
 
-	//߳޳
-	srcWave.erase(srcWave.end() - kk, srcWave.end());
+	//߳޳ֻЧȣerase
+	int len = (int)srcWave.size() - DeepTrimLength(srcWave.data(), (int)srcWave.size());
 
 
 	//˹˲ȥ
-	vector<float> dstWave;
-	dstWave.assign(srcWave.begin(), srcWave.end());
-	
-	//ڴ
-	float *buffer = new float[dstWave.size()];
-	if (!dstWave.empty()) 
-	{ 
-		memcpy(buffer, &dstWave[0], dstWave.size() * sizeof(float));
-	}
-	float *buffer1 = new float[dstWave.size()];
-	float *buffer2 = new float[dstWave.size()];
-	float *buffer3 = new float[dstWave.size()];
+	//óԱʱڴ
+	m_FilterBuffer1.resize(len);
+	m_FilterBuffer2.resize(len);
+	m_FilterBuffer3.resize(len);
+	float *buffer1 = m_FilterBuffer1.data();
+	float *buffer2 = m_FilterBuffer2.data();
+	float *buffer3 = m_FilterBuffer3.data();
 
 	//˲
-	linearSmooth5(buffer, buffer1, dstWave.size());
-	quadraticSmooth5(buffer1, buffer2, dstWave.size());
-	cubicSmooth5(buffer2, buffer3, dstWave.size());
-
-	dstWave.assign(&buffer3[0], &buffer3[dstWave.size()]);
-
-
-	//ͷڴ
-	delete []buffer; 
-	buffer = nullptr;
-	delete []buffer1; 
-	buffer1 = nullptr;
-	delete []buffer2; 
-	buffer2 = nullptr;
-	delete []buffer3; 
-	buffer3 = nullptr;
+	linearSmooth5(srcWave.data(), buffer1, len);
+	quadraticSmooth5(buffer1, buffer2, len);
+	cubicSmooth5(buffer2, buffer3, len);
 
 	noise = 0;
 	//:˲ǰĲݵķֵľ׼
-	for (unsigned int i = 0; i < srcWave.size(); i++)
+	for (int i = 0; i < len; i++)
 	{
-		noise += (srcWave.at(i) - dstWave.at(i)) * (srcWave.at(i) - dstWave.at(i));
+		noise += (srcWave[i] - buffer3[i]) * (srcWave[i] - buffer3[i]);
 	}
-	noise = sqrt(noise / srcWave.size());
+	noise = sqrt(noise / len);
 
-	srcWave.assign(dstWave.begin(), dstWave.end());
+	srcWave.assign(&buffer3[0], &buffer3[len]);
 }
 
 
@@ -596,8 +662,10 @@ Output:         
 *************************************************/
 void DeepWave::DeepResolve(vector<float> &srcWave, vector<float> &waveParam, float &noise)
 {
+	TraceScope trace("DeepResolve");
+
 	//ԭʼ
-	vector<float> data,temp;
+	vector<float> &data = m_ResolveBuffer;
 	data.assign(srcWave.begin(), srcWave.end());
 
 	//˲СֵΪ
@@ -611,10 +679,10 @@ void DeepWave::DeepResolve(vector<float> &srcWave, vector<float> &waveParam, flo
 	}
 
 	//Ѱҷֵ
-	vector<int>answer = FindLocalMaxima(data, MinPulseIntensity, MaxPulseIntensity, MinPulseWidth, MaxPulseWidth);//ֵ
+	FindLocalMaxima(data.data(), (int)data.size(), MinPulseIntensity, MaxPulseIntensity, MinPulseWidth, MaxPulseWidth, m_PeakWorkspace, m_Peaks);//ֵ
 
 	//ֵ
-	for (auto ans : answer)
+	for (auto ans : m_Peaks)
 	{
 		waveParam.push_back((float)ans);
 	}
@@ -635,16 +703,19 @@ void DeepWave::DeepOptimize(vector<float> &srcWave, vector<float> &waveParam)
 
 /*************************************************
 Function:       ȡͨˮʱ
-Description:    ֱӶԽͨзֵ⣬ȡֵǰʱ̱׼Ϊֵοֵ
+Description:    ֱӶԽͨзֵ⣬ȡֵǰʱ̱׼Ϊֵοֵ
+                ûзֵʱΪ0˵㲻Ϊ壬Чˮ㲻Ϊ0
 Input:          
 Output:         
 *************************************************/
 void DeepWave::GetRedTime(vector<float>& srcWave, int & redtime)
 {
+	TraceScope trace("GetRedTime");
+
 	//Ѱҷֵ
-	vector<int>answer = FindLocalMaxima(srcWave, 3, 800, 1, 20);//ֵ
+	FindLocalMaxima(srcWave.data(), (int)srcWave.size(), 3, 800, 1, 20, m_PeakWorkspace, m_Peaks);//ֵ
 
-	redtime = *min_element(answer.begin(), answer.end());
+	redtime = m_Peaks.empty() ? 0 : *min_element(m_Peaks.begin(), m_Peaks.end());
 }
 
 
@@ -656,9 +727,10 @@ Output:
 *************************************************/
 void DeepWave::CalcuDeepDepthByRed(vector<float>& waveParam, int & redtime, float & BorGDepth)
 {
-	if ((waveParam.size() <= 1) || (waveParam.size() >= 5))
+	if ((waveParam.size() <= 1) || (waveParam.size() >= 5) || (redtime == 0))	//ûнˮʱ޳
 	{
 		BorGDepth = 0;
+		waterTime = 0;
 	}
 	else
 	{
@@ -666,6 +738,7 @@ void DeepWave::CalcuDeepDepthByRed(vector<float>& waveParam, int & redtime, floa
 		float tend = *max_element(waveParam.begin(), waveParam.end());
 
 		BorGDepth = c*(tend - tbegin) / (2 * ndeepwater);
+		waterTime = tend - tbegin;
 	}
 }
 
@@ -681,6 +754,7 @@ void DeepWave::CalcuDeepDepth(vector<float>& waveParam, float &BorGDepth)
 	if ((waveParam.size() <= 1) || (waveParam.size() >= 5))
 	{
 		BorGDepth = 0;
+		waterTime = 0;
 	}
 	else
 	{
@@ -689,6 +763,7 @@ void DeepWave::CalcuDeepDepth(vector<float>& waveParam, float &BorGDepth)
 
 		//BorGDepth = c*(tend - tbegin) / (2 * ndeepwater);
 		BorGDepth = (c*(tend - tbegin) *cos(asin(sin(angle) / ndeepwater))) / (2 * ndeepwater);
+		waterTime = tend - tbegin;
 	}
 }
 
@@ -11,20 +11,53 @@ using namespace std;
 //ݵı׼
 float calculateDeepSigma(const vector<float> &resultSet);
 
+//ˮβ޳ĳ
+int DeepTrimLength(const float *wave, int n);
+
+//ֵм飬ظʱ
+struct PeakWorkspace
+{
+	struct StackItem
+	{
+		float height;	//ֵ
+		int valley;		//һջԪ֮Сֵλ
+	};
+	vector<int> localMaxima;		//ȫֲֵλ
+	vector<int> leftBase;			//
+	vector<int> rightBase;			//һ
+	vector<StackItem> stack;		//׵ĵջ
+
+	//Ϊnмֵn/2Ԥ
+	void reserve(int n)
+	{
+		size_t maxCount = n / 2 + 1;
+		localMaxima.reserve(maxCount);
+		leftBase.reserve(maxCount);
+		rightBase.reserve(maxCount);
+		stack.reserve(maxCount);
+	}
+};
+
+//ֵ⣨findpeaks壩
+vector<int> FindLocalMaxima(const float *data, int n, float minProminence, float maxProminence, float minWidth, float maxWidth);
+void FindLocalMaxima(const float *data, int n, float minProminence, float maxProminence, float minWidth, float maxWidth, PeakWorkspace &ws, vector<int> &peaks);
+
 //ˮ
 class DeepWave
 {
 public:
 	DeepWave();
 	~DeepWave();
+	void Reset();															//λݹ֡
 	void GetDeepData(HS_Lidar &hs);											//ȡˮ
 	void DeepFilter(vector<float> &srcWave, float &noise);					//˲ƽ
 	void DeepResolve(vector<float> &srcWave, vector<float> &waveParam, float &noise);	//ֽ
 	void DeepOptimize(vector<float> &srcWave, vector<float> &waveParam);	//ŻLM
 
-	static bool ostreamFlag;												//Ȥͨ
+	static thread_local bool ostreamFlag;									//Ȥͨݣ̷ֱ߳ã
 	friend ostream &operator<<(ostream &stream, const DeepWave &deepwave);	//ԶϢ
 	Time m_time;									//UTCʱ
+	int64_t m_unixTime;								//UTCʱ䣨UnixԪ
 
 	vector<float> m_RedDeep;						//CH1ͨˮ
 	vector<float> m_BlueDeep;						//CH2ͨˮ
@@ -34,11 +67,21 @@ public:
 	vector<float> m_BlueDeepPra;					//CH2ݷֵ
 	vector<float> m_GreenDeepPra;					//CH3ݷֵ
 
-	int redTime;									//ͨˮ
+	int redTime;									//ͨˮ㣬0Ϊû
 	void GetRedTime(vector<float> &srcWave, int &redtime);//ȡͨˮʱ
 	void CalcuDeepDepthByRed(vector<float> &waveParam, int &redtime, float &BorGDepth);	//ݽͨˮͨˮ׼ˮ
 
 	float blueDeepDepth;							//CH2ͨļˮ
 	float greenDeepDepth;							//CH3ͨļˮ
+	float waterTime;								//һμˮõˮ浽ˮʱns
 	void CalcuDeepDepth(vector<float> &waveParam, float &BorGDepth);	//ݻزݼˮ
+
+private:
+	vector<float> m_FilterBuffer1;					//ƽĻ
+	vector<float> m_FilterBuffer2;
+	vector<float> m_FilterBuffer3;
+	vector<float> m_ResolveBuffer;					//ֵǰȥ
+	vector<int> m_Peaks;							//ֵ
+	PeakWorkspace m_PeakWorkspace;					//ֵм
+	GPSDAYCACHE m_DayCache;							//GPSջ棨Resetʱ
 };
\ No newline at end of file
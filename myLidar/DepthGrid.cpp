@@ -0,0 +1,596 @@
+/*************************************************
+Description:ʽˮ
+**************************************************/
+#include "DepthGrid.h"
+#include "Platform.h"
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <limits>
+#include <algorithm>
+
+#define GridBands 4							//ΣƽСˮ͵
+
+#define TiffAscii 2
+#define TiffShort 3
+#define TiffLong 4
+#define TiffDouble 12
+#define TiffLong8 16
+
+
+//ѸͳתΪĲֵݵĸˮΪNaNΪ0
+static void convertCells(const GridCell *cells, size_t count, float *out)
+{
+	const float nan = numeric_limits<float>::quiet_NaN();
+	for (size_t i = 0; i < count; i++, out += GridBands)
+	{
+		if (cells == NULL || cells[i].count == 0)
+		{
+			out[0] = out[1] = out[2] = nan;
+			out[3] = 0;
+		}
+		else
+		{
+			out[0] = cells[i].mean;
+			out[1] = cells[i].min;
+			out[2] = cells[i].max;
+			out[3] = (float)cells[i].count;
+		}
+	}
+}
+
+
+DepthGrid::DepthGrid()
+{
+	m_open = false;
+	m_tileCells = 0;
+	m_maxResident = 0;
+	m_spill = NULL;
+	m_spillSlots = 0;
+	m_spillError = false;
+	m_lastX = m_lastY = 0;
+	m_lastCells = NULL;
+	m_points = m_pageOuts = m_pageIns = 0;
+	m_minTileX = m_maxTileX = m_minTileY = m_maxTileY = 0;
+	m_width = m_height = 0;
+}
+
+
+DepthGrid::~DepthGrid()
+{
+	close();
+}
+
+
+/*************************************************
+Function:       ʼɸ
+Description:    ֿ߳ȡΪ16ıڴ޼㳣פֿ
+                ʱļڵһλֿʱ
+Input:          baseName:ļչ options:ѡ writeOptions:дļѡ
+Output:         ǷЧ
+*************************************************/
+bool DepthGrid::open(const char *baseName, const GridOptions &options, const WriteOptions &writeOptions)
+{
+	close();
+	if (options.format == GRID_NONE || !(options.cellSize > 0))
+	{
+		return false;
+	}
+
+	m_options = options;
+	m_options.tileSize = max(16, (options.tileSize + 15) / 16 * 16);
+	m_writeOptions = writeOptions;
+	m_baseName = baseName;
+	m_spillPath = m_baseName + ".tiles";
+	m_tileCells = (size_t)m_options.tileSize * m_options.tileSize;
+	m_maxResident = max((size_t)1, options.memoryLimit / (m_tileCells * sizeof(GridCell)));
+
+	m_spillSlots = 0;
+	m_spillError = false;
+	m_lastCells = NULL;
+	m_points = m_pageOuts = m_pageIns = 0;
+	m_width = m_height = 0;
+	m_open = true;
+	return true;
+}
+
+
+/*************************************************
+Function:       ۼһˮ
+Description:    ȡڸƽСˮ͵
+Input:          x:Ȼ y:γȻ depth:ˮ
+Output:
+*************************************************/
+void DepthGrid::add(double x, double y, float depth)
+{
+	if (!m_open || !isfinite(x) || !isfinite(y) || !isfinite(depth))
+	{
+		return;
+	}
+
+	int64_t size = m_options.tileSize;
+	int64_t cellX = (int64_t)floor(x / m_options.cellSize);
+	int64_t cellY = (int64_t)floor(y / m_options.cellSize);
+	int64_t tileX = floorDiv(cellX, size);
+	int64_t tileY = floorDiv(cellY, size);
+
+	//ֿڵһΪ
+	GridCell *cells = tileCells(tileX, tileY);
+	GridCell &cell = cells[(size - 1 - (cellY - tileY * size)) * size + (cellX - tileX * size)];
+
+	cell.count++;
+	cell.mean += (depth - cell.mean) / cell.count;
+	if (depth < cell.min) cell.min = depth;
+	if (depth > cell.max) cell.max = depth;
+	m_points++;
+}
+
+
+/*************************************************
+Function:       ȡֿ
+Description:    һηʵķֿͬʱֱӷأ
+                ·ֿʼΪݣѻķֿʱļ
+Input:          tileX/tileY:ֿ
+Output:         ֿ
+*************************************************/
+GridCell *DepthGrid::tileCells(int64_t tileX, int64_t tileY)
+{
+	if (m_lastCells != NULL && tileX == m_lastX && tileY == m_lastY)
+	{
+		return m_lastCells;
+	}
+
+	TileKey key = { tileX, tileY };
+	auto it = m_tiles.find(key);
+	if (it == m_tiles.end())
+	{
+		it = m_tiles.emplace(key, Tile()).first;
+		Tile &tile = it->second;
+		tile.slot = -1;
+		acquireCells(tile.cells);
+		GridCell empty = { 0, FLT_MAX, -FLT_MAX, 0 };
+		fill(tile.cells.begin(), tile.cells.end(), empty);
+		m_lru.push_front(key);
+		tile.lruPos = m_lru.begin();
+	}
+	else if (it->second.cells.empty())
+	{
+		Tile &tile = it->second;
+		acquireCells(tile.cells);
+		size_t bytes = m_tileCells * sizeof(GridCell);
+		if (_fseeki64(m_spill, tile.slot * (int64_t)bytes, SEEK_SET) != 0
+			|| fread(tile.cells.data(), 1, bytes, m_spill) != bytes)
+		{
+			m_spillError = true;
+		}
+		m_pageIns++;
+		m_lru.push_front(key);
+		tile.lruPos = m_lru.begin();
+	}
+	else
+	{
+		m_lru.splice(m_lru.begin(), m_lru, it->second.lruPos);
+	}
+
+	m_lastX = tileX;
+	m_lastY = tileY;
+	m_lastCells = it->second.cells.data();
+	return m_lastCells;
+}
+
+
+/*************************************************
+Function:       ȡһֿڴ
+Description:    פֿδʱ·䣬򻻳δõķֿ鲢ӹڴ
+Input:          cells:յķֿ
+Output:         cells:СΪһķֿݣδʼ
+*************************************************/
+void DepthGrid::acquireCells(vector<GridCell> &cells)
+{
+	if (m_lru.size() < m_maxResident)
+	{
+		cells.resize(m_tileCells);
+		return;
+	}
+
+	Tile &victim = m_tiles.find(m_lru.back())->second;
+	pageOut(victim);
+	m_lru.pop_back();
+	if (m_lastCells == victim.cells.data())
+	{
+		m_lastCells = NULL;
+	}
+	cells.swap(victim.cells);
+}
+
+
+void DepthGrid::pageOut(Tile &tile)
+{
+	if (m_spill == NULL)
+	{
+		m_spill = fopen(m_spillPath.c_str(), "w+b");
+		if (m_spill == NULL)
+		{
+			m_spillError = true;
+			return;
+		}
+	}
+	if (tile.slot < 0)
+	{
+		tile.slot = m_spillSlots++;
+	}
+
+	size_t bytes = m_tileCells * sizeof(GridCell);
+	if (_fseeki64(m_spill, tile.slot * (int64_t)bytes, SEEK_SET) != 0
+		|| fwrite(tile.cells.data(), 1, bytes, m_spill) != bytes)
+	{
+		m_spillError = true;
+	}
+	m_pageOuts++;
+}
+
+
+/*************************************************
+Function:       ֿ
+Description:    פֱֿӷڴеݣѻķֻֿʱļȡУ
+                ڴ棬дʱбҲᷴ뻻
+Input:          tile:ֿ firstRow:ʼ rows: scratch:ȡ
+Output:         и
+*************************************************/
+const GridCell *DepthGrid::readRows(const Tile &tile, int firstRow, int rows, vector<GridCell> &scratch)
+{
+	size_t size = m_options.tileSize;
+	if (!tile.cells.empty())
+	{
+		return &tile.cells[firstRow * size];
+	}
+
+	size_t count = rows * size;
+	scratch.resize(count);
+	int64_t offset = tile.slot * (int64_t)(m_tileCells * sizeof(GridCell)) + firstRow * size * sizeof(GridCell);
+	if (m_spill == NULL || _fseeki64(m_spill, offset, SEEK_SET) != 0
+		|| fread(scratch.data(), sizeof(GridCell), count, m_spill) != count)
+	{
+		GridCell empty = { 0, FLT_MAX, -FLT_MAX, 0 };
+		fill(scratch.begin(), scratch.end(), empty);
+		m_spillError = true;
+	}
+	return scratch.data();
+}
+
+
+void DepthGrid::computeExtent()
+{
+	bool first = true;
+	for (auto &item : m_tiles)
+	{
+		const TileKey &key = item.first;
+		if (first || key.x < m_minTileX) m_minTileX = key.x;
+		if (first || key.x > m_maxTileX) m_maxTileX = key.x;
+		if (first || key.y < m_minTileY) m_minTileY = key.y;
+		if (first || key.y > m_maxTileY) m_maxTileY = key.y;
+		first = false;
+	}
+
+	m_width = first ? 0 : (m_maxTileX - m_minTileX + 1) * m_options.tileSize;
+	m_height = first ? 0 : (m_maxTileY - m_minTileY + 1) * m_options.tileSize;
+}
+
+
+/*************************************************
+Function:       ɸ
+Description:    дļɾʱļ
+Input:
+Output:         Ƿȫдɹûеʱдļ
+*************************************************/
+bool DepthGrid::close()
+{
+	if (!m_open)
+	{
+		return true;
+	}
+
+	computeExtent();
+	bool ok = true;
+	if (!m_tiles.empty())
+	{
+		ok = (m_options.format == GRID_RAW) ? writeRaw() : writeGeoTiff();
+	}
+	ok = ok && !m_spillError;
+
+	if (m_spill != NULL)
+	{
+		fclose(m_spill);
+		m_spill = NULL;
+		remove(m_spillPath.c_str());
+	}
+	m_tiles.clear();
+	m_lru.clear();
+	m_lastCells = NULL;
+	m_open = false;
+	return ok;
+}
+
+
+//TIFFĿ¼
+struct TiffEntry
+{
+	uint16_t tag;
+	uint16_t type;
+	uint64_t count;
+	vector<uint8_t> data;		//ֵСˣ
+
+	TiffEntry(uint16_t entryTag, uint16_t entryType, uint64_t entryCount) : tag(entryTag), type(entryType), count(entryCount) {}
+};
+
+
+template<class T>
+static void appendValue(vector<uint8_t> &out, T value)
+{
+	const uint8_t *p = (const uint8_t *)&value;
+	out.insert(out.end(), p, p + sizeof(T));
+}
+
+
+template<class T>
+static TiffEntry tiffEntry(uint16_t tag, uint16_t type, const vector<T> &values)
+{
+	TiffEntry entry(tag, type, values.size());
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		appendValue(entry.data, values[i]);
+	}
+	return entry;
+}
+
+
+static TiffEntry tiffAscii(uint16_t tag, const string &text)
+{
+	TiffEntry entry(tag, TiffAscii, text.size() + 1);
+	entry.data.assign(text.begin(), text.end());
+	entry.data.push_back(0);
+	return entry;
+}
+
+
+/*************************************************
+Function:       TIFFĿ¼
+Description:    Ŀ¼ǩ򣬷ŲĿ¼ֵδĿ¼֮󣨰żֽڶ룩
+Input:          entries:Ŀ¼ ifdOffset:Ŀ¼ļеƫ big:ǷΪBigTIFF
+Output:         out:Ŀ¼ֵ
+*************************************************/
+static void buildIfd(vector<TiffEntry> &entries, uint64_t ifdOffset, bool big, vector<uint8_t> &out)
+{
+	sort(entries.begin(), entries.end(), [](const TiffEntry &a, const TiffEntry &b) { return a.tag < b.tag; });
+
+	size_t valueSize = big ? 8 : 4;
+	uint64_t extraOffset = ifdOffset + (big ? 8 : 2) + entries.size() * (big ? 20 : 12) + valueSize;
+	vector<uint8_t> extra;
+
+	big ? appendValue<uint64_t>(out, entries.size()) : appendValue<uint16_t>(out, (uint16_t)entries.size());
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		const TiffEntry &entry = entries[i];
+		appendValue(out, entry.tag);
+		appendValue(out, entry.type);
+		big ? appendValue<uint64_t>(out, entry.count) : appendValue<uint32_t>(out, (uint32_t)entry.count);
+		if (entry.data.size() <= valueSize)
+		{
+			out.insert(out.end(), entry.data.begin(), entry.data.end());
+			out.insert(out.end(), valueSize - entry.data.size(), 0);
+		}
+		else
+		{
+			uint64_t offset = extraOffset + extra.size();
+			big ? appendValue<uint64_t>(out, offset) : appendValue<uint32_t>(out, (uint32_t)offset);
+			extra.insert(extra.end(), entry.data.begin(), entry.data.end());
+			if (extra.size() & 1)
+			{
+				extra.push_back(0);
+			}
+		}
+	}
+	out.insert(out.end(), valueSize, 0);		//ûһĿ¼
+	out.insert(out.end(), extra.begin(), extra.end());
+}
+
+
+/*************************************************
+Function:       дGeoTIFF
+Description:    GeoTIFFķֿֿһ£ǿշֿ鰴˳д
+                շֿƫƺͳΪ0GDALݶȡ432λ㲨ΰԪš
+                Ŀ¼дڷֿ֮ļͷеĿ¼ƫдļ4GBʱдΪBigTIFF
+Input:
+Output:         Ƿȫдɹ
+*************************************************/
+bool DepthGrid::writeGeoTiff()
+{
+	BufferedFile file;
+	string path = m_baseName + ".tif";
+	if (!file.open(path.c_str(), "wb", m_writeOptions))
+	{
+		return false;
+	}
+
+	int64_t size = m_options.tileSize;
+	int64_t across = m_width / size;
+	int64_t down = m_height / size;
+	size_t tileBytes = m_tileCells * GridBands * sizeof(float);
+	uint64_t estimate = 16 + m_tiles.size() * (uint64_t)tileBytes + across * down * 16 + 4096;
+	bool big = estimate > 0xFFFFFFFFULL;
+
+	uint8_t header[16] = { 'I', 'I' };
+	header[2] = big ? 43 : 42;
+	header[4] = big ? 8 : 0;
+	size_t headerSize = big ? 16 : 8;
+	file.write(header, headerSize);
+	uint64_t offset = headerSize;
+
+	vector<uint64_t> offsets(across * down, 0);
+	vector<uint64_t> counts(across * down, 0);
+	vector<GridCell> scratch;
+	for (int64_t row = 0; row < down; row++)
+	{
+		for (int64_t col = 0; col < across; col++)
+		{
+			TileKey key = { m_minTileX + col, m_maxTileY - row };
+			auto it = m_tiles.find(key);
+			if (it == m_tiles.end())
+			{
+				continue;
+			}
+
+			const GridCell *cells = readRows(it->second, 0, (int)size, scratch);
+			convertCells(cells, m_tileCells, (float *)file.reserve(tileBytes));
+			file.commit(tileBytes);
+			offsets[row * across + col] = offset;
+			counts[row * across + col] = tileBytes;
+			offset += tileBytes;
+		}
+	}
+
+	//ԪСϽ
+	double originX = m_minTileX * size * m_options.cellSize;
+	double originY = (m_maxTileY + 1) * size * m_options.cellSize;
+	vector<double> pixelScale = { m_options.cellSize, m_options.cellSize, 0 };
+	vector<double> tiePoint = { 0, 0, 0, originX, originY, 0 };
+
+	//EPSG 4xxxΪϵఴͶӰϵδ֪ϵʱֻдԪ
+	bool geographic = m_options.epsg >= 4000 && m_options.epsg < 5000;
+	vector<uint16_t> geoKeys = { 1, 1, 0, 1, 1025, 0, 1, 1 };		//GTRasterTypeGeoKeyԪΪ
+	if (m_options.epsg > 0)
+	{
+		geoKeys[3] = 3;
+		geoKeys.insert(geoKeys.begin() + 4, { 1024, 0, 1, (uint16_t)(geographic ? 2 : 1) });	//GTModelTypeGeoKey
+		geoKeys.insert(geoKeys.end(), { (uint16_t)(geographic ? 2048 : 3072), 0, 1, (uint16_t)m_options.epsg });
+	}
+
+	vector<TiffEntry> entries;
+	entries.push_back(tiffEntry<uint32_t>(256, TiffLong, { (uint32_t)m_width }));
+	entries.push_back(tiffEntry<uint32_t>(257, TiffLong, { (uint32_t)m_height }));
+	entries.push_back(tiffEntry<uint16_t>(258, TiffShort, { 32, 32, 32, 32 }));
+	entries.push_back(tiffEntry<uint16_t>(259, TiffShort, { 1 }));		//ѹ
+	entries.push_back(tiffEntry<uint16_t>(262, TiffShort, { 1 }));		//Ҷ
+	entries.push_back(tiffEntry<uint16_t>(277, TiffShort, { GridBands }));
+	entries.push_back(tiffEntry<uint16_t>(284, TiffShort, { 1 }));		//Ԫ
+	entries.push_back(tiffEntry<uint32_t>(322, TiffLong, { (uint32_t)size }));
+	entries.push_back(tiffEntry<uint32_t>(323, TiffLong, { (uint32_t)size }));
+	if (big)
+	{
+		entries.push_back(tiffEntry<uint64_t>(324, TiffLong8, offsets));
+		entries.push_back(tiffEntry<uint64_t>(325, TiffLong8, counts));
+	}
+	else
+	{
+		entries.push_back(tiffEntry<uint32_t>(324, TiffLong, vector<uint32_t>(offsets.begin(), offsets.end())));
+		entries.push_back(tiffEntry<uint32_t>(325, TiffLong, vector<uint32_t>(counts.begin(), counts.end())));
+	}
+	entries.push_back(tiffEntry<uint16_t>(338, TiffShort, { 0, 0, 0 }));
+	entries.push_back(tiffEntry<uint16_t>(339, TiffShort, { 3, 3, 3, 3 }));	//
+	entries.push_back(tiffEntry<double>(33550, TiffDouble, pixelScale));
+	entries.push_back(tiffEntry<double>(33922, TiffDouble, tiePoint));
+	entries.push_back(tiffEntry<uint16_t>(34735, TiffShort, geoKeys));
+	entries.push_back(tiffAscii(42112, "<GDALMetadata>"
+		"<Item name=\"DESCRIPTION\" sample=\"0\" role=\"description\">mean</Item>"
+		"<Item name=\"DESCRIPTION\" sample=\"1\" role=\"description\">min</Item>"
+		"<Item name=\"DESCRIPTION\" sample=\"2\" role=\"description\">max</Item>"
+		"<Item name=\"DESCRIPTION\" sample=\"3\" role=\"description\">count</Item>"
+		"</GDALMetadata>"));
+	entries.push_back(tiffAscii(42113, "nan"));		//GDALֵ
+
+	vector<uint8_t> ifd;
+	buildIfd(entries, offset, big, ifd);
+	file.write(ifd.data(), ifd.size());
+
+	if (big)
+	{
+		file.rewrite(8, &offset, sizeof(uint64_t));
+	}
+	else
+	{
+		uint32_t offset32 = (uint32_t)offset;
+		file.rewrite(4, &offset32, sizeof(uint32_t));
+	}
+	return file.close();
+}
+
+
+/*************************************************
+Function:       дԭʼENVIıͷ
+Description:    дӱдÿԪΪ432λ㲨ΣBIP
+                ȡֿĶӦУڴֻһзֿ
+Input:
+Output:         Ƿȫдɹ
+*************************************************/
+bool DepthGrid::writeRaw()
+{
+	BufferedFile file;
+	string path = m_baseName + ".raw";
+	if (!file.open(path.c_str(), "wb", m_writeOptions))
+	{
+		return false;
+	}
+
+	int64_t size = m_options.tileSize;
+	int64_t across = m_width / size;
+	int64_t down = m_height / size;
+	size_t rowBytes = size * GridBands * sizeof(float);
+	vector<const Tile *> rowTiles(across);
+	vector<GridCell> scratch;
+	for (int64_t tileRow = 0; tileRow < down; tileRow++)
+	{
+		for (int64_t col = 0; col < across; col++)
+		{
+			TileKey key = { m_minTileX + col, m_maxTileY - tileRow };
+			auto it = m_tiles.find(key);
+			rowTiles[col] = (it == m_tiles.end()) ? NULL : &it->second;
+		}
+
+		for (int row = 0; row < size; row++)
+		{
+			for (int64_t col = 0; col < across; col++)
+			{
+				const GridCell *cells = rowTiles[col] ? readRows(*rowTiles[col], row, 1, scratch) : NULL;
+				convertCells(cells, size, (float *)file.reserve(rowBytes));
+				file.commit(rowBytes);
+			}
+		}
+	}
+	bool ok = file.close();
+
+	path = m_baseName + ".hdr";
+	FILE *hdr = fopen(path.c_str(), "w");
+	if (hdr == NULL)
+	{
+		return false;
+	}
+
+	double originX = m_minTileX * size * m_options.cellSize;
+	double originY = (m_maxTileY + 1) * size * m_options.cellSize;
+	fprintf(hdr, "ENVI\n");
+	fprintf(hdr, "description = {myLidar depth grid}\n");
+	fprintf(hdr, "samples = %lld\n", (long long)m_width);
+	fprintf(hdr, "lines = %lld\n", (long long)m_height);
+	fprintf(hdr, "bands = %d\n", GridBands);
+	fprintf(hdr, "header offset = 0\n");
+	fprintf(hdr, "file type = ENVI Standard\n");
+	fprintf(hdr, "data type = 4\n");
+	fprintf(hdr, "interleave = bip\n");
+	fprintf(hdr, "byte order = 0\n");
+	fprintf(hdr, "band names = {mean, min, max, count}\n");
+
+	//ENVIĲοԪ(1,1)ΪϽԪϽ
+	int epsg = m_options.epsg;
+	if (epsg == 4326)
+	{
+		fprintf(hdr, "map info = {Geographic Lat/Lon, 1, 1, %.10f, %.10f, %.10g, %.10g, WGS-84, units=Degrees}\n",
+			originX, originY, m_options.cellSize, m_options.cellSize);
+	}
+	else if ((epsg > 32600 && epsg <= 32660) || (epsg > 32700 && epsg <= 32760))
+	{
+		fprintf(hdr, "map info = {UTM, 1, 1, %.10f, %.10f, %.10g, %.10g, %d, %s, WGS-84, units=Meters}\n",
+			originX, originY, m_options.cellSize, m_options.cellSize, epsg % 100, epsg < 32700 ? "North" : "South");
+	}
+	ok = (fclose(hdr) == 0) && ok;
+	return ok;
+}
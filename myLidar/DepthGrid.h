@@ -0,0 +1,129 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include "BufferedFile.h"
+using namespace std;
+
+
+#define DefaultGridCellSize 1.0				//ĬϸࣨmUTM
+#define DefaultGridTileSize 256				//ĬϷֿ߳GeoTIFFҪΪ16ı
+#define DefaultGridMemoryLimit (256 << 20)	//Ĭϳפڴķֽֿ
+
+
+//ʽ
+enum GridFormat
+{
+	GRID_NONE,			//
+	GRID_GEOTIFF,		//ֿGeoTIFF4GBʱΪBigTIFF
+	GRID_RAW			//ԪŵԭʼݼENVIıͷ
+};
+
+
+//ѡ
+struct GridOptions
+{
+	GridFormat format;
+	double cellSize;		//ࣨ굥λͬ
+	int tileSize;			//ֿ߳
+	size_t memoryLimit;		//פڴķֽֿʱδõķֿ黻
+	int epsg;				//ϵEPSG룺4326ΪWGS84γȣ326xx/327xxΪUTM/ϰ0ΪԴ
+
+	GridOptions() : format(GRID_GEOTIFF), cellSize(DefaultGridCellSize), tileSize(DefaultGridTileSize),
+		memoryLimit(DefaultGridMemoryLimit), epsg(0) {}
+};
+
+
+//ԪˮͳʱΪһΣתΪ㣩
+struct GridCell
+{
+	float mean;				//ƽˮµĻƽ
+	float min;
+	float max;
+	uint32_t count;			//øĵ
+};
+
+
+//ʽˮˮۼӵڸֻֿ֯ʹõķֿ鳣פڴ棬
+//໻ʱļ˲Сڴơرʱֿ鷶Χһдļ
+//դһΪˣYµݼ
+class DepthGrid
+{
+public:
+	DepthGrid();
+	~DepthGrid();
+
+	//baseName:ļչGeoTIFFΪbaseName.tifԭʼʽΪbaseName.rawbaseName.hdr
+	bool open(const char *baseName, const GridOptions &options, const WriteOptions &writeOptions = WriteOptions());
+	void add(double x, double y, float depth);	//ۼһ㣨xΪ򾭶ȣyΪγȣ
+	bool close();								//дļɾʱļǷȫдɹ
+	void setEpsg(int epsg) { m_options.epsg = epsg; }	//ϵرǰЧ
+
+	bool isOpen() const { return m_open; }
+	uint64_t pointCount() const { return m_points; }
+	uint64_t tileCount() const { return m_tiles.size(); }
+	uint64_t pageOuts() const { return m_pageOuts; }	//ֿ黻
+	uint64_t pageIns() const { return m_pageIns; }		//ֿ黻
+	int64_t width() const { return m_width; }			//դرպЧ
+	int64_t height() const { return m_height; }			//դرպЧ
+
+private:
+	struct TileKey
+	{
+		int64_t x;
+		int64_t y;
+		bool operator==(const TileKey &other) const { return x == other.x && y == other.y; }
+	};
+
+	struct TileKeyHash
+	{
+		size_t operator()(const TileKey &key) const
+		{
+			return (size_t)(key.x * 0x9E3779B97F4A7C15ULL ^ (key.y + 0x632BE59BD9B4E019ULL));
+		}
+	};
+
+	struct Tile
+	{
+		vector<GridCell> cells;			//פʱĸݣΪ
+		int64_t slot;					//ʱļеλãδΪ-1
+		list<TileKey>::iterator lruPos;	//ʹеλãפʱЧ
+	};
+
+	GridCell *tileCells(int64_t tileX, int64_t tileY);	//ȡֿݣڴʱ½
+	void acquireCells(vector<GridCell> &cells);		//ȡһֿڴ棬ﵽʱδõķֿ
+	void pageOut(Tile &tile);						//ѷֿдʱļ
+	const GridCell *readRows(const Tile &tile, int firstRow, int rows, vector<GridCell> &scratch);	//ֿ
+	void computeExtent();							//ɷֿ鷶ΧդС
+	bool writeGeoTiff();
+	bool writeRaw();
+
+	bool m_open;
+	string m_baseName;
+	GridOptions m_options;
+	WriteOptions m_writeOptions;
+	size_t m_tileCells;					//ÿ
+	size_t m_maxResident;				//פڴķֿ
+
+	unordered_map<TileKey, Tile, TileKeyHash> m_tiles;
+	list<TileKey> m_lru;				//פֿ飬ʹõǰ
+	FILE *m_spill;						//ֿʱļ
+	string m_spillPath;
+	int64_t m_spillSlots;				//ʱļѷķֿ
+	bool m_spillError;
+
+	//һηʵķֿ飨ڵĵͨͬһֿ飩
+	int64_t m_lastX;
+	int64_t m_lastY;
+	GridCell *m_lastCells;
+
+	uint64_t m_points;
+	uint64_t m_pageOuts;
+	uint64_t m_pageIns;
+
+	//դΧֿţ
+	int64_t m_minTileX, m_maxTileX, m_minTileY, m_maxTileY;
+	int64_t m_width, m_height;
+};
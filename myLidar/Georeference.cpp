@@ -0,0 +1,209 @@
+/*************************************************
+Description:ˮ׵λ
+**************************************************/
+#include "Georeference.h"
+#include <math.h>
+#include <limits>
+
+#define GeoPi 3.14159265358979323846
+#define GeoDegToRad (GeoPi / 180)
+#define WGS84A 6378137.0				//WGS84ᣨm
+#define WGS84E2 6.69437999014e-3		//WGS84һƫƽ
+#define GeoMinBeamDown 1.0e-3			//ֱޣˮƽ
+
+
+/*************************************************
+Function:       
+Description:    ˮˮƽƫΪˮƽԸ߶/ֱˮйˮƽ
+                Ϊˮƽʣ˹ɣֱΪsqrt(1-(1-D^2)/n^2)
+                ˮбΪc*t/(2n)εˮƽƫƺϲΪˮƽͬһ
+Input:          beamD:ֱ height:GPS waterTime:˫ʱ surface:ˮ invIndex:ʵ
+Output:         scale:ˮƽƫԹˮƽı bottomHeight:ˮ depth:ֱˮ
+*************************************************/
+static void RefractKernel(size_t n, const double *__restrict beamD, const double *__restrict height,
+	const double *__restrict waterTime, double surface, double invIndex,
+	double *__restrict scale, float *__restrict bottomHeight, float *__restrict depth)
+{
+	const double invIndex2 = invIndex * invIndex;
+	const double rangeScale = GeoLightSpeed * 0.5 * invIndex;
+	for (size_t i = 0; i < n; i++)
+	{
+		double down = beamD[i] < GeoMinBeamDown ? GeoMinBeamDown : beamD[i];
+		double slant = rangeScale * waterTime[i];
+		double vertical = slant * sqrt(1 - (1 - down * down) * invIndex2);
+		scale[i] = (height[i] - surface) / down + slant * invIndex;
+		bottomHeight[i] = (float)(surface - vertical);
+		depth[i] = (float)vertical;
+	}
+}
+
+
+//ˮƽƫƻΪγout = origin + beam * scale * degPerMetre
+static void OffsetKernel(size_t n, const double *__restrict origin, const double *__restrict beam,
+	const double *__restrict scale, const double *__restrict degPerMetre, double *__restrict out)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		out[i] = origin[i] + beam[i] * scale[i] * degPerMetre[i];
+	}
+}
+
+
+GeoOptions::GeoOptions()
+{
+	scanAngle = numeric_limits<double>::quiet_NaN();
+	boresightRoll = 0;
+	boresightPitch = 0;
+	boresightHeading = 0;
+	surfaceHeight = 0;
+	refractiveIndex = GeoWaterIndex;
+	utmZone = 0;
+}
+
+
+void GeoBatch::reserve(size_t n)
+{
+	lat.reserve(n);
+	lon.reserve(n);
+	height.reserve(n);
+	heading.reserve(n);
+	pitch.reserve(n);
+	roll.reserve(n);
+	scanAzimuth.reserve(n);
+	waterTime.reserve(n);
+	gpsTime.reserve(n);
+}
+
+
+//룬
+void GeoBatch::clear()
+{
+	lat.clear();
+	lon.clear();
+	height.clear();
+	heading.clear();
+	pitch.clear();
+	roll.clear();
+	scanAzimuth.clear();
+	waterTime.clear();
+	gpsTime.clear();
+}
+
+
+/*************************************************
+Function:       һ
+Description:    λЧʱ̶ɨ跽λǣɨ跽λΪ0ǰ
+Input:          header:֡ͷ waterTime:ˮ浽ˮ׵˫ʱ䣨ns
+Output:
+*************************************************/
+void GeoBatch::push(const HS_Lidar_Header &header, double waterTime)
+{
+	lat.push_back(header.dX);
+	lon.push_back(header.dY);
+	height.push_back(header.dZ);
+	heading.push_back(header.dAzimuth);
+	pitch.push_back(header.dPitch);
+	roll.push_back(header.dRoll);
+
+	double azimuth = 0;
+	if (header.nCodeDiscResolution > 0 && header.nCodeDiscResolution < 32)
+	{
+		azimuth = header.nCodeNumber * 360.0 / (double)(1u << header.nCodeDiscResolution);
+	}
+	scanAzimuth.push_back(azimuth);
+
+	this->waterTime.push_back(waterTime);
+	gpsTime.push_back(header.nGPSWeek * 604800.0 + header.dGPSSecond);
+}
+
+
+Georeferencer::Georeferencer(const GeoOptions &options)
+{
+	m_options = options;
+	m_sinScan = sin(options.scanAngle * GeoDegToRad);
+	m_cosScan = cos(options.scanAngle * GeoDegToRad);
+	m_zoneChosen = false;
+}
+
+
+int Georeferencer::epsg() const
+{
+	if (!projected())
+	{
+		return 4326;
+	}
+	return m_zoneChosen ? m_projection.epsg() : 0;
+}
+
+
+/*************************************************
+Function:       λ
+Description:    һ֡㣺ϵǰ£Ϊ(sincos, sinsin, cos)
+                λתϵγȼȦîȦʰ뾶
+                ڶ;γȻ㣬ѭֻͿ
+Input:          batch:
+Output:         batch:ˮ׵㾭γȡUTMꡢߺʹֱˮ
+*************************************************/
+void Georeferencer::run(GeoBatch &batch)
+{
+	size_t n = batch.size();
+	m_beamN.resize(n);
+	m_beamE.resize(n);
+	m_beamD.resize(n);
+	m_degPerNorth.resize(n);
+	m_degPerEast.resize(n);
+	m_scale.resize(n);
+	batch.bottomLat.resize(n);
+	batch.bottomLon.resize(n);
+	batch.bottomHeight.resize(n);
+	batch.depth.resize(n);
+
+	//֡Ǻ
+	for (size_t i = 0; i < n; i++)
+	{
+		double roll = (batch.roll[i] + m_options.boresightRoll) * GeoDegToRad;
+		double pitch = (batch.pitch[i] + m_options.boresightPitch) * GeoDegToRad;
+		double heading = (batch.heading[i] + m_options.boresightHeading) * GeoDegToRad;
+		double azimuth = batch.scanAzimuth[i] * GeoDegToRad;
+		double sr = sin(roll), cr = cos(roll);
+		double sp = sin(pitch), cp = cos(pitch);
+		double sh = sin(heading), ch = cos(heading);
+
+		double bx = m_sinScan * cos(azimuth);
+		double by = m_sinScan * sin(azimuth);
+		double bz = m_cosScan;
+
+		//R = Rz(heading) * Ry(pitch) * Rx(roll)
+		m_beamN[i] = ch * cp * bx + (ch * sp * sr - sh * cr) * by + (ch * sp * cr + sh * sr) * bz;
+		m_beamE[i] = sh * cp * bx + (sh * sp * sr + ch * cr) * by + (sh * sp * cr - ch * sr) * bz;
+		m_beamD[i] = -sp * bx + cp * sr * by + cp * cr * bz;
+
+		double sinLat = sin(batch.lat[i] * GeoDegToRad);
+		double cosLat = cos(batch.lat[i] * GeoDegToRad);
+		double w = 1 - WGS84E2 * sinLat * sinLat;
+		double radiusN = WGS84A / sqrt(w);
+		double radiusM = radiusN * (1 - WGS84E2) / w;
+		m_degPerNorth[i] = 1 / (radiusM * GeoDegToRad);
+		m_degPerEast[i] = 1 / (radiusN * cosLat * GeoDegToRad);
+	}
+
+	//
+	RefractKernel(n, m_beamD.data(), batch.height.data(), batch.waterTime.data(), m_options.surfaceHeight,
+		1 / m_options.refractiveIndex, m_scale.data(), batch.bottomHeight.data(), batch.depth.data());
+	OffsetKernel(n, batch.lat.data(), m_beamN.data(), m_scale.data(), m_degPerNorth.data(), batch.bottomLat.data());
+	OffsetKernel(n, batch.lon.data(), m_beamE.data(), m_scale.data(), m_degPerEast.data(), batch.bottomLon.data());
+
+	//UTMͶӰδָͶӰʱһѡ
+	if (projected() && n > 0)
+	{
+		if (!m_zoneChosen)
+		{
+			int zone = (m_options.utmZone > 0) ? m_options.utmZone : UtmZone(batch.bottomLat[0], batch.bottomLon[0]);
+			m_projection.setZone(zone, batch.bottomLat[0] >= 0);
+			m_zoneChosen = true;
+		}
+		batch.bottomEast.resize(n);
+		batch.bottomNorth.resize(n);
+		m_projection.forward(n, batch.bottomLat.data(), batch.bottomLon.data(), batch.bottomEast.data(), batch.bottomNorth.data());
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "HS_Lidar_Header.h"
+#include "UtmProjection.h"
+using namespace std;
+
+
+#define GeoBatchSize 4096				//ÿλļ
+#define GeoLightSpeed 0.299792458		//չ٣m/ns
+#define GeoWaterIndex 1.34				//ĬϺˮ
+
+
+//λɨ辵Թ̶ɨ裬̶Ϊɨ跽λ
+struct GeoOptions
+{
+	double scanAngle;			//ǣ㣩NaNʱȡ˵
+	double boresightRoll;		//װƫ㣩ӵ֡ͷ̬
+	double boresightPitch;
+	double boresightHeading;
+	double surfaceHeight;		//ˮߣm
+	double refractiveIndex;		//ˮ
+	int utmZone;				//UTMͶӰţ0ΪһԶѡ񣬸ΪͶӰ
+
+	GeoOptions();
+};
+
+
+//һĶλݣֱţSoA
+//Ϊ֡ͷλ̬ˮ浽ˮ׵˫ʱ䣬Ϊˮ׵ľγȡUTMꡢߺʹֱˮ
+struct GeoBatch
+{
+	//
+	vector<double> lat;			//GPSγȣ㣩
+	vector<double> lon;			//GPSȣ㣩
+	vector<double> height;		//GPSߣm
+	vector<double> heading;		//λǣ㣩
+	vector<double> pitch;		//ǣ㣩
+	vector<double> roll;		//ǣ㣩
+	vector<double> scanAzimuth;	//ɨ跽λǣ㣩
+	vector<double> waterTime;	//ˮ浽ˮ׵˫ʱ䣨ns
+	vector<double> gpsTime;		//GPSʱ+*604800
+
+	//
+	vector<double> bottomLat;
+	vector<double> bottomLon;
+	vector<double> bottomEast;	//UTM꣨mͶӰʱΪ
+	vector<double> bottomNorth;	//UTM꣨m
+	vector<float> bottomHeight;	//ˮߣm
+	vector<float> depth;		//ֱˮm
+
+	size_t size() const { return lat.size(); }
+	void reserve(size_t n);
+	void clear();
+	void push(const HS_Lidar_Header &header, double waterTime);	//һ
+};
+
+
+//λ̬֡תɨ跽͵ʰ뾶Ǻÿֻ֡һΣ
+//ٶֻͿ㣺
+//ˮ󽻵õˮ㣬˹ˮйˮбõˮ׵㣬
+//ˮ׵㾭γͶӰUTMʹõһѡͶӰ
+class Georeferencer
+{
+public:
+	Georeferencer(const GeoOptions &options);
+	void run(GeoBatch &batch);
+	bool projected() const { return m_options.utmZone >= 0; }
+	int epsg() const;						//ƽEPSG루ͶӰδѡʱΪ0
+
+private:
+	GeoOptions m_options;
+	double m_sinScan;				//
+	double m_cosScan;
+	UtmProjection m_projection;
+	bool m_zoneChosen;				//ǷѡͶӰ
+
+	//֡м
+	vector<double> m_beamN;			//򣨱ϵλ
+	vector<double> m_beamE;
+	vector<double> m_beamD;
+	vector<double> m_degPerNorth;	//ÿ׶Ӧγȣ㣩
+	vector<double> m_degPerEast;	//ÿ׶Ӧľȣ㣩
+	vector<double> m_scale;			//ˮƽƫԹˮƽı
+};
@@ -4,6 +4,9 @@ Date:2019-01-02
 Description:ԭʼݸʽ
 **************************************************/
 #include "HS_Lidar.h"
+#include "Trace.h"
+#include "SimdKernels.h"
+#include <string.h>
 
 #define Swap16(v)  ( ((v & 0xff) << 8) | (v >> 8) )	//ֽת
  				    
@@ -38,13 +41,10 @@ double  SwapDouble(double * dv)
 }
 
 
-//ֽת
+//ֽתCPUֵָ֧ѡʵ
 void DataInt16Swap16(uint16_t *Data, uint16_t nNum)//int nNum
 {
-	for (uint16_t i = 0; i < nNum; i++)
-	{
- 		Data[i] = Swap16(Data[i]);
-	}
+	Kernels().byteSwap16(Data, nNum);
 }
 
 
@@ -60,6 +60,7 @@ HS_Lidar::~HS_Lidar()
 
 //ȡ
 void HS_Lidar::initData(FILE *fp) {
+	TraceScope trace("initData");
 	getHeader(fp);
 	getChannel(fp, CH1);
 	getChannel(fp, CH2);
@@ -103,9 +104,68 @@ void HS_Lidar::getHeader(FILE *fp) {
 }
 
 
+/*************************************************
+Function:       ͨ
+Description:	ÿ֡ȡǰ㣬֡ͷԻݲʱһ֡ݣ
+				֡Ľֻȡڱ֡ȡ˳߳޹أ
+Input:          CH:ͨ
+Output:
+*************************************************/
+static void clearChannel(HS_Lidar_Channel &CH)
+{
+	CH.nChannelNo = 0;
+	CH.nS0 = 0;
+	CH.nL0 = 0;
+	memset(CH.nD0, 0, sizeof(CH.nD0));
+	CH.nS1 = 0;
+	CH.nL1 = 0;
+	CH.nD1 = 0;
+}
+
+
+/*************************************************
+Function:       ȡһβ
+Description:	nL0nD0ȣ𻵣ʱֻǰChannelSamples
+				ļλnL0ͬļβʱΪ0
+Input:          fp:ļ CH:ѶnL0ͨ
+Output:			CH.nD0
+*************************************************/
+void HS_Lidar::getSegment0(FILE *fp, HS_Lidar_Channel &CH)
+{
+	uint16_t count = CH.nL0 < ChannelSamples ? CH.nL0 : ChannelSamples;
+	size_t samples = fread(CH.nD0, sizeof(uint16_t), count, fp);
+	memset(CH.nD0 + samples, 0, (ChannelSamples - samples) * sizeof(uint16_t));
+	DataInt16Swap16(CH.nD0, (uint16_t)samples);
+
+	if (CH.nL0 > count)
+		skipSamples(fp, CH.nL0 - count);
+}
+
+
+/*************************************************
+Function:       ʹõ
+Description:	ChannelSamplesֶζջϻڴ棨ļ
+				֡ɴ65535ΪfseekļβEOFжϲ
+Input:          fp:ļ count:
+Output:			
+*************************************************/
+void HS_Lidar::skipSamples(FILE *fp, size_t count)
+{
+	uint16_t buffer[ChannelSamples];
+	while (count > 0)
+	{
+		size_t samples = count < ChannelSamples ? count : ChannelSamples;
+		if (fread(buffer, sizeof(uint16_t), samples, fp) != samples)
+			return;
+		count -= samples;
+	}
+}
+
+
 //ȡͨ
 void HS_Lidar::getChannel(FILE *fp, HS_Lidar_Channel &CH) {
 
+	clearChannel(CH);
 	fread(&CH.nHeader, sizeof(uint32_t), 1, fp);
 	CH.nHeader = Swap32(CH.nHeader);
 
@@ -121,10 +181,7 @@ void HS_Lidar::getChannel(FILE *fp, HS_Lidar_Channel &CH) {
 		fread(&CH.nL0, sizeof(uint16_t), 1, fp);
 		CH.nL0 = Swap16(CH.nL0);
 
-
-		fread(&CH.nD0, CH.nL0 * sizeof(uint16_t), 1, fp);
-
-		DataInt16Swap16(CH.nD0, CH.nL0);
+		getSegment0(fp, CH);
 
 		fread(&CH.nTest, sizeof(uint32_t), 1, fp);
 		CH.nTest = Swap32(CH.nTest);
@@ -146,16 +203,8 @@ void HS_Lidar::getChannel(FILE *fp, HS_Lidar_Channel &CH) {
 			fread(&CH.nL1, sizeof(uint16_t), 1, fp);
 			CH.nL1 = Swap16(CH.nL1);
 
-			//CH_Data1ﲢûʹ
-			uint16_t *Ch_Data1 = new uint16_t[CH.nL1];
-			fread(Ch_Data1, CH.nL1 * sizeof(uint16_t), 1, fp);
-			DataInt16Swap16(Ch_Data1, CH.nL1);
-			
-			if (Ch_Data1 != NULL)
-			{
-				delete[] Ch_Data1;
-				Ch_Data1 = NULL;
-			}
+			//CH_Data1ﲢûʹã
+			skipSamples(fp, CH.nL1);
 		}
 	}		
 }
@@ -164,6 +213,7 @@ void HS_Lidar::getChannel(FILE *fp, HS_Lidar_Channel &CH) {
 //ȡˮ
 void HS_Lidar::initDeepData(FILE *fp)
 {
+	TraceScope trace("initDeepData");
 	getHeader(fp);
 	getDeepChannel(fp, CH1, deepData1);
 	getDeepChannel(fp, CH2, deepData2);
@@ -174,6 +224,8 @@ void HS_Lidar::initDeepData(FILE *fp)
 //ȡͨˮ
 void HS_Lidar::getDeepChannel(FILE *fp, HS_Lidar_Channel &CH,vector<int> &deepData) 
 {
+	clearChannel(CH);
+	deepData.clear();
 	fread(&CH.nHeader, sizeof(uint32_t), 1, fp);
 	CH.nHeader = Swap32(CH.nHeader);
 
@@ -189,9 +241,7 @@ void HS_Lidar::getDeepChannel(FILE *fp, HS_Lidar_Channel &CH,vector<int> &deepDa
 		fread(&CH.nL0, sizeof(uint16_t), 1, fp);
 		CH.nL0 = Swap16(CH.nL0);
 
-		fread(&CH.nD0, CH.nL0 * sizeof(uint16_t), 1, fp);
-
-		DataInt16Swap16(CH.nD0, CH.nL0);
+		getSegment0(fp, CH);
 
 		fread(&CH.nTest, sizeof(uint32_t), 1, fp);
 		CH.nTest = Swap32(CH.nTest);
@@ -213,19 +263,14 @@ void HS_Lidar::getDeepChannel(FILE *fp, HS_Lidar_Channel &CH,vector<int> &deepDa
 			fread(&CH.nL1, sizeof(uint16_t), 1, fp);
 			CH.nL1 = Swap16(CH.nL1);
 
-			//CH_Data1ﲢûʹ
-			uint16_t *Ch_Data1 = new uint16_t[CH.nL1];
-			fread(Ch_Data1, CH.nL1 * sizeof(uint16_t), 1, fp);
-			DataInt16Swap16(Ch_Data1, CH.nL1);
+			//븴õĻֻ֡ʱڴ
+			m_segmentBuffer.resize(CH.nL1);
+			fread(m_segmentBuffer.data(), CH.nL1 * sizeof(uint16_t), 1, fp);
+			DataInt16Swap16(m_segmentBuffer.data(), CH.nL1);
 
 			//λزݴvector
-			deepData.assign(Ch_Data1, Ch_Data1 + CH.nL1);
-
-			if (Ch_Data1 != NULL)
-			{
-				delete[] Ch_Data1;
-				Ch_Data1 = NULL;
-			}
+			deepData.resize(CH.nL1);
+			Kernels().widenU16ToInt(m_segmentBuffer.data(), deepData.data(), CH.nL1);
 		}
 	}
 }
\ No newline at end of file
@@ -34,6 +34,12 @@ public:
 	vector<int> deepData2;							//ͨĶλز
 	vector<int> deepData3;							//ͨĶλز
 	vector<int> deepData4;							//ͨĵĶλز	
+
+private:
+	void getSegment0(FILE *fp, HS_Lidar_Channel &CH);	//ȡһβΣChannelSamples
+	void skipSamples(FILE *fp, size_t count);			//ʹõ
+
+	vector<uint16_t> m_segmentBuffer;				//ˮλزĶȡ
 };
 
 
@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 
+#define ChannelSamples 320	//һβεޣnD0ĳȣ
+
 class HS_Lidar_Channel
 {
 public:
@@ -10,7 +12,7 @@ public:
 	uint16_t nChannelNo;//ͨ
 	uint16_t nS0;		//һȡλS0
 	uint16_t nL0;		//һȡL0
-	uint16_t nD0[320];	//D0
+	uint16_t nD0[ChannelSamples];	//D0nL0֮Ϊ0
 	uint16_t nS1;		//ڶȡλS1
 	uint16_t nL1;		//ڶȡL1
 	uint16_t nD1;		//D1
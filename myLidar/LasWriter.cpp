@@ -0,0 +1,178 @@
+/*************************************************
+Description:LAS 1.4ļд
+**************************************************/
+#include "LasWriter.h"
+#include "TimeConvert.h"
+#include <string.h>
+#include <math.h>
+
+#define LasScaleXY 1.0e-7			//γλȣԼ1cm
+#define LasScaleZ 1.0e-3			//߳λm
+#define LasFormat6Length 30			//ʽ6ļ¼
+#define LasFormat1Length 28			//ʽ1ļ¼
+
+//WGS84ϵ
+static const char LasWKT[] = "GEOGCS[\"WGS 84\",DATUM[\"WGS_1984\",SPHEROID[\"WGS 84\",6378137,298.257223563,"
+	"AUTHORITY[\"EPSG\",\"7030\"]],AUTHORITY[\"EPSG\",\"6326\"]],PRIMEM[\"Greenwich\",0],"
+	"UNIT[\"degree\",0.0174532925199433],AUTHORITY[\"EPSG\",\"4326\"]]";
+
+
+LasWriter::LasWriter()
+{
+	m_format = 6;
+	m_count = 0;
+	memset(&m_header, 0, sizeof(m_header));
+}
+
+
+LasWriter::~LasWriter()
+{
+	close();
+}
+
+
+/*************************************************
+Function:       LASļ
+Description:    дļͷϵ¼ƫдһʱȷ
+Input:          path:ļ· pointFormat:ʽ61 options:дļѡ
+Output:         Ƿ񴴽ɹ
+*************************************************/
+bool LasWriter::open(const char *path, int pointFormat, const WriteOptions &options)
+{
+	static_assert(sizeof(LasHeader) == LasHeaderSize, "LasHeader must be 375 bytes");
+	static_assert(sizeof(LasVLRHeader) == 54, "LasVLRHeader must be 54 bytes");
+
+	if (!m_file.open(path, "wb", options))
+	{
+		return false;
+	}
+
+	m_format = (pointFormat == 1) ? 1 : 6;
+	m_count = 0;
+
+	memset(&m_header, 0, sizeof(m_header));
+	memcpy(m_header.fileSignature, "LASF", 4);
+	m_header.globalEncoding = 0x1 | 0x10;
+	m_header.versionMajor = 1;
+	m_header.versionMinor = 4;
+	strncpy(m_header.systemIdentifier, "HS Lidar", sizeof(m_header.systemIdentifier));
+	strncpy(m_header.generatingSoftware, "myLidar", sizeof(m_header.generatingSoftware));
+	m_header.headerSize = LasHeaderSize;
+	m_header.numberOfVLRs = 1;
+	m_header.offsetToPointData = LasHeaderSize + sizeof(LasVLRHeader) + sizeof(LasWKT);
+	m_header.pointDataFormat = (uint8_t)m_format;
+	m_header.pointDataRecordLength = (m_format == 1) ? LasFormat1Length : LasFormat6Length;
+	m_header.scale[0] = LasScaleXY;
+	m_header.scale[1] = LasScaleXY;
+	m_header.scale[2] = LasScaleZ;
+	m_header.maxX = m_header.maxY = m_header.maxZ = -HUGE_VAL;
+	m_header.minX = m_header.minY = m_header.minZ = HUGE_VAL;
+	m_file.write(&m_header, sizeof(m_header));
+
+	LasVLRHeader vlr;
+	memset(&vlr, 0, sizeof(vlr));
+	strncpy(vlr.userID, "LASF_Projection", sizeof(vlr.userID));
+	vlr.recordID = 2112;
+	vlr.recordLengthAfterHeader = sizeof(LasWKT);
+	strncpy(vlr.description, "OGC WKT coordinate system", sizeof(vlr.description));
+	m_file.write(&vlr, sizeof(vlr));
+	m_file.write(LasWKT, sizeof(LasWKT));
+	return true;
+}
+
+
+int32_t LasWriter::quantize(double value, int axis) const
+{
+	return (int32_t)floor((value - m_header.offset[axis]) / m_header.scale[axis] + 0.5);
+}
+
+
+/*************************************************
+Function:       дһ
+Description:    Ӻƫ꣬°Χ
+Input:          x: y:γ z:̣߳m gpsTime:GPSʱ
+Output:
+*************************************************/
+void LasWriter::writePoint(double x, double y, double z, double gpsTime, bool noise)
+{
+	if (m_count == 0)
+	{
+		//ԵһȡΪƫ֤
+		m_header.offset[0] = floor(x);
+		m_header.offset[1] = floor(y);
+		m_header.offset[2] = 0;
+
+		//ԵһΪļ
+		GPSTIME gt;
+		double gpsSecond = gpsTime + LasGPSTimeOffset;
+		gt.wn = (int)(gpsSecond / 604800);
+		gt.tow.sn = (long)(gpsSecond - gt.wn * 604800.0);
+		gt.tow.tos = 0;
+		DOY doy;
+		GPSTimeToDOY(&gt, &doy);
+		m_header.creationYear = doy.year;
+		m_header.creationDay = doy.day;
+	}
+
+	int32_t xyz[3] = { quantize(x, 0), quantize(y, 1), quantize(z, 2) };
+	char *p = m_file.reserve(m_header.pointDataRecordLength);
+	memcpy(p, xyz, sizeof(xyz));
+	memset(p + 12, 0, m_header.pointDataRecordLength - 12);
+	if (m_format == 6)
+	{
+		p[14] = 0x11;							//1λز1λز
+		p[16] = noise ? LasClassLowNoise : LasClassBathymetry;
+		memcpy(p + 22, &gpsTime, sizeof(double));
+	}
+	else
+	{
+		p[14] = 0x09;							//1λز1λز
+		p[15] = noise ? LasClassLowNoise : LasClassUnclassified;
+		memcpy(p + 20, &gpsTime, sizeof(double));
+	}
+	m_file.commit(m_header.pointDataRecordLength);
+
+	//Χȡʵ
+	double qx = xyz[0] * m_header.scale[0] + m_header.offset[0];
+	double qy = xyz[1] * m_header.scale[1] + m_header.offset[1];
+	double qz = xyz[2] * m_header.scale[2] + m_header.offset[2];
+	if (qx > m_header.maxX) m_header.maxX = qx;
+	if (qx < m_header.minX) m_header.minX = qx;
+	if (qy > m_header.maxY) m_header.maxY = qy;
+	if (qy < m_header.minY) m_header.minY = qy;
+	if (qz > m_header.maxZ) m_header.maxZ = qz;
+	if (qz < m_header.minZ) m_header.minZ = qz;
+	m_count++;
+}
+
+
+/*************************************************
+Function:       رLASļ
+Description:    дΧСƫ
+Input:
+Output:         Ƿȫдɹ
+*************************************************/
+bool LasWriter::close()
+{
+	if (!m_file.isOpen())
+	{
+		return true;
+	}
+
+	if (m_count == 0)
+	{
+		m_header.maxX = m_header.minX = 0;
+		m_header.maxY = m_header.minY = 0;
+		m_header.maxZ = m_header.minZ = 0;
+	}
+	m_header.pointCount = m_count;
+	m_header.pointsByReturn[0] = m_count;
+	if (m_format == 1 && m_count <= UINT32_MAX)
+	{
+		m_header.legacyPointCount = (uint32_t)m_count;
+		m_header.legacyPointsByReturn[0] = (uint32_t)m_count;
+	}
+
+	m_file.rewrite(0, &m_header, sizeof(m_header));
+	return m_file.close();
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <stdint.h>
+#include "BufferedFile.h"
+using namespace std;
+
+
+#define LasHeaderSize 375			//LAS 1.4ļͷֽ
+#define LasClassBathymetry 40		//ˮ׵㣨ʽ6ã
+#define LasClassUnclassified 1		//δࣨʽ1ʹã
+#define LasClassLowNoise 7			//㣨޳ĵ㣩
+#define LasGPSTimeOffset 1.0e9		//׼GPSʱGPSʱ֮룩
+
+
+#pragma pack(push, 1)
+//LAS 1.4ļͷ
+struct LasHeader
+{
+	char fileSignature[4];			//"LASF"
+	uint16_t fileSourceID;
+	uint16_t globalEncoding;		//bit0:GPSʱ bit4:ϵΪWKT
+	uint32_t guidData1;
+	uint16_t guidData2;
+	uint16_t guidData3;
+	uint8_t guidData4[8];
+	uint8_t versionMajor;
+	uint8_t versionMinor;
+	char systemIdentifier[32];
+	char generatingSoftware[32];
+	uint16_t creationDay;			//
+	uint16_t creationYear;
+	uint16_t headerSize;
+	uint32_t offsetToPointData;
+	uint32_t numberOfVLRs;
+	uint8_t pointDataFormat;
+	uint16_t pointDataRecordLength;
+	uint32_t legacyPointCount;		//ʽ6Ϊ0
+	uint32_t legacyPointsByReturn[5];
+	double scale[3];
+	double offset[3];
+	double maxX, minX, maxY, minY, maxZ, minZ;
+	uint64_t waveformDataStart;
+	uint64_t firstEVLRStart;
+	uint32_t numberOfEVLRs;
+	uint64_t pointCount;
+	uint64_t pointsByReturn[15];
+};
+
+//ɱ䳤ȼ¼ͷ
+struct LasVLRHeader
+{
+	uint16_t reserved;
+	char userID[16];
+	uint16_t recordID;
+	uint16_t recordLengthAfterHeader;
+	char description[32];
+};
+#pragma pack(pop)
+
+
+//LAS 1.4дΪWGS84γȣX YγȣZΪˮߣˮȡ0ʱΪˮȡ
+//㰴ӺƫΪдΧк͵ڹرʱдļͷ
+class LasWriter
+{
+public:
+	LasWriter();
+	~LasWriter();
+
+	bool open(const char *path, int pointFormat = 6, const WriteOptions &options = WriteOptions());	//pointFormat:61
+	void writePoint(double x, double y, double z, double gpsTime, bool noise = false);	//gpsTime:GPSʱ׼GPSʱ-1e9 noise:
+	bool close();
+	uint64_t pointCount() const { return m_count; }
+
+private:
+	BufferedFile m_file;
+	LasHeader m_header;
+	int m_format;						//ʽ
+	uint64_t m_count;					//д
+	int32_t quantize(double value, int axis) const;
+};
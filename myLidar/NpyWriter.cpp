@@ -0,0 +1,110 @@
+/*************************************************
+Description:NumPy .npyļд
+**************************************************/
+#include "NpyWriter.h"
+#include <string.h>
+
+#define NpyAlignment 64					//ļͷ64ֽڶ룬ֱӳ
+#define NpyPrefixLength 10				//ħ汾źͷֶ
+
+
+NpyWriter::NpyWriter()
+{
+	m_dims = 0;
+	m_rowSize = 0;
+	m_headerLength = 0;
+	m_rows = 0;
+}
+
+
+NpyWriter::~NpyWriter()
+{
+	close();
+}
+
+
+/*************************************************
+Function:       ļͷ
+Description:    ʽΪ1.0棺ħ汾ͷȺֵ䣬Կո벢Իнβ
+                άȱ仯ʱ볤֮仯ļͷܳ
+Input:          rows:ά
+Output:         ļͷ
+*************************************************/
+string NpyWriter::makeHeader(uint64_t rows) const
+{
+	string dict = "{'descr': '" + m_descr + "', 'fortran_order': False, 'shape': (" + to_string(rows) + ",";
+	for (int i = 0; i < m_dims; i++)
+	{
+		dict += " " + to_string(m_shape[i]) + (i + 1 < m_dims ? "," : "");
+	}
+	dict += "), }";
+
+	size_t length = m_headerLength;
+	if (length == 0)
+	{
+		//״ʱάλԤ֤رʱдļͷͬ
+		length = NpyPrefixLength + dict.size() + 20 + 1;
+		length = (length + NpyAlignment - 1) / NpyAlignment * NpyAlignment;
+	}
+
+	size_t dictLength = length - NpyPrefixLength;
+	dict.append(dictLength - 1 - dict.size(), ' ');
+	dict += '\n';
+
+	string header("\x93NUMPY\x01\x00", 8);
+	header += (char)(dictLength & 0xff);
+	header += (char)(dictLength >> 8);
+	return header + dict;
+}
+
+
+/*************************************************
+Function:       ļ
+Description:    дάΪ0ļͷ
+Input:          path:ļ· descr:Ԫ itemSize:Ԫֽ
+                shape/dims:άά options:дļѡ
+Output:         Ƿ񴴽ɹ
+*************************************************/
+bool NpyWriter::open(const char *path, const char *descr, size_t itemSize, const int *shape, int dims, const WriteOptions &options)
+{
+	if (dims > NpyMaxDims || !m_file.open(path, "wb", options))
+	{
+		return false;
+	}
+
+	m_descr = descr;
+	m_dims = dims;
+	m_rowSize = itemSize;
+	for (int i = 0; i < dims; i++)
+	{
+		m_shape[i] = shape[i];
+		m_rowSize *= shape[i];
+	}
+	m_rows = 0;
+	m_headerLength = 0;
+
+	string header = makeHeader(0);
+	m_headerLength = header.size();
+	m_file.write(header.data(), header.size());
+	return true;
+}
+
+
+void NpyWriter::append(const void *rows, size_t count)
+{
+	m_file.write(rows, m_rowSize * count);
+	m_rows += count;
+}
+
+
+bool NpyWriter::close()
+{
+	if (!m_file.isOpen())
+	{
+		return true;
+	}
+
+	string header = makeHeader(m_rows);
+	m_file.rewrite(0, header.data(), header.size());
+	return m_file.close();
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include "BufferedFile.h"
+using namespace std;
+
+
+#define NpyMaxDims 4	//άά
+
+
+//NumPy .npyļдάΪ¼飩׷ӣرʱдάȡ
+//ݰC˳ţֱnumpy.load(..., mmap_mode='r')ӳȡ
+class NpyWriter
+{
+public:
+	NpyWriter();
+	~NpyWriter();
+
+	//descr:Ԫͣ"<f4" itemSize:Ԫֽ shape/dims:άά
+	bool open(const char *path, const char *descr, size_t itemSize, const int *shape, int dims, const WriteOptions &options = WriteOptions());
+	void append(const void *rows, size_t count);	//׷count¼
+	bool close();
+	uint64_t rowCount() const { return m_rows; }
+
+private:
+	string makeHeader(uint64_t rows) const;		//ļͷȹ̶Ϊm_headerLength
+
+	BufferedFile m_file;
+	string m_descr;
+	int m_shape[NpyMaxDims];
+	int m_dims;
+	size_t m_rowSize;						//¼ֽ
+	size_t m_headerLength;					//ļͷֽħ
+	uint64_t m_rows;						//д¼
+};
@@ -0,0 +1,154 @@
+/*************************************************
+Description:Ӳܼ
+                Linuxperf_event_openȡڡָ֧ԤʧܡL1/ĩȱʧ
+                ƽ̨ں˲ʱã÷ֻʱ
+**************************************************/
+#include "PerfCounters.h"
+#include <string.h>
+#include <errno.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+
+static const char *eventNames[PerfEventCount] = { "cycles", "instructions", "branchMisses", "l1dMisses", "llcMisses" };
+
+
+const char *PerfEventName(int event)
+{
+	return (event >= 0 && event < PerfEventCount) ? eventNames[event] : "unknown";
+}
+
+
+PerfCounters::PerfCounters()
+{
+	m_leader = -1;
+	m_count = 0;
+	for (int i = 0; i < PerfEventCount; i++)
+	{
+		m_fd[i] = -1;
+		m_slot[i] = -1;
+	}
+}
+
+
+PerfCounters::~PerfCounters()
+{
+	close();
+}
+
+
+/*************************************************
+Function:       򿪵ǰ̵߳ļ
+Description:	һ򿪳ɹ¼Ϊ鳤¼飬ͬʱ
+				perf_event_paranoidơûPMUԭ򲻿¼
+Input:
+Output:			Ƿһ¼ãȫʱerror()Ϊԭ
+*************************************************/
+bool PerfCounters::open()
+{
+	close();
+#ifdef __linux__
+	static const uint32_t types[PerfEventCount] = { PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+		PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE };
+	static const uint64_t configs[PerfEventCount] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_BRANCH_MISSES,
+		PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+		PERF_COUNT_HW_CACHE_MISSES };
+
+	int firstError = 0;
+	for (int i = 0; i < PerfEventCount; i++)
+	{
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = types[i];
+		attr.config = configs[i];
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		attr.disabled = (m_leader < 0) ? 1 : 0;		//鳤ֹͣȫ򿪺һʼ
+
+		int fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, m_leader, 0);
+		if (fd < 0)
+		{
+			if (firstError == 0)
+				firstError = errno;
+			continue;
+		}
+		if (m_leader < 0)
+			m_leader = fd;
+		m_fd[i] = fd;
+		m_slot[i] = m_count++;
+	}
+
+	if (m_count == 0)
+	{
+		m_error = string("perf_event_open: ") + strerror(firstError);
+		return false;
+	}
+	ioctl(m_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(m_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	return true;
+#else
+	m_error = "hardware counters are only supported on Linux";
+	return false;
+#endif
+}
+
+
+void PerfCounters::close()
+{
+#ifdef __linux__
+	for (int i = 0; i < PerfEventCount; i++)
+	{
+		if (m_fd[i] >= 0)
+			::close(m_fd[i]);
+	}
+#endif
+	for (int i = 0; i < PerfEventCount; i++)
+	{
+		m_fd[i] = -1;
+		m_slot[i] = -1;
+	}
+	m_leader = -1;
+	m_count = 0;
+}
+
+
+/*************************************************
+Function:       ȡ¼ۼƼ
+Description:	һreadȫ飺nrʱ䡢ʱ䡢¼
+				¼Ӳʱں˷ʱãʱ/ʱ任
+Input:
+Output:			sample:¼ۼƼǷȡɹ
+*************************************************/
+bool PerfCounters::read(PerfSample &sample)
+{
+	memset(&sample, 0, sizeof(sample));
+#ifdef __linux__
+	if (m_leader < 0)
+		return false;
+	uint64_t buffer[3 + PerfEventCount];
+	ssize_t n = ::read(m_leader, buffer, sizeof(buffer));
+	if (n < (ssize_t)(3 * sizeof(uint64_t)) || buffer[0] != (uint64_t)m_count)
+		return false;
+	uint64_t enabled = buffer[1];
+	uint64_t running = buffer[2];
+	for (int i = 0; i < PerfEventCount; i++)
+	{
+		if (m_slot[i] < 0)
+			continue;
+		uint64_t value = buffer[3 + m_slot[i]];
+		if (running > 0 && running < enabled)
+			value = (uint64_t)((double)value * enabled / running);
+		sample.value[i] = value;
+	}
+	return true;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+using namespace std;
+
+
+//Ӳ¼
+enum PerfEvent
+{
+	PERF_CYCLES = 0,			//CPU
+	PERF_INSTRUCTIONS = 1,		//ָ
+	PERF_BRANCH_MISSES = 2,		//֧Ԥʧ
+	PERF_L1D_MISSES = 3,		//L1ݻȱʧ
+	PERF_LLC_MISSES = 4,		//ĩȱʧ
+	PerfEventCount = 5
+};
+
+const char *PerfEventName(int event);
+
+
+//¼ۼƼʵʱ㣬δ򿪵¼Ϊ0
+struct PerfSample
+{
+	uint64_t value[PerfEventCount];
+};
+
+
+//ǰ̵߳Ӳ飨Linux perf_event_openֻû̬
+//¼ͬһڣһreadȫֵ֧¼ȫʱopenfalse¼ԭ
+//ֻͳƴ̣߳߳ʱÿ̸߳һ
+class PerfCounters
+{
+public:
+	PerfCounters();
+	~PerfCounters();
+
+	bool open();								//Ϊǰ̴߳򿪼飬Ƿһ¼
+	void close();
+	bool isOpen() const { return m_count > 0; }
+	bool available(int event) const { return m_slot[event] >= 0; }
+	bool read(PerfSample &sample);				//ȡ¼ۼƼ
+	const string &error() const { return m_error; }	//õԭ
+
+private:
+	int m_fd[PerfEventCount];					//¼ļ-1Ϊ
+	int m_slot[PerfEventCount];					//¼ȡеλã-1Ϊ
+	int m_leader;								//鳤ļ
+	int m_count;								//¼
+	string m_error;
+};
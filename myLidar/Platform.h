@@ -0,0 +1,19 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+
+
+//MSVC64λļλӳ䵽POSIXfseeko/ftellooff_tΪ64λ32λLinuxʱ_FILE_OFFSET_BITS=64
+#ifndef _MSC_VER
+#include <sys/types.h>
+#define _fseeki64 fseeko
+#define _ftelli64 ftello
+#endif
+
+
+//ȡC/C++0ȡ
+static inline int64_t floorDiv(int64_t a, int64_t b)
+{
+	int64_t q = a / b;
+	return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
@@ -4,22 +4,25 @@ Date:2019-01-02
 Description:ļ
 **************************************************/
 #include "ReadFile.h"
+#include "Platform.h"
+#include "AllocCounter.h"
+#include "LasWriter.h"
+#include "NpyWriter.h"
+#include "Georeference.h"
+#include "Trace.h"
+#include "SimdKernels.h"
+#include <algorithm>
 
 #define BLUE true
 #define GREEN false
 
+extern float angle;
 
-//жǷ(γȱ仯Сھ)
-bool isEqual(const double a, const double b)
-{
-	const double eps_0 = 1.0e-6;
-	bool isEqualFlag = false;
-	if (fabs(a - b) <= eps_0) {
-		isEqualFlag = true;
-	}
-
-	return isEqualFlag;
-}
+#define DebugWaveLength 320		//ǳˮγ
+#define DebugMaxComponent GaussInlineCount	//NumPyÿͨķ
+#define SyncScanBlock 4096		//֡ͷʱ֣ͬÿζֽ16ı
+#define ChunkFrames 32			//жȡʱÿεֽ֡Ƶ֡
+#define NoFrame UINT64_MAX		//֮û֡ͷ
 
 
 //ж֡ͷǷȷ
@@ -39,62 +42,305 @@ bool isHeaderRight(uint8_t header[8])
 }
 
 
-ReadFile::ReadFile()
+/*************************************************
+Function:       һ֡ͷ
+Description:	֡ͷʱܶλزݣԭÿκ16ֽ¶λ8ֽڱȽϣ
+				CPUֵָ֧֣ͬҵʱļָƵ֡ͷ
+				λ16ֽںһ
+Input:          fp:ļָ j:ǰλã8ֽΪλ
+Output:			һ֡ͷλã8ֽΪλļβδҵʱfeof(fp)Ϊ
+*************************************************/
+static uint64_t skipToHeader(FILE *fp, uint64_t j)
 {
+	uint8_t block[SyncScanBlock];
+	uint64_t next = j + 2;
+	for (;;)
+	{
+		_fseeki64(fp, next * 8, SEEK_SET);
+		size_t got = fread(block, 1, SyncScanBlock, fp);
+		size_t offset = Kernels().findSync(block, got);
+		if (offset + 8 <= got)
+		{
+			next += offset / 8;
+			_fseeki64(fp, next * 8, SEEK_SET);
+			return next;
+		}
+		next += offset / 8;
+		if (got < SyncScanBlock)
+			return next;
+	}
 }
 
 
-ReadFile::~ReadFile()
+//·ڴͳƣ֡ڸԤȲ룬˺֡Ӧڴ棬
+//ֻˮλزĻָ֡֡ʱԻ
+//LIDAR_COUNT_ALLOCʱͳƽCMakeѡMYLIDAR_COUNT_ALLOCֻͳƵ̣߳
+//glibc°mallocƽֻ̨operator newAllocCounter.h
+struct AllocProbe
+{
+	size_t base;				//֡
+	unsigned long long frames;	//Ѵ֡
+
+	AllocProbe() : base(0), frames(0) {}
+
+	void frameDone()
+	{
+		if (++frames == 1)
+			base = GetThreadAllocCount();
+	}
+
+	void report() const
+	{
+#ifdef LIDAR_COUNT_ALLOC
+		if (frames > 1)
+			printf("\nHot path allocations: %llu in %llu frames after the first.\n",
+				(unsigned long long)(GetThreadAllocCount() - base), frames - 1);
+#endif
+	}
+};
+
+
+//һ֡ݺͽ֡ʱһдʱɹ̶߳롢̰߳֡˳д
+struct FrameSlot
+{
+	HS_Lidar hs;
+	WaveData wave;				//ǳˮģʽĴ
+	DeepWave deep;				//ˮģʽĴ
+	int bgflag;					//ѡõͨ
+	bool rejected;				//ˮΪ0
+	int iterations;				//LM
+	uint64_t end;				//֡βļеλãֽڣ
+	FrameTiming timing;			//ֽ׶κʱ
+};
+
+
+//ļֽڷֶβжȡһпʼ֡ͬһ̶߳롢β֮ҵһ֡ͷΪֹ
+struct FrameChunk
 {
+	uint64_t begin;				//εķΧ8ֽΪλ֡ͷڴ˷Χڵ֡ڱ
+	uint64_t end;
+	uint64_t start;				//һ֡ͷλãNoFrameΪ֮û֡
+	uint64_t next;				//β֮ĵһ֡ͷһӦеstart
+	uint64_t resyncBytes;		//Ѱ֡ͷֽ
+	bool scanned;				//Ѷȡļʧʱд߳¶ȡ
+	int count;					//֡
+	FrameSlot *slots;			//ChunkFrames+1֡
+};
+
+
+//jʼjĵһ֡ͷλ֡һ£16ֽڶ룩
+static uint64_t findHeader(FILE *fp, uint64_t j)
+{
+	uint8_t header[8];
+	memset(header, 0, sizeof(uint8_t) * 8);
+	_fseeki64(fp, j * 8, SEEK_SET);
+	fread(header, sizeof(uint8_t), 8, fp);
+	if (isHeaderRight(header))
+		return j;
+	uint64_t next = skipToHeader(fp, j);
+	return feof(fp) ? NoFrame : next;
+}
+
+
+//һ֡ˮģʽͬʱȡλز
+void ReadFile::readFrame(FrameMode mode, FILE *fp, HS_Lidar &hs)
+{
+	if (mode == FRAME_DEEP || mode == FRAME_DEEP_BY_RED)
+		hs.initDeepData(fp);
+	else
+		hs.initData(fp);
 }
 
 
 /*************************************************
-Function:       öȡļָ
-Description:
-Input:          ȡļľ·
-Output:			·ļָ
+Function:       ȡһ
+Description:	chunk.start֡ķʽ֡ͷ֡֡336֡ͷʱң
+				֡ͷڶڵ֡βңֱ֡ͷļβ
+				λüΪnextβֽ֮Ҳ뱾
+Input:          mode: fp:̵߳ļָ chunk:εķΧ
+Output:			chunkе֡nextֽ
 *************************************************/
-bool ReadFile::setFilename(char filename[100])
+void ReadFile::scanChunk(FrameMode mode, FILE *fp, FrameChunk &chunk)
 {
-	m_filename = filename;
-	m_filePtr = fopen(m_filename, "rb");
-	if (m_filePtr == NULL)
-	{
-		printf("\nFile load failed!\n");
-		return false;
-	}
-	else
+	uint64_t j = chunk.start;
+	bool eof = j == NoFrame;
+	FrameTiming scan;
+	scan.clear();
+	while (!eof)
 	{
-		printf("\nFile loaded successfully!\n");
-		return true;
+		_fseeki64(fp, j * 8, SEEK_SET);
+
+		//Ѱ֡ͷ
+		uint8_t header[8];
+		memset(header, 0, sizeof(uint8_t) * 8);
+		fread(header, sizeof(uint8_t), 8, fp);
+		if (isHeaderRight(header))
+		{
+			if (j >= chunk.end)
+				break;
+
+			FrameSlot &slot = chunk.slots[chunk.count++];
+			slot.timing = scan;
+			slot.timing.lap(STAGE_SCAN);
+			_fseeki64(fp, -8, SEEK_CUR);
+			readFrame(mode, fp, slot.hs);
+			processFrame(mode, slot, slot.timing);
+
+			//ļָƫһ֡ݵֽ2688/8ĩ֡ʱ֡һ˽
+			j += 336;
+			slot.end = j * 8;
+			eof = feof(fp) != 0;
+			scan.clear();
+		}
+		else
+		{
+			//ܻλزݣuint16_t[CH.nL1] -> 2*n
+			uint64_t next = skipToHeader(fp, j);
+			chunk.resyncBytes += (next - j) * 8;
+			j = next;
+			eof = feof(fp) != 0;
+		}
 	}
+	chunk.next = eof ? NoFrame : j;
+	chunk.scanned = true;
 }
 
 
 /*************************************************
-Function:       ȫɫͨ
-Description:	ȡͨ˲ȥֽŻ
-Input:
-Output:			CH2ˮ
+Function:       ֶβжȡ
+Description:	ļChunkFramesֶֽ֡Σÿɶν̳߳أ̶̬߳ȡ
+				Լļָ룬Ӷڵһ֡ͷʼȡȡͬԶ⣩
+				д̵߳ȴһϣΡ֡˳commitдͬʱһ֡
+				֡ʱһεһξһεnextͬʱ֮
+				ȫһ£ͬʱһ֡ضϡ֡ڳֵͬȣһεnext¶ȡ
+				öΣ֡ͬ
+Input:          mode: stats:ͳ commit:дһ֡ڵ̣߳
+Output:
 *************************************************/
-void ReadFile::readBlueAll()
+void ReadFile::readChunks(FrameMode mode, RunStats &stats, const function<void(FrameSlot &)> &commit)
 {
-	unsigned _int64 j = 0;
-	HS_Lidar hs;
+	_fseeki64(m_filePtr, 0L, SEEK_END);
+	const uint64_t length = _ftelli64(m_filePtr);
+	const uint64_t chunkWords = (uint64_t)ChunkFrames * 336;
+	const uint64_t chunkCount = (length + chunkWords * 8 - 1) / (chunkWords * 8);
+	const int roundChunks = max(m_batchSize / ChunkFrames, 2 * m_pool->threads());
+	const int chunkSlots = ChunkFrames + 1;
+	const string filename = m_filename;
+
+	vector<FrameChunk> chunks[2];
+	unique_ptr<FrameSlot[]> slots[2];
+	PoolJob jobs[2];
+	for (int b = 0; b < 2; b++)
+	{
+		chunks[b].resize(roundChunks);
+		slots[b].reset(new FrameSlot[roundChunks * chunkSlots]);
+	}
+	int used[2] = { 0, 0 };
+	uint64_t expected = 0;			//֡ʱһε
+	uint64_t rescans = 0;
 
-	//ļλָƵļβȡļ
-	unsigned _int64 length;
+	//ύfirstʼһ
+	auto submit = [&](int b, uint64_t first)
+	{
+		used[b] = (int)min((uint64_t)roundChunks, chunkCount - first);
+		for (int i = 0; i < used[b]; i++)
+		{
+			FrameChunk &chunk = chunks[b][i];
+			chunk.begin = (first + i) * chunkWords;
+			chunk.end = chunk.begin + chunkWords;
+			chunk.start = NoFrame;
+			chunk.next = NoFrame;
+			chunk.resyncBytes = 0;
+			chunk.scanned = false;
+			chunk.count = 0;
+			chunk.slots = slots[b].get() + i * chunkSlots;
+		}
+		FrameChunk *round = chunks[b].data();
+		m_pool->start(jobs[b], used[b], [round, mode, &filename](int i)
+		{
+			FrameChunk &chunk = round[i];
+			FILE *fp = fopen(filename.c_str(), "rb");
+			if (fp == NULL)
+				return;
+			chunk.start = chunk.begin == 0 ? 0 : findHeader(fp, chunk.begin);
+			scanChunk(mode, fp, chunk);
+			fclose(fp);
+		});
+	};
+
+	//ȴһϣ˶Ը˳д
+	auto flush = [&](int b)
+	{
+		m_pool->wait(jobs[b]);
+		for (int i = 0; i < used[b]; i++)
+		{
+			FrameChunk &chunk = chunks[b][i];
+			if (!chunk.scanned || chunk.start != expected)
+			{
+				chunk.start = expected;
+				chunk.resyncBytes = 0;
+				chunk.count = 0;
+				scanChunk(mode, m_filePtr, chunk);
+				rescans++;
+			}
+			stats.resync(chunk.resyncBytes);
+			for (int k = 0; k < chunk.count; k++)
+			{
+				FrameSlot &slot = chunk.slots[k];
+				slot.timing.start();
+				commit(slot);
+				slot.timing.lap(STAGE_WRITE);
+				stats.frameDone(slot.timing, slot.rejected, slot.iterations);
+				stats.progress(slot.end);
+			}
+			expected = chunk.next;
+		}
+	};
+
+	//ֽ棺дһʱһڴ
+	int current = 0;
+	uint64_t first = 0;
+	submit(current, first);
+	first += used[current];
+	while (first < chunkCount)
+	{
+		submit(current ^ 1, first);
+		first += used[current ^ 1];
+		flush(current);
+		current ^= 1;
+	}
+	flush(current);
+
+	if (rescans > 0)
+	{
+		printf("\nRescanned %llu of %llu chunks whose first frame differed from the sequential scan.\n",
+			(unsigned long long)rescans, (unsigned long long)chunkCount);
+	}
+
+	//֡һͣļβôfeofβ
 	_fseeki64(m_filePtr, 0L, SEEK_END);
-	length = _ftelli64(m_filePtr);
-	printf("BLueChannelProcessing:");
+	fgetc(m_filePtr);
+}
 
-	//ȶ output_stream  ios::out ʾ,ios::appʾļβ
-	fstream output_stream;
-	output_stream.open("BlueOut.txt", ios::out);
 
-	//flag
-	WaveData::ostreamFlag = BLUE;
+/*************************************************
+Function:       ȡȫ֡
+Description:	ģʽã֡ͷ֡processFramecommitд֡ͷʱҡ
+				̳߳ʱֶβжȡreadChunksڵ߽߳֡ͬ
+Input:          mode: stats:ͳ commit:дһ֡ڵ̰߳֡˳ã
+Output:
+*************************************************/
+void ReadFile::readFrames(FrameMode mode, RunStats &stats, const function<void(FrameSlot &)> &commit)
+{
+	if (m_pool != NULL)
+	{
+		readChunks(mode, stats, commit);
+		return;
+	}
+
+	uint64_t j = 0;
+	unique_ptr<FrameSlot> slot(new FrameSlot);	//֡õݶ
+	AllocProbe allocProbe;
 
 	//ļȡ
 	do {
@@ -106,115 +352,397 @@ void ReadFile::readBlueAll()
 		fread(header, sizeof(uint8_t), 8, m_filePtr);
 		if (isHeaderRight(header))
 		{
+			stats.lap(STAGE_SCAN);
 			//ݵ̣
 			_fseeki64(m_filePtr, -8, SEEK_CUR);
-			hs.initData(m_filePtr);
-
-			WaveData mywave;
-			mywave.GetData(hs);
-			mywave.Filter(mywave.m_BlueWave, mywave.m_BlueNoise);
-			mywave.Resolve(mywave.m_BlueWave, mywave.m_BlueGauPra, mywave.m_BlueNoise);
-			mywave.Optimize(mywave.m_BlueWave, mywave.m_BlueGauPra);
-
-			mywave.CalcuDepth(mywave.m_BlueGauPra, mywave.blueDepth);
+			readFrame(mode, m_filePtr, slot->hs);
+			processFrame(mode, *slot, stats);
 
 			//Ϣļ
-			output_stream << mywave;
+			commit(*slot);
+			stats.lap(STAGE_WRITE);
+
+			stats.frameDone(slot->rejected, slot->iterations);
+			allocProbe.frameDone();
 
 			//ļָƫһ֡ݵֽ2688/8
 			j += 336;
 
-			//ӡÿ
-			printf("%5.2f%%", (float)j / (length / 800));
-			printf("\b\b\b\b\b\b");
-
+			//ӡʾֵ仯ʱŴӡ
+			stats.progress(j * 8);
 		}
 		else
 		{
 			//ܻλزݣuint16_t[CH.nL1] -> 2*n
-			j += 2;
+			uint64_t next = skipToHeader(m_filePtr, j);
+			stats.resync((next - j) * 8);
+			j = next;
 		}
 
 	} while (!feof(m_filePtr));
-
-	//ļ˳
-	if (feof(m_filePtr) == 1)
-	{
-		output_stream.close();
-		printf("Finished!\n");
-	}
+	allocProbe.report();
 }
 
 
 /*************************************************
-Function:       ȫɫͨ
-Description:	ȡͨ˲ȥֽŻ
-Input:
-Output:			CH3ˮ
+Function:       һ֡
+Description:	ģʽõĴֻ̣ʹø֡Լݶ󣻶֡ʹ˺׶εĺʱ
+				timer֡ʱΪRunStatsдʱΪ֡FrameTiming
+Input:          mode: slot:Ѷ֡ timer:ֽ׶μʱ
+Output:			slotеĴ
 *************************************************/
-void ReadFile::readGreenAll()
+template <class Timer>
+void ReadFile::processFrame(FrameMode mode, FrameSlot &slot, Timer &timing)
 {
-	unsigned _int64 j = 0;
-	HS_Lidar hs;
+	int bgflag;
+	float blueStd, greenStd;
 
-	//ļλָƵļβȡļ
-	unsigned _int64 length;
-	_fseeki64(m_filePtr, 0L, SEEK_END);
-	length = _ftelli64(m_filePtr);
-	printf("GreenChannelProcessing:");
+	if (mode == FRAME_DEEP || mode == FRAME_DEEP_BY_RED)
+	{
+		DeepWave &dw = slot.deep;
 
-	//ȶ output_stream  ios::out ʾ,ios::appʾļβ
-	fstream output_stream;
-	output_stream.open("GreenOut.txt", ios::out);
+		//ȡͨˮλز
+		dw.Reset();
+		dw.GetDeepData(slot.hs);
+		timing.lap(STAGE_DECODE);
 
-	//flag
-	WaveData::ostreamFlag = GREEN;
+		//ȡˮ
+		if (mode == FRAME_DEEP_BY_RED)
+		{
+			dw.GetRedTime(dw.m_RedDeep, dw.redTime);
+			timing.lap(STAGE_RESOLVE);
+		}
 
-	//ļȡ
-	do {
-		_fseeki64(m_filePtr, j * 8, SEEK_SET);
+		blueStd = calculateSigma(dw.m_BlueDeep);
+		greenStd = calculateSigma(dw.m_GreenDeep);
 
-		//Ѱ֡ͷ
-		uint8_t header[8];
-		memset(header, 0, sizeof(uint8_t) * 8);
-		fread(header, sizeof(uint8_t), 8, m_filePtr);
-		if (isHeaderRight(header))
+		blueStd >= 1.2*greenStd ? bgflag = BLUE : bgflag = GREEN;//жֵ
+		timing.lap(STAGE_DECODE);
+
+		switch (bgflag)
 		{
-			//ݵ̣
-			_fseeki64(m_filePtr, -8, SEEK_CUR);
-			hs.initData(m_filePtr);
+		case BLUE:
+			dw.DeepFilter(dw.m_BlueDeep, dw.m_BlueDeepNoise);
+			timing.lap(STAGE_FILTER);
+			dw.DeepResolve(dw.m_BlueDeep, dw.m_BlueDeepPra, dw.m_BlueDeepNoise);
+			timing.lap(STAGE_RESOLVE);
+			dw.DeepOptimize(dw.m_BlueDeep, dw.m_BlueDeepPra);
+			timing.lap(STAGE_OPTIMIZE);
+
+			if (mode == FRAME_DEEP_BY_RED)
+				dw.CalcuDeepDepthByRed(dw.m_BlueDeepPra, dw.redTime, dw.blueDeepDepth);
+			else
+				dw.CalcuDeepDepth(dw.m_BlueDeepPra, dw.blueDeepDepth);
+			timing.lap(STAGE_DEPTH);
+			break;
+		case GREEN:
+			dw.DeepFilter(dw.m_GreenDeep, dw.m_GreenDeepNoise);
+			timing.lap(STAGE_FILTER);
+			dw.DeepResolve(dw.m_GreenDeep, dw.m_GreenDeepPra, dw.m_GreenDeepNoise);
+			timing.lap(STAGE_RESOLVE);
+			dw.DeepOptimize(dw.m_GreenDeep, dw.m_GreenDeepPra);
+			timing.lap(STAGE_OPTIMIZE);
+
+			if (mode == FRAME_DEEP_BY_RED)
+				dw.CalcuDeepDepthByRed(dw.m_GreenDeepPra, dw.redTime, dw.greenDeepDepth);
+			else
+				dw.CalcuDeepDepth(dw.m_GreenDeepPra, dw.greenDeepDepth);
+			timing.lap(STAGE_DEPTH);
+			break;
+		default:
+			break;
+		}
 
-			WaveData mywave;
-			mywave.GetData(hs);
+		slot.rejected = (bgflag == BLUE ? dw.blueDeepDepth : dw.greenDeepDepth) == 0;
+		slot.iterations = 0;
+	}
+	else
+	{
+		WaveData &mywave = slot.wave;
+		mywave.Reset();
+		mywave.GetData(slot.hs);
+		timing.lap(STAGE_DECODE);
+
+		if (mode == FRAME_MIX)
+		{
+			blueStd = calculateSigma(mywave.m_BlueWave);
+			greenStd = calculateSigma(mywave.m_GreenWave);
+
+			blueStd >= 1.2*greenStd ? bgflag = BLUE : bgflag = GREEN;//жֵ
+			timing.lap(STAGE_DECODE);
+		}
+		else
+		{
+			bgflag = mode == FRAME_BLUE ? BLUE : GREEN;
+		}
+
+		switch (bgflag)
+		{
+		case BLUE:
+			mywave.Filter(mywave.m_BlueWave, mywave.m_BlueNoise);
+			timing.lap(STAGE_FILTER);
+			mywave.Resolve(mywave.m_BlueWave, mywave.m_BlueGauPra, mywave.m_BlueNoise);
+			timing.lap(STAGE_RESOLVE);
+			mywave.Optimize(mywave.m_BlueWave, mywave.m_BlueGauPra);
+			timing.lap(STAGE_OPTIMIZE);
+
+			mywave.CalcuDepth(mywave.m_BlueGauPra, mywave.blueDepth);
+			timing.lap(STAGE_DEPTH);
+			break;
+		case GREEN:
 			mywave.Filter(mywave.m_GreenWave, mywave.m_GreenNoise);
+			timing.lap(STAGE_FILTER);
 			mywave.Resolve(mywave.m_GreenWave, mywave.m_GreenGauPra, mywave.m_GreenNoise);
+			timing.lap(STAGE_RESOLVE);
 			mywave.Optimize(mywave.m_GreenWave, mywave.m_GreenGauPra);
+			timing.lap(STAGE_OPTIMIZE);
 
 			mywave.CalcuDepth(mywave.m_GreenGauPra, mywave.greenDepth);
+			timing.lap(STAGE_DEPTH);
+			break;
+		default:
+			break;
+		}
 
-			//Ϣļ
-			output_stream << mywave;
+		slot.rejected = (bgflag == BLUE ? mywave.blueDepth : mywave.greenDepth) == 0;
+		slot.iterations = mywave.m_LMIterations;
+	}
+	slot.bgflag = bgflag;
+}
 
-			//ļָƫһ֡ݵֽ2688/8
-			j += 336;
 
-			//ӡÿ
-			printf("%5.2f%%", (float)j / (length / 800));
-			printf("\b\b\b\b\b\b");
+ReadFile::ReadFile()
+{
+	m_filePtr = NULL;
+	m_pool = NULL;
+	m_batchSize = 1;
+	m_outputFormat = OUTPUT_TEXT;
+	m_lasPointFormat = 6;
+}
+
+
+ReadFile::~ReadFile()
+{
+	if (m_filePtr != NULL)
+	{
+		fclose(m_filePtr);
+	}
+}
+
+
+/*************************************************
+Function:       öȡļָ
+Description:	·ĸߵĻԸãѴ򿪵ļȹر
+Input:          ȡļ·
+Output:			·ļָ
+*************************************************/
+bool ReadFile::setFilename(const char *filename)
+{
+	if (m_filePtr != NULL)
+	{
+		fclose(m_filePtr);
+	}
+	m_filename = filename;
+	m_filePtr = fopen(m_filename.c_str(), "rb");
+	if (m_filePtr == NULL)
+	{
+		printf("\nFile load failed!\n");
+		return false;
+	}
+	else
+	{
+		printf("\nFile loaded successfully!\n");
+		return true;
+	}
+}
+
+
+/*************************************************
+Function:       ˮʽ
+Description:	ıʽԭͬΪ¼
+Input:          format:ʽ
+Output:
+*************************************************/
+void ReadFile::setOutputFormat(OutputFormat format)
+{
+	m_outputFormat = format;
+}
+
+
+/*************************************************
+Function:       дļѡ
+Description:	ģʽĽݺLASļѡд
+Input:          options:̨дֱд̡С
+Output:
+*************************************************/
+void ReadFile::setWriteOptions(const WriteOptions &options)
+{
+	m_writeOptions = options;
+}
+
+
+/*************************************************
+Function:       LASʽ
+Description:	6ΪLAS 1.4ʽˮ׵ࣩ1Ϊݾĵʽ
+Input:          pointFormat:ʽ
+Output:
+*************************************************/
+void ReadFile::setLasPointFormat(int pointFormat)
+{
+	m_lasPointFormat = pointFormat;
+}
+
+
+void ReadFile::setGridOptions(const GridOptions &options)
+{
+	m_gridOptions = options;
+}
+
+
+void ReadFile::setGeoOptions(const GeoOptions &options)
+{
+	m_geoOptions = options;
+}
+
+
+void ReadFile::setQaOptions(const QaOptions &options)
+{
+	m_qaOptions = options;
+}
+
+
+/*************************************************
+Function:       ͳѡ
+Description:	ģʽʱӡ׶κʱдJSONͳƣòʱаstderr
+Input:          options:ǷдJSONJSON·
+Output:
+*************************************************/
+void ReadFile::setStatsOptions(const StatsOptions &options)
+{
+	m_statsOptions = options;
+}
+
+
+/*************************************************
+Function:       ļǰ׺
+Description:	ģʽĽݡLASļͳJSONļǰǰ׺
+				"out/line01_"Ŀ¼ѴڣĬǰ׺дڵǰĿ¼
+Input:          prefix:ļǰ׺
+Output:
+*************************************************/
+void ReadFile::setOutputPrefix(const string &prefix)
+{
+	m_outputPrefix = prefix;
+}
+
+
+/*************************************************
+Function:       ô̳߳
+Description:	BlueGreenMixDeepDeepByRedDeepOutLasģʽļֶΣ̳߳ظ߳
+				ֱȡһͬʱ֡˳дһ֡ͬ
+				OutputData֡׶ݣڵ̴߳
+Input:          pool:̳߳أļãNULLΪ֡ batchSize:ÿٰ֡
+Output:
+*************************************************/
+void ReadFile::setWorkerPool(WorkerPool *pool, int batchSize)
+{
+	m_pool = pool;
+	m_batchSize = batchSize > 0 ? batchSize : 1;
+}
+
+
+string ReadFile::outputPath(const char *name) const
+{
+	return m_outputPrefix + name;
+}
+
+
+//ǰ׺ʱͳJSONĬдǰ׺£дʱӲֻͳƶȡ̣߳ٶȡ
+StatsOptions ReadFile::statsOptions(const char *mode) const
+{
+	StatsOptions options = m_statsOptions;
+	if (options.path.empty() && !m_outputPrefix.empty())
+	{
+		options.path = m_outputPrefix + mode + "Stats.json";
+	}
+	if (m_pool != NULL && options.counters)
+	{
+		printf("Hardware counters are per thread, disabled for parallel processing.\n");
+		options.counters = false;
+	}
+	return options;
+}
+
+
+/*************************************************
+Function:       ȫɫͨ
+Description:	ȡͨ˲ȥֽŻ
+Input:
+Output:			CH2ˮ
+*************************************************/
+void ReadFile::readBlueAll()
+{
+	//ļλָƵļβȡļ
+	uint64_t length;
+	_fseeki64(m_filePtr, 0L, SEEK_END);
+	length = _ftelli64(m_filePtr);
+	printf("BLueChannelProcessing:");
+
+	//õĸʽд
+	unique_ptr<ResultSink> sink(CreateResultSink(m_outputFormat));
+	sink->open(outputPath("BlueOut").c_str(), m_writeOptions);
+
+	//׶ͳ
+	RunStats stats("Blue", m_filename.c_str(), length, statsOptions("Blue"));
+
+	//̳֡߳ʱֶβУ֡˳д
+	readFrames(FRAME_BLUE, stats, [&](FrameSlot &slot) { sink->writeShot(slot.wave, BLUE); });
+
+	//ļ˳
+	if (feof(m_filePtr) == 1)
+	{
+		stats.progress(length);
+		stats.lap(STAGE_SCAN);
+		sink->close();
+		stats.lap(STAGE_WRITE);
+		stats.report();
+		printf("Finished!\n");
+	}
+}
+
+
+/*************************************************
+Function:       ȫɫͨ
+Description:	ȡͨ˲ȥֽŻ
+Input:
+Output:			CH3ˮ
+*************************************************/
+void ReadFile::readGreenAll()
+{
+	//ļλָƵļβȡļ
+	uint64_t length;
+	_fseeki64(m_filePtr, 0L, SEEK_END);
+	length = _ftelli64(m_filePtr);
+	printf("GreenChannelProcessing:");
+
+	//õĸʽд
+	unique_ptr<ResultSink> sink(CreateResultSink(m_outputFormat));
+	sink->open(outputPath("GreenOut").c_str(), m_writeOptions);
 
-		}
-		else
-		{
-			//ܻλزݣuint16_t[CH.nL1] -> 2*n
-			j += 2;
-		}
+	//׶ͳ
+	RunStats stats("Green", m_filename.c_str(), length, statsOptions("Green"));
 
-	} while (!feof(m_filePtr));
+	//̳֡߳ʱֶβУ֡˳д
+	readFrames(FRAME_GREEN, stats, [&](FrameSlot &slot) { sink->writeShot(slot.wave, GREEN); });
 
 	//ļ˳
 	if (feof(m_filePtr) == 1)
 	{
-		output_stream.close();
+		stats.progress(length);
+		stats.lap(STAGE_SCAN);
+		sink->close();
+		stats.lap(STAGE_WRITE);
+		stats.report();
 		printf("Finished!\n");
 	}
 }
@@ -228,91 +756,30 @@ Output:			CH2,CH3ͨ
 *************************************************/
 void ReadFile::readMix()
 {
-	unsigned _int64 j = 0;
-	HS_Lidar hs;
-
 	//ļλָƵļβȡļ
-	unsigned _int64 length;
+	uint64_t length;
 	_fseeki64(m_filePtr, 0L, SEEK_END);
 	length = _ftelli64(m_filePtr);
 	printf("MixChannelProcessing:");
 
-	//ȶ output_stream  ios::out ʾ,ios::appʾļβ
-	fstream output_stream;
-	output_stream.open("MixOut.txt", ios::out);
-
-	int bgflag;
-	float blueStd, greenStd;
-
-	//ļȡ
-	do {
-		_fseeki64(m_filePtr, j * 8, SEEK_SET);
-
-		//Ѱ֡ͷ
-		uint8_t header[8];
-		memset(header, 0, sizeof(uint8_t) * 8);
-		fread(header, sizeof(uint8_t), 8, m_filePtr);
-		if (isHeaderRight(header))
-		{
-			//ݵ̣
-			_fseeki64(m_filePtr, -8, SEEK_CUR);
-			hs.initData(m_filePtr);
-
-			WaveData mywave;
-			mywave.GetData(hs);
-
-			blueStd = calculateSigma(mywave.m_BlueWave);
-			greenStd = calculateSigma(mywave.m_GreenWave);
-
-			blueStd >= 1.2*greenStd ? bgflag = BLUE : bgflag = GREEN;//жֵ
-
-			switch (bgflag)
-			{
-			case BLUE:
-				WaveData::ostreamFlag = BLUE;
-
-				mywave.Filter(mywave.m_BlueWave, mywave.m_BlueNoise);
-				mywave.Resolve(mywave.m_BlueWave, mywave.m_BlueGauPra, mywave.m_BlueNoise);
-				mywave.Optimize(mywave.m_BlueWave, mywave.m_BlueGauPra);
-
-				mywave.CalcuDepth(mywave.m_BlueGauPra, mywave.blueDepth);
-				break;
-			case GREEN:
-				WaveData::ostreamFlag = GREEN;
-
-				mywave.Filter(mywave.m_GreenWave, mywave.m_GreenNoise);
-				mywave.Resolve(mywave.m_GreenWave, mywave.m_GreenGauPra, mywave.m_GreenNoise);
-				mywave.Optimize(mywave.m_GreenWave, mywave.m_GreenGauPra);
-
-				mywave.CalcuDepth(mywave.m_GreenGauPra, mywave.greenDepth);
-				break;
-			default:
-				break;
-			}
-
-			//Ϣļ
-			output_stream << mywave;
-
-			//ļָƫһ֡ݵֽ2688/8
-			j += 336;
-
-			//ӡÿ
-			printf("%5.2f%%", (float)j / (length / 800));
-			printf("\b\b\b\b\b\b");
+	//õĸʽд
+	unique_ptr<ResultSink> sink(CreateResultSink(m_outputFormat));
+	sink->open(outputPath("MixOut").c_str(), m_writeOptions);
 
-		}
-		else
-		{
-			//ܻλزݣuint16_t[CH.nL1] -> 2*n
-			j += 2;
-		}
+	//׶ͳ
+	RunStats stats("Mix", m_filename.c_str(), length, statsOptions("Mix"));
 
-	} while (!feof(m_filePtr));
+	//̳֡߳ʱֶβУ֡˳д
+	readFrames(FRAME_MIX, stats, [&](FrameSlot &slot) { sink->writeShot(slot.wave, slot.bgflag); });
 
 	//ļ˳
 	if (feof(m_filePtr) == 1)
 	{
-		output_stream.close();
+		stats.progress(length);
+		stats.lap(STAGE_SCAN);
+		sink->close();
+		stats.lap(STAGE_WRITE);
+		stats.report();
 		printf("Finished!\n");
 	}
 }
@@ -325,9 +792,17 @@ Input:
 Output:			CH2,CH3ͨЧˮ
 *************************************************/
 void ReadFile::outputData() {
+	//ƸʽΪNumPy
+	if (m_outputFormat == OUTPUT_BINARY) {
+		outputDataNpy();
+		return;
+	}
+
 	unsigned long long j = 0;
 	unsigned long long index = 0;
 	HS_Lidar hs;
+	WaveData mywave;				//֡õݶ
+	AllocProbe allocProbe;
 
 	//ļλָƵļβȡļ
 	unsigned long long length;
@@ -335,29 +810,32 @@ void ReadFile::outputData() {
 	length = _ftelli64(m_filePtr);
 	printf("OutputDataProcessing:");
 
-	//ȶ output_stream  ios::out ʾ,ios::appʾļβ
-	fstream output_stream;
-	output_stream.open("Final.txt", ios::out);
-
-	fstream origin;//ʼ
-	fstream filter;//˲
-	fstream region;//ȡ
-	fstream resolve;//
-	fstream iterate;//
-	fstream gaussB;//ͳⷨͨ
-	fstream gaussG;//ͳⷨͨ
-	origin.open("Origin.txt", ios::out);
-	filter.open("Filter.txt", ios::out);
-	int*ret;
-	region.open("Region.txt", ios::out);
-	resolve.open("Resolve.txt", ios::out);
-	iterate.open("Iterate.txt", ios::out);
-	gaussB.open("GaussB.txt", ios::out);
-	gaussG.open("GaussG.txt", ios::out);
+	//д󻺳endlд
+	BufferedOStream output_stream;
+	output_stream.open(outputPath("Final.txt").c_str(), m_writeOptions);
+
+	BufferedOStream origin;//ʼ
+	BufferedOStream filter;//˲
+	BufferedOStream region;//ȡ
+	BufferedOStream resolve;//
+	BufferedOStream iterate;//
+	BufferedOStream gaussB;//ͳⷨͨ
+	BufferedOStream gaussG;//ͳⷨͨ
+	origin.open(outputPath("Origin.txt").c_str(), m_writeOptions);
+	filter.open(outputPath("Filter.txt").c_str(), m_writeOptions);
+	int ret[2];//ȡΧ
+	region.open(outputPath("Region.txt").c_str(), m_writeOptions);
+	resolve.open(outputPath("Resolve.txt").c_str(), m_writeOptions);
+	iterate.open(outputPath("Iterate.txt").c_str(), m_writeOptions);
+	gaussB.open(outputPath("GaussB.txt").c_str(), m_writeOptions);
+	gaussG.open(outputPath("GaussG.txt").c_str(), m_writeOptions);
 
 	int bgflag;
 	float blueStd, greenStd;
 
+	//׶ͳ
+	RunStats stats("OutputData", m_filename.c_str(), length, statsOptions("OutputData"));
+
 	//ļȡ
 	do {
 		_fseeki64(m_filePtr, j * 8, SEEK_SET);
@@ -367,19 +845,21 @@ void ReadFile::outputData() {
 		memset(header, 0, sizeof(uint8_t) * 8);
 		fread(header, sizeof(uint8_t), 8, m_filePtr);
 		if (isHeaderRight(header)) {
+			stats.lap(STAGE_SCAN);
 			//
 			index++;
 			//ݵ̣
 			_fseeki64(m_filePtr, -8, SEEK_CUR);
 			hs.initData(m_filePtr);
 
-			WaveData mywave;
+			mywave.Reset();
 			mywave.GetData(hs);
 
 			blueStd = calculateSigma(mywave.m_BlueWave);
 			greenStd = calculateSigma(mywave.m_GreenWave);
 
 			blueStd >= 1.2 * greenStd ? bgflag = BLUE : bgflag = GREEN;//жֵ
+			stats.lap(STAGE_DECODE);
 
 			//ͨڸԵ
 			//===========Blue start===============
@@ -392,8 +872,9 @@ void ReadFile::outputData() {
 			}
 			origin << endl;
 
-			ret = new int[2];
+			stats.lap(STAGE_WRITE);
 			mywave.FilterWithRegion(mywave.m_BlueWave, mywave.m_BlueNoise, ret);
+			stats.lap(STAGE_FILTER);
 
 			//˲
 			filter << "<" << index << "B" << ">" << endl;
@@ -402,9 +883,10 @@ void ReadFile::outputData() {
 			}
 			filter << endl;
 			region << "<" << index << "B" << ">" << ret[0] << "-" << ret[1] << "-" << ret[1] - ret[0] << endl;
-			delete ret;
 
+			stats.lap(STAGE_WRITE);
 			mywave.Resolve(mywave.m_BlueWave, mywave.m_BlueGauPra, mywave.m_BlueNoise);
+			stats.lap(STAGE_RESOLVE);
 
 			//
 			resolve << "<" << index << "B" << ">" << endl;
@@ -440,7 +922,9 @@ void ReadFile::outputData() {
 
 
 			//ͨĸ˹ֽⷨõ
+			stats.lap(STAGE_WRITE);
 			mywave.CalcuDepthByGauss(mywave.m_BlueGauPra, mywave.blueDepth);
+			stats.lap(STAGE_DEPTH);
 			gaussB << "<" << index << ">" << " "
 				<< mywave.m_time.year << " "
 				<< mywave.m_time.month << " "
@@ -457,7 +941,9 @@ void ReadFile::outputData() {
 
 
 			//
+			stats.lap(STAGE_WRITE);
 			mywave.Optimize(mywave.m_BlueWave, mywave.m_BlueGauPra);
+			stats.lap(STAGE_OPTIMIZE);
 			iterate << "<" << index << "B" << ">" << endl;
 			//˹
 			for (auto data : mywave.m_BlueGauPra) {
@@ -501,8 +987,9 @@ void ReadFile::outputData() {
 			}
 			origin << endl;
 
-			ret = new int[2];
+			stats.lap(STAGE_WRITE);
 			mywave.FilterWithRegion(mywave.m_GreenWave, mywave.m_GreenNoise, ret);
+			stats.lap(STAGE_FILTER);
 
 			//˲
 			filter << "<" << index << "G" << ">" << endl;
@@ -511,9 +998,10 @@ void ReadFile::outputData() {
 			}
 			filter << endl;
 			region << "<" << index << "G" << ">" << ret[0] << "-" << ret[1] << "-" << ret[1] - ret[0] << endl;
-			delete ret;
 
+			stats.lap(STAGE_WRITE);
 			mywave.Resolve(mywave.m_GreenWave, mywave.m_GreenGauPra, mywave.m_GreenNoise);
+			stats.lap(STAGE_RESOLVE);
 
 			//
 			resolve << "<" << index << "G" << ">" << endl;
@@ -550,7 +1038,9 @@ void ReadFile::outputData() {
 
 			//ͨĸ˹ֽⷨõ
 
+			stats.lap(STAGE_WRITE);
 			mywave.CalcuDepthByGauss(mywave.m_GreenGauPra, mywave.greenDepth);
+			stats.lap(STAGE_DEPTH);
 			gaussG << "<" << index << ">" << " "
 				<< mywave.m_time.year << " "
 				<< mywave.m_time.month << " "
@@ -567,7 +1057,9 @@ void ReadFile::outputData() {
 
 
 			//
+			stats.lap(STAGE_WRITE);
 			mywave.Optimize(mywave.m_GreenWave, mywave.m_GreenGauPra);
+			stats.lap(STAGE_OPTIMIZE);
 			iterate << "<" << index << "G" << ">" << endl;
 			//˹
 			for (auto data : mywave.m_GreenGauPra) {
@@ -603,7 +1095,9 @@ void ReadFile::outputData() {
 			//Ϣѡȡľͨ
 			switch (bgflag) {
 			case BLUE:
+				stats.lap(STAGE_WRITE);
 				mywave.CalcuDepth(mywave.m_BlueGauPra, mywave.blueDepth);
+				stats.lap(STAGE_DEPTH);
 				//Ϣļ
 				output_stream << "<" << index << ">" << " "
 					<< mywave.m_time.year << " "
@@ -621,7 +1115,9 @@ void ReadFile::outputData() {
 
 				break;
 			case GREEN:
+				stats.lap(STAGE_WRITE);
 				mywave.CalcuDepth(mywave.m_GreenGauPra, mywave.greenDepth);
+				stats.lap(STAGE_DEPTH);
 				output_stream << "<" << index << ">" << " "
 					<< mywave.m_time.year << " "
 					<< mywave.m_time.month << " "
@@ -641,29 +1137,41 @@ void ReadFile::outputData() {
 				break;
 			}
 
+			stats.lap(STAGE_WRITE);
+			stats.frameDone((bgflag == BLUE ? mywave.blueDepth : mywave.greenDepth) == 0, mywave.m_LMIterations);
+			allocProbe.frameDone();
+
 			//ļָƫһ֡ݵֽ2688/8
 			j += 336;
 
-			//ӡÿ
-			printf("%5.2f%%", (float)j / (length / 800));
-			printf("\b\b\b\b\b\b");
+			//ӡʾֵ仯ʱŴӡ
+			stats.progress(j * 8);
 
 		}
 		else {
 			//ܻλزݣuint16_t[CH.nL1] -> 2*n
-			j += 2;
+			uint64_t next = skipToHeader(m_filePtr, j);
+			stats.resync((next - j) * 8);
+			j = next;
 		}
 
 	} while (!feof(m_filePtr));
 
 	//ļ˳
 	if (feof(m_filePtr) == 1) {
+		stats.progress(length);
+		stats.lap(STAGE_SCAN);
 		output_stream.close();
 		origin.close();//ʼ
 		filter.close();//˲
 		region.close();
 		resolve.close();//
 		iterate.close();//
+		gaussB.close();
+		gaussG.close();
+		stats.lap(STAGE_WRITE);
+		allocProbe.report();
+		stats.report();
 		printf("finished!\n");
 	}
 
@@ -671,30 +1179,64 @@ void ReadFile::outputData() {
 
 
 /*************************************************
-Function:       ˮCH2CH3ͨϴ
-Description:	ȡͨݣͨı׼СѡӦͨˮ
+Function:       ׶ݣNumPy飩
+Description:	outputDataĴͬдΪ.npy飬άΪ֡ţ
+				ڶάΪͨ01̣׶άΪ01
+				Raw/Filtered.npy:	float32[N][2][320] ԭʼ˲
+				Params.npy:			float32[N][2][2][32][3] A b sigma㲹0
+				Count.npy:			int32[N][2][2] ParamsЧķ32ʱֻǰ32
+				Sum.npy:			float32[N][2][2][320] ȫĵ
+				Region.npy:			int32[N][2][2] ȡΧ
+				Depth.npy:			float32[N][2][2] ͨ˹ֽˮˮδѡõͨΪ0
+				Time.npy:			int64[N] UTCʱ䣨UnixԪ
+				߲ٱ棬ҪʱParamsGaussianCurve
 Input:
-Output:			CH2,CH3ͨЧˮ
+Output:			.npyļ
 *************************************************/
-void ReadFile::readDeep()
+void ReadFile::outputDataNpy()
 {
-	unsigned _int64 j = 0;
+	uint64_t j = 0;
 	HS_Lidar hs;
+	WaveData mywave;				//֡õݶ
+	AllocProbe allocProbe;
 
 	//ļλָƵļβȡļ
-	unsigned _int64 length;
+	uint64_t length;
 	_fseeki64(m_filePtr, 0L, SEEK_END);
 	length = _ftelli64(m_filePtr);
-	printf("ReadDeepProcessing:");
-
-
-	//ȶ output_stream  ios::out ʾ,ios::appʾļβ
-	fstream output_stream;
-	output_stream.open("DeepOut.txt", ios::out);
+	printf("OutputDataProcessing:");
 
+	//ά״
+	const int waveShape[] = { 2, DebugWaveLength };
+	const int paramShape[] = { 2, 2, DebugMaxComponent, 3 };
+	const int pairShape[] = { 2, 2 };
+	const int sumShape[] = { 2, 2, DebugWaveLength };
+
+	NpyWriter raw, filtered, params, count, sum, region, depth, time;
+	raw.open(outputPath("Raw.npy").c_str(), "<f4", sizeof(float), waveShape, 2, m_writeOptions);
+	filtered.open(outputPath("Filtered.npy").c_str(), "<f4", sizeof(float), waveShape, 2, m_writeOptions);
+	params.open(outputPath("Params.npy").c_str(), "<f4", sizeof(float), paramShape, 4, m_writeOptions);
+	count.open(outputPath("Count.npy").c_str(), "<i4", sizeof(int32_t), pairShape, 2, m_writeOptions);
+	sum.open(outputPath("Sum.npy").c_str(), "<f4", sizeof(float), sumShape, 3, m_writeOptions);
+	region.open(outputPath("Region.npy").c_str(), "<i4", sizeof(int32_t), pairShape, 2, m_writeOptions);
+	depth.open(outputPath("Depth.npy").c_str(), "<f4", sizeof(float), pairShape, 2, m_writeOptions);
+	time.open(outputPath("Time.npy").c_str(), "<i8", sizeof(int64_t), NULL, 0, m_writeOptions);
+
+	//֡
+	float rawRow[2][DebugWaveLength];
+	float filteredRow[2][DebugWaveLength];
+	float paramRow[2][2][DebugMaxComponent][3];
+	int32_t countRow[2][2];
+	float sumRow[2][2][DebugWaveLength];
+	int32_t regionRow[2][2];
+	float depthRow[2][2];
+
+	int ret[2];//ȡΧ
 	int bgflag;
 	float blueStd, greenStd;
 
+	//׶ͳ
+	RunStats stats("OutputData", m_filename.c_str(), length, statsOptions("OutputData"));
 
 	//ļȡ
 	do {
@@ -706,59 +1248,109 @@ void ReadFile::readDeep()
 		fread(header, sizeof(uint8_t), 8, m_filePtr);
 		if (isHeaderRight(header))
 		{
+			stats.lap(STAGE_SCAN);
 			//ݵ̣
 			_fseeki64(m_filePtr, -8, SEEK_CUR);
-			hs.initDeepData(m_filePtr);
+			hs.initData(m_filePtr);
 
-			//ȡͨˮλز
-			DeepWave dw;
-			dw.GetDeepData(hs);
+			mywave.Reset();
+			mywave.GetData(hs);
+			stats.lap(STAGE_DECODE);
 
-			//process
-			blueStd = calculateSigma(dw.m_BlueDeep);
-			greenStd = calculateSigma(dw.m_GreenDeep);
+			blueStd = calculateSigma(mywave.m_BlueWave);
+			greenStd = calculateSigma(mywave.m_GreenWave);
 
-			blueStd >= 1.2*greenStd ? bgflag = BLUE : bgflag = GREEN;//жֵ
+			blueStd >= 1.2 * greenStd ? bgflag = BLUE : bgflag = GREEN;//жֵ
+			stats.lap(STAGE_DECODE);
 
-			switch (bgflag)
-			{
-			case BLUE:
-				DeepWave::ostreamFlag = BLUE;
+			memset(paramRow, 0, sizeof(paramRow));
+			memset(depthRow, 0, sizeof(depthRow));
 
-				dw.DeepFilter(dw.m_BlueDeep, dw.m_BlueDeepNoise);
-				dw.DeepResolve(dw.m_BlueDeep, dw.m_BlueDeepPra, dw.m_BlueDeepNoise);
-				dw.DeepOptimize(dw.m_BlueDeep, dw.m_BlueDeepPra);
+			//ͨδԭʼ˲ȡ⡢ͨ˹ֽˮ
+			for (int ch = 0; ch < 2; ch++)
+			{
+				vector<float> &wave = (ch == 0) ? mywave.m_BlueWave : mywave.m_GreenWave;
+				float &noise = (ch == 0) ? mywave.m_BlueNoise : mywave.m_GreenNoise;
+				GaussList &gauss = (ch == 0) ? mywave.m_BlueGauPra : mywave.m_GreenGauPra;
+				float &chDepth = (ch == 0) ? mywave.blueDepth : mywave.greenDepth;
+
+				memcpy(rawRow[ch], wave.data(), sizeof(rawRow[ch]));
+				mywave.FilterWithRegion(wave, noise, ret);
+				stats.lap(STAGE_FILTER);
+				memcpy(filteredRow[ch], wave.data(), sizeof(filteredRow[ch]));
+				regionRow[ch][0] = ret[0];
+				regionRow[ch][1] = ret[1];
+
+				for (int stage = 0; stage < 2; stage++)
+				{
+					if (stage == 0)
+					{
+						mywave.Resolve(wave, gauss, noise);
+						stats.lap(STAGE_RESOLVE);
+						mywave.CalcuDepthByGauss(gauss, chDepth);
+						stats.lap(STAGE_DEPTH);
+						depthRow[ch][0] = chDepth;
+					}
+					else
+					{
+						mywave.Optimize(wave, gauss);
+						stats.lap(STAGE_OPTIMIZE);
+					}
+
+					int n = min((int)gauss.size(), DebugMaxComponent);
+					for (int k = 0; k < n; k++)
+					{
+						paramRow[ch][stage][k][0] = gauss[k].A;
+						paramRow[ch][stage][k][1] = gauss[k].b;
+						paramRow[ch][stage][k][2] = gauss[k].sigma;
+					}
+					countRow[ch][stage] = n;
+					GaussianCurve(gauss.data(), (int)gauss.size(), sumRow[ch][stage], DebugWaveLength);
+				}
+			}
 
-				dw.CalcuDeepDepth(dw.m_BlueDeepPra, dw.blueDeepDepth);
+			//ѡȡͨˮ
+			switch (bgflag) {
+			case BLUE:
+				mywave.CalcuDepth(mywave.m_BlueGauPra, mywave.blueDepth);
+				stats.lap(STAGE_DEPTH);
+				depthRow[0][1] = mywave.blueDepth;
 				break;
 			case GREEN:
-				DeepWave::ostreamFlag = GREEN;
-
-				dw.DeepFilter(dw.m_GreenDeep, dw.m_GreenDeepNoise);
-				dw.DeepResolve(dw.m_GreenDeep, dw.m_GreenDeepPra, dw.m_GreenDeepNoise);
-				dw.DeepOptimize(dw.m_GreenDeep, dw.m_GreenDeepPra);
-
-				dw.CalcuDeepDepth(dw.m_GreenDeepPra, dw.greenDeepDepth);
+				mywave.CalcuDepth(mywave.m_GreenGauPra, mywave.greenDepth);
+				stats.lap(STAGE_DEPTH);
+				depthRow[1][1] = mywave.greenDepth;
 				break;
 			default:
 				break;
 			}
 
-			//Ϣļ
-			output_stream << dw;
+			raw.append(rawRow, 1);
+			filtered.append(filteredRow, 1);
+			params.append(paramRow, 1);
+			count.append(countRow, 1);
+			sum.append(sumRow, 1);
+			region.append(regionRow, 1);
+			depth.append(depthRow, 1);
+			time.append(&mywave.m_unixTime, 1);
+			stats.lap(STAGE_WRITE);
+
+			stats.frameDone((bgflag == BLUE ? mywave.blueDepth : mywave.greenDepth) == 0, mywave.m_LMIterations);
+			allocProbe.frameDone();
 
 			//ļָƫһ֡ݵֽ2688/8
 			j += 336;
 
-			//ӡÿ
-			printf("%5.2f%%", (float)j / (length / 800));
-			printf("\b\b\b\b\b\b");
+			//ӡʾֵ仯ʱŴӡ
+			stats.progress(j * 8);
 
 		}
 		else
 		{
 			//ܻλزݣuint16_t[CH.nL1] -> 2*n
-			j += 2;
+			uint64_t next = skipToHeader(m_filePtr, j);
+			stats.resync((next - j) * 8);
+			j = next;
 		}
 
 	} while (!feof(m_filePtr));
@@ -766,112 +1358,129 @@ void ReadFile::readDeep()
 	//ļ˳
 	if (feof(m_filePtr) == 1)
 	{
-		printf("Finished!\n");
+		stats.progress(length);
+		stats.lap(STAGE_SCAN);
+		raw.close();
+		filtered.close();
+		params.close();
+		count.close();
+		sum.close();
+		region.close();
+		depth.close();
+		time.close();
+		stats.lap(STAGE_WRITE);
+		allocProbe.report();
+		stats.report();
+		printf("finished!\n");
 	}
 }
 
 
 /*************************************************
-Function:       ˮCH1CH2CH3ͨϴ
-Description:	ͨȷˮ棬ͨı׼СѡӦͨˮ
+Function:       ˮCH2CH3ͨϴ
+Description:	ȡͨݣͨı׼СѡӦͨˮ
 Input:
-Output:			CH1,CH2orCH3ͨЧˮ
+Output:			CH2,CH3ͨЧˮ
 *************************************************/
-void ReadFile::readDeepByRed()
+void ReadFile::readDeep()
 {
-	unsigned _int64 j = 0;
-	HS_Lidar hs;
-
 	//ļλָƵļβȡļ
-	unsigned _int64 length;
+	uint64_t length;
 	_fseeki64(m_filePtr, 0L, SEEK_END);
 	length = _ftelli64(m_filePtr);
-	printf("ReadDeepByRedProcessing:");
-
-
-	//ȶ output_stream  ios::out ʾ,ios::appʾļβ
-	fstream output_stream;
-	output_stream.open("DeepByRedOut.txt", ios::out);
-
-	int bgflag;
-	float blueStd, greenStd;
-
-
-	//ļȡ
-	do {
-		_fseeki64(m_filePtr, j * 8, SEEK_SET);
+	printf("ReadDeepProcessing:");
 
-		//Ѱ֡ͷ
-		uint8_t header[8];
-		memset(header, 0, sizeof(uint8_t) * 8);
-		fread(header, sizeof(uint8_t), 8, m_filePtr);
-		if (isHeaderRight(header))
-		{
-			//ݵ̣
-			_fseeki64(m_filePtr, -8, SEEK_CUR);
-			hs.initDeepData(m_filePtr);
 
-			//ȡͨˮλز
-			DeepWave dw;
-			dw.GetDeepData(hs);
+	//õĸʽд
+	unique_ptr<ResultSink> sink(CreateResultSink(m_outputFormat));
+	sink->open(outputPath("DeepOut").c_str(), m_writeOptions);
 
-			//ȡˮ
-			dw.GetRedTime(dw.m_RedDeep, dw.redTime);
+	//׶ͳ
+	RunStats stats("Deep", m_filename.c_str(), length, statsOptions("Deep"));
 
-			//process
-			blueStd = calculateSigma(dw.m_BlueDeep);
-			greenStd = calculateSigma(dw.m_GreenDeep);
+	//̳֡߳ʱֶβУ֡˳д
+	readFrames(FRAME_DEEP, stats, [&](FrameSlot &slot) { sink->writeShot(slot.deep, slot.bgflag); });
 
-			blueStd >= 1.2*greenStd ? bgflag = BLUE : bgflag = GREEN;//жֵ
+	//ļ˳
+	if (feof(m_filePtr) == 1)
+	{
+		stats.progress(length);
+		stats.lap(STAGE_SCAN);
+		sink->close();
+		stats.lap(STAGE_WRITE);
+		stats.report();
+		printf("Finished!\n");
+	}
+}
 
-			switch (bgflag)
-			{
-			case BLUE:
-				DeepWave::ostreamFlag = BLUE;
 
-				dw.DeepFilter(dw.m_BlueDeep, dw.m_BlueDeepNoise);
-				dw.DeepResolve(dw.m_BlueDeep, dw.m_BlueDeepPra, dw.m_BlueDeepNoise);
-				dw.DeepOptimize(dw.m_BlueDeep, dw.m_BlueDeepPra);
+/*************************************************
+Function:       ˮCH1CH2CH3ͨϴ
+Description:	ͨȷˮ棬ͨı׼СѡӦͨˮ
+Input:
+Output:			CH1,CH2orCH3ͨЧˮ
+*************************************************/
+void ReadFile::readDeepByRed()
+{
+	//ļλָƵļβȡļ
+	uint64_t length;
+	_fseeki64(m_filePtr, 0L, SEEK_END);
+	length = _ftelli64(m_filePtr);
+	printf("ReadDeepByRedProcessing:");
 
-				dw.CalcuDeepDepthByRed(dw.m_BlueDeepPra, dw.redTime, dw.blueDeepDepth);
-				break;
-			case GREEN:
-				DeepWave::ostreamFlag = GREEN;
 
-				dw.DeepFilter(dw.m_GreenDeep, dw.m_GreenDeepNoise);
-				dw.DeepResolve(dw.m_GreenDeep, dw.m_GreenDeepPra, dw.m_GreenDeepNoise);
-				dw.DeepOptimize(dw.m_GreenDeep, dw.m_GreenDeepPra);
+	//õĸʽд
+	unique_ptr<ResultSink> sink(CreateResultSink(m_outputFormat));
+	sink->open(outputPath("DeepByRedOut").c_str(), m_writeOptions);
 
-				dw.CalcuDeepDepthByRed(dw.m_GreenDeepPra, dw.redTime, dw.greenDeepDepth);
-				break;
-			default:
-				break;
-			}
+	//׶ͳ
+	RunStats stats("DeepByRed", m_filename.c_str(), length, statsOptions("DeepByRed"));
 
-			//Ϣļ
-			output_stream << dw;
+	//̳֡߳ʱֶβУ֡˳д
+	readFrames(FRAME_DEEP_BY_RED, stats, [&](FrameSlot &slot) { sink->writeShot(slot.deep, slot.bgflag); });
 
-			//ļָƫһ֡ݵֽ2688/8
-			j += 336;
+	//ļ˳
+	if (feof(m_filePtr) == 1)
+	{
+		stats.progress(length);
+		stats.lap(STAGE_SCAN);
+		sink->close();
+		stats.lap(STAGE_WRITE);
+		stats.report();
+		printf("Finished!\n");
+	}
+}
 
-			//ӡÿ
-			printf("%5.2f%%", (float)j / (length / 800));
-			printf("\b\b\b\b\b\b");
 
+/*************************************************
+Function:       λдһˮ׵
+Description:    ʱˮ׵ռȫͳһд
+                ֱдLASƣXȣYγȣZߣUTM꣨ͶӰʱγȣ
+                ۼӵˮ֮
+Input:          georef:λ batch:λļ
+Output:         index:ռ las:LAS grid:ˮ
+*************************************************/
+static void writeGeoBatch(Georeferencer &georef, GeoBatch &batch, SpatialIndex &index, LasWriter &las, DepthGrid &grid)
+{
+	TraceScope trace("writeGeoBatch");
+	georef.run(batch);
+	const double *gridX = georef.projected() ? batch.bottomEast.data() : batch.bottomLon.data();
+	const double *gridY = georef.projected() ? batch.bottomNorth.data() : batch.bottomLat.data();
+	for (size_t i = 0; i < batch.size(); i++)
+	{
+		if (index.isOpen())
+		{
+			IndexedPoint point = { gridX[i], gridY[i], batch.bottomLon[i], batch.bottomLat[i],
+				batch.gpsTime[i] - LasGPSTimeOffset, batch.bottomHeight[i], batch.depth[i] };
+			index.add(point);
 		}
 		else
 		{
-			//ܻλزݣuint16_t[CH.nL1] -> 2*n
-			j += 2;
+			las.writePoint(batch.bottomLon[i], batch.bottomLat[i], batch.bottomHeight[i], batch.gpsTime[i] - LasGPSTimeOffset);
+			grid.add(gridX[i], gridY[i], batch.depth[i]);
 		}
-
-	} while (!feof(m_filePtr));
-
-	//ļ˳
-	if (feof(m_filePtr) == 1)
-	{
-		printf("Finished!\n");
 	}
+	batch.clear();
 }
 
 
@@ -879,133 +1488,100 @@ void ReadFile::readDeepByRed()
 Function:       ˮCH1CH2CH3ͨϴ
 Description:	ͨȷˮ棬ͨı׼СѡӦͨˮ
 Input:
-Output:			ƸʽX,Y,Z
+Output:			LASļDeepOut.lasX,Yγ,Zˮߣ޳ĵΪˮDeepGrid.tif
 *************************************************/
 void ReadFile::readDeepOutLas()
 {
-	unsigned _int64 j = 0;
-	HS_Lidar hs;
-
 	//ļλָƵļβȡļ
-	unsigned _int64 length;
+	uint64_t length;
 	_fseeki64(m_filePtr, 0L, SEEK_END);
 	length = _ftelli64(m_filePtr);
 	printf("ReadDeepOutLasProcessing:");
 
 
-	//ȶ output_stream  ios::out ʾ,ios::appʾļβ
-	fstream las_stream;
-	las_stream.open("las2txt.txt", ios::out);
+	//ֱдLASļ
+	LasWriter las;
+	las.open(outputPath("DeepOut.las").c_str(), m_lasPointFormat, m_writeOptions);
 
-	int bgflag;
-	float blueStd, greenStd;
-
-	//Чˮļƽˮ
-	int count = 0;
-	float avedepth = 0;
-	double tmpX = 0.0;
-	double tmpY = 0.0;
+	//ۼˮ
+	DepthGrid grid;
+	if (m_gridOptions.format != GRID_NONE)
+	{
+		grid.open(outputPath("DeepGrid").c_str(), m_gridOptions, m_writeOptions);
+	}
 
-	//ļȡ
-	do {
-		_fseeki64(m_filePtr, j * 8, SEEK_SET);
+	//Чˮλδָʱȡ˵
+	GeoOptions geoOptions = m_geoOptions;
+	if (isnan(geoOptions.scanAngle))
+	{
+		geoOptions.scanAngle = angle;
+	}
+	Georeferencer georef(geoOptions);
+	GeoBatch batch;
+	batch.reserve(GeoBatchSize);
 
-		//Ѱ֡ͷ
-		uint8_t header[8];
-		memset(header, 0, sizeof(uint8_t) * 8);
-		fread(header, sizeof(uint8_t), 8, m_filePtr);
+	//ˮ׵飺޳ڵ㲻ĹƫֵȺ
+	SpatialIndex index;
+	if (m_qaOptions.enabled)
+	{
+		index.open(outputPath("DeepIndex.spill").c_str(), m_qaOptions);
+	}
 
+	//׶ͳ
+	RunStats stats("DeepOutLas", m_filename.c_str(), length, statsOptions("DeepOutLas"));
 
-		if (isHeaderRight(header))
+	//DeepByRedͬĴ̣Чˮ֡˳붨λ
+	readFrames(FRAME_DEEP_BY_RED, stats, [&](FrameSlot &slot)
+	{
+		if (!slot.rejected)
 		{
-			//ݵ̣
-			_fseeki64(m_filePtr, -8, SEEK_CUR);
-			hs.initDeepData(m_filePtr);
-
-			//ȡͨˮλز
-			DeepWave dw;
-			dw.GetDeepData(hs);
-
-			//γȷ仯ʱþγȵƽЧˮ
-			if ((!isEqual(hs.header.dX, tmpX) || !isEqual(hs.header.dY, tmpY)) && (count > 0))
-			{
-				tmpX = hs.header.dX;
-				tmpY = hs.header.dY;
-				//
-				las_stream << setiosflags(ios::fixed) << setiosflags(ios::showpoint) << setprecision(6) << tmpX << " " << tmpY << " " << setprecision(3) << avedepth / count << endl;
-
-			}
-
-			//ȡˮ
-			dw.GetRedTime(dw.m_RedDeep, dw.redTime);
-
-			//process
-			blueStd = calculateSigma(dw.m_BlueDeep);
-			greenStd = calculateSigma(dw.m_GreenDeep);
-
-			blueStd >= 1.2*greenStd ? bgflag = BLUE : bgflag = GREEN;//жֵ
-
-			switch (bgflag)
-			{
-			case BLUE:
-				DeepWave::ostreamFlag = BLUE;
-
-				dw.DeepFilter(dw.m_BlueDeep, dw.m_BlueDeepNoise);
-				dw.DeepResolve(dw.m_BlueDeep, dw.m_BlueDeepPra, dw.m_BlueDeepNoise);
-				dw.DeepOptimize(dw.m_BlueDeep, dw.m_BlueDeepPra);
-
-				dw.CalcuDeepDepthByRed(dw.m_BlueDeepPra, dw.redTime, dw.blueDeepDepth);
-
-				//Чˮһ
-				if (dw.blueDeepDepth != 0)
-				{
-					avedepth += dw.blueDeepDepth;
-					count++;
-				}
-
-				break;
-			case GREEN:
-				DeepWave::ostreamFlag = GREEN;
-
-				dw.DeepFilter(dw.m_GreenDeep, dw.m_GreenDeepNoise);
-				dw.DeepResolve(dw.m_GreenDeep, dw.m_GreenDeepPra, dw.m_GreenDeepNoise);
-				dw.DeepOptimize(dw.m_GreenDeep, dw.m_GreenDeepPra);
-
-				dw.CalcuDeepDepthByRed(dw.m_GreenDeepPra, dw.redTime, dw.greenDeepDepth);
-
-				//Чˮһ
-				if (dw.greenDeepDepth != 0)
-				{
-					avedepth += dw.blueDeepDepth;
-					count++;
-				}
-
-				break;
-			default:
-				break;
-			}
-
-
-			//ļָƫһ֡ݵֽ2688/8
-			j += 336;
-
-			//ӡÿ
-			printf("%5.2f%%", (float)j / (length / 800));
-			printf("\b\b\b\b\b\b");
-
+			batch.push(slot.hs.header, slot.deep.waterTime);
 		}
-		else
+		if (batch.size() >= GeoBatchSize)
 		{
-			//ܻλزݣuint16_t[CH.nL1] -> 2*n
-			j += 2;
+			writeGeoBatch(georef, batch, index, las, grid);
 		}
-
-	} while (!feof(m_filePtr));
+	});
 
 	//ļ˳
 	if (feof(m_filePtr) == 1)
 	{
-		las_stream.close();
+		stats.progress(length);
+		stats.lap(STAGE_SCAN);
+		writeGeoBatch(georef, batch, index, las, grid);
+		if (index.isOpen())
+		{
+			//޳ĵ㰴дLASֻͨĵˮ
+			QaStats qa = index.filter(m_pool, [&](const IndexedPoint &point, int flag)
+			{
+				las.writePoint(point.lon, point.lat, point.height, point.gpsTime, flag != QA_ACCEPTED);
+				if (flag == QA_ACCEPTED)
+				{
+					grid.add(point.x, point.y, point.depth);
+				}
+			});
+			index.close();
+			printf("\nQA: %llu points, %llu isolated, %llu outliers, %llu spilled to disk.\n",
+				(unsigned long long)qa.points, (unsigned long long)qa.isolated,
+				(unsigned long long)qa.outliers, (unsigned long long)qa.spilledPoints);
+		}
+		las.close();
+		if (grid.isOpen())
+		{
+			if (m_gridOptions.epsg == 0)
+			{
+				grid.setEpsg(georef.epsg());
+			}
+			uint64_t points = grid.pointCount();
+			uint64_t tiles = grid.tileCount();
+			uint64_t pageOuts = grid.pageOuts();
+			bool ok = grid.close();
+			printf("\nGrid: %lld x %lld cells, %llu points in %llu tiles, %llu tiles paged out%s.\n",
+				(long long)grid.width(), (long long)grid.height(), (unsigned long long)points,
+				(unsigned long long)tiles, (unsigned long long)pageOuts, ok ? "" : ", write failed");
+		}
+		stats.lap(STAGE_WRITE);
+		stats.report();
 		printf("Finished!\n");
 	}
 }
\ No newline at end of file
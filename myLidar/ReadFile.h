@@ -4,15 +4,34 @@
 #include <iostream>
 #include "WaveData.h"
 #include "DeepWave.h"
+#include "ResultSink.h"
+#include "DepthGrid.h"
+#include "Georeference.h"
+#include "SpatialIndex.h"
+#include "RunStats.h"
+#include "WorkerPool.h"
 #include <iomanip>
+#include <string>
 using namespace std;
 
+struct FrameSlot;
+struct FrameChunk;
+
 class ReadFile
 {
 public:
 	ReadFile();
 	~ReadFile();
-	bool setFilename(char filename[100]);
+	bool setFilename(const char *filename);
+	void setOutputPrefix(const string &prefix);	//ļǰ׺ɺĿ¼ļʱָļĽ
+	void setWorkerPool(WorkerPool *pool, int batchSize);	//ô̳߳أÿдbatchSize֡poolΪNULLʱ֡
+	void setOutputFormat(OutputFormat format);	//ˮʽ
+	void setWriteOptions(const WriteOptions &options);	//дļѡ̨дֱд̡С
+	void setLasPointFormat(int pointFormat);	//LASʽ61
+	void setGridOptions(const GridOptions &options);	//ˮѡʽࡢֿ顢ڴޣ
+	void setGeoOptions(const GeoOptions &options);	//ˮ׵㶨λǡװƫˮߡʣ
+	void setQaOptions(const QaOptions &options);	//ˮ׵ѡ뾶ڵ㡢MADֵ
+	void setStatsOptions(const StatsOptions &options);	//ͳѡJSON·
 	void readBlueAll();
 	void readGreenAll();
 	void readMix();
@@ -21,6 +40,36 @@ public:
 	void readDeepByRed();
 	void readDeepOutLas();
 private:
-	char *m_filename;
+	//ģʽõĴ
+	enum FrameMode
+	{
+		FRAME_BLUE,
+		FRAME_GREEN,
+		FRAME_MIX,
+		FRAME_DEEP,
+		FRAME_DEEP_BY_RED
+	};
+
+	void outputDataNpy();			//׶ݣNumPy飩
+	string outputPath(const char *name) const;	//ǰ׺ļ
+	StatsOptions statsOptions(const char *mode) const;	//ļģʽͳѡ
+	void readFrames(FrameMode mode, RunStats &stats, const function<void(FrameSlot &)> &commit);	//ȡȫ֡֡˳д
+	void readChunks(FrameMode mode, RunStats &stats, const function<void(FrameSlot &)> &commit);	//ֶβжȡ֡˳д
+	static void scanChunk(FrameMode mode, FILE *fp, FrameChunk &chunk);	//ȡһе̳֡߳У
+	static void readFrame(FrameMode mode, FILE *fp, HS_Lidar &hs);		//һ֡
+	template <class Timer>
+	static void processFrame(FrameMode mode, FrameSlot &slot, Timer &timing);	//һ֡׶κʱtiming
+
+	string m_filename;
 	FILE *m_filePtr;
+	string m_outputPrefix;			//ļǰ׺
+	WorkerPool *m_pool;				//̳߳أNULLΪ֡
+	int m_batchSize;				//ÿд֡
+	OutputFormat m_outputFormat;	//ˮʽ
+	WriteOptions m_writeOptions;	//дļѡ
+	int m_lasPointFormat;			//LASʽ
+	GridOptions m_gridOptions;		//ˮѡ
+	GeoOptions m_geoOptions;		//ˮ׵㶨λ
+	QaOptions m_qaOptions;			//ˮ׵ѡ
+	StatsOptions m_statsOptions;	//ͳѡ
 };
\ No newline at end of file
@@ -0,0 +1,211 @@
+/*************************************************
+Description:ˮıƣ
+**************************************************/
+#include "ResultSink.h"
+#include "Trace.h"
+#include <stdio.h>
+#include <string.h>
+
+#define BLUE true
+#define GREEN false
+
+#define TextHeadLength 128		//ı¼ʱ䡢ˮⲿֵ󳤶
+#define TextFieldLength 16		//ı󳤶ȣ" "+%g+ǣ
+
+
+//׷11ַӽβ012ֽڣ
+static char *appendInt(char *p, int value)
+{
+	return p + snprintf(p, 12, "%d", value);
+}
+
+//׷ӸostreamĬϸʽͬ%g6λЧ֣
+static char *appendFloat(char *p, float value)
+{
+	return p + snprintf(p, 14, "%g", (double)value);
+}
+
+//׷ʱ䣺   ʱ  
+static char *appendTime(char *p, const Time &t)
+{
+	p = appendInt(p, t.year); *p++ = ' ';
+	p = appendInt(p, t.month); *p++ = ' ';
+	p = appendInt(p, t.day); *p++ = ' ';
+	p = appendInt(p, t.hour); *p++ = ' ';
+	p = appendInt(p, t.minute); *p++ = ' ';
+	return appendInt(p, t.second);
+}
+
+//׷ˮ
+static char *appendDepth(char *p, float depth)
+{
+	*p++ = ' ';
+	p = appendFloat(p, depth);
+	*p++ = 'm';
+	return p;
+}
+
+
+/*************************************************
+Function:       ıļ
+Description:    ıʽ򿪣зԭfstreamһ
+Input:          baseName:չļ options:дļѡ
+Output:         Ƿ򿪳ɹ
+*************************************************/
+bool TextResultSink::open(const char *baseName, const WriteOptions &options)
+{
+	char path[260];
+	snprintf(path, sizeof(path), "%s.txt", baseName);
+	return m_file.open(path, "w", options);
+}
+
+
+void TextResultSink::writeShot(const WaveData &wave, bool channel)
+{
+	TraceScope trace("writeShot");
+	const GaussList &param = (channel == BLUE) ? wave.m_BlueGauPra : wave.m_GreenGauPra;
+	char *begin = m_file.reserve(TextHeadLength + TextFieldLength * param.size());
+	char *p = appendTime(begin, wave.m_time);
+	p = appendDepth(p, (channel == BLUE) ? wave.blueDepth : wave.greenDepth);
+	for (auto &g : param)
+	{
+		*p++ = ' ';
+		p = appendFloat(p, g.b);
+		*p++ = g.wavetype ? 'S' : 'B';
+	}
+	*p++ = '\n';
+	m_file.commit(p - begin);
+}
+
+
+void TextResultSink::writeShot(const DeepWave &deep, bool channel)
+{
+	TraceScope trace("writeShot");
+	const vector<float> &param = (channel == BLUE) ? deep.m_BlueDeepPra : deep.m_GreenDeepPra;
+	char *begin = m_file.reserve(TextHeadLength + TextFieldLength * param.size());
+	char *p = appendTime(begin, deep.m_time);
+	p = appendDepth(p, (channel == BLUE) ? deep.blueDeepDepth : deep.greenDeepDepth);
+
+	//ͨ
+	if (deep.redTime != 0)
+	{
+		*p++ = ' ';
+		p = appendInt(p, deep.redTime);
+		*p++ = ' ';
+		*p++ = '|';
+	}
+
+	for (float b : param)
+	{
+		*p++ = ' ';
+		p = appendFloat(p, b);
+	}
+	*p++ = '\n';
+	m_file.commit(p - begin);
+}
+
+
+bool TextResultSink::close()
+{
+	return m_file.close();
+}
+
+
+/*************************************************
+Function:       򿪶ļ
+Description:    дļͷ֮֡׷Ӷ¼
+Input:          baseName:չļ options:дļѡ
+Output:         Ƿ򿪳ɹ
+*************************************************/
+bool BinaryResultSink::open(const char *baseName, const WriteOptions &options)
+{
+	static_assert(sizeof(ResultFileHeader) == 32, "ResultFileHeader must be 32 bytes");
+	static_assert(sizeof(ShotRecord) == 120, "ShotRecord must be 120 bytes");
+
+	char path[260];
+	snprintf(path, sizeof(path), "%s.bin", baseName);
+	if (!m_file.open(path, "wb", options))
+	{
+		return false;
+	}
+
+	ResultFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "HSRESULT", 8);
+	header.version = 1;
+	header.recordSize = sizeof(ShotRecord);
+	header.componentMax = ResultMaxComponent;
+	m_file.write(&header, sizeof(header));
+	return true;
+}
+
+
+void BinaryResultSink::writeShot(const WaveData &wave, bool channel)
+{
+	TraceScope trace("writeShot");
+	const GaussList &param = (channel == BLUE) ? wave.m_BlueGauPra : wave.m_GreenGauPra;
+	ShotRecord record;
+	memset(&record, 0, sizeof(ShotRecord));
+	record.unixTime = wave.m_unixTime;
+	record.channel = (channel == BLUE) ? 2 : 3;
+	record.totalCount = (uint8_t)min<size_t>(param.size(), 255);
+	record.depth = (channel == BLUE) ? wave.blueDepth : wave.greenDepth;
+
+	size_t count = min<size_t>(param.size(), ResultMaxComponent);
+	for (size_t i = 0; i < count; i++)
+	{
+		record.param[i][0] = param[i].A;
+		record.param[i][1] = param[i].b;
+		record.param[i][2] = param[i].sigma;
+		if (param[i].wavetype)
+		{
+			record.surfaceMask |= 1u << i;
+		}
+	}
+	record.count = (uint8_t)count;
+	m_file.write(&record, sizeof(ShotRecord));
+}
+
+
+void BinaryResultSink::writeShot(const DeepWave &deep, bool channel)
+{
+	TraceScope trace("writeShot");
+	const vector<float> &param = (channel == BLUE) ? deep.m_BlueDeepPra : deep.m_GreenDeepPra;
+	const vector<float> &wave = (channel == BLUE) ? deep.m_BlueDeep : deep.m_GreenDeep;
+	ShotRecord record;
+	memset(&record, 0, sizeof(ShotRecord));
+	record.unixTime = deep.m_unixTime;
+	record.channel = (channel == BLUE) ? 2 : 3;
+	record.totalCount = (uint8_t)min<size_t>(param.size(), 255);
+	record.depth = (channel == BLUE) ? deep.blueDeepDepth : deep.greenDeepDepth;
+	record.redTime = (float)deep.redTime;
+
+	size_t count = min<size_t>(param.size(), ResultMaxComponent);
+	for (size_t i = 0; i < count; i++)
+	{
+		int index = (int)param[i];
+		record.param[i][0] = (index >= 0 && index < (int)wave.size()) ? wave[index] : 0;
+		record.param[i][1] = param[i];
+	}
+	record.count = (uint8_t)count;
+	m_file.write(&record, sizeof(ShotRecord));
+}
+
+
+bool BinaryResultSink::close()
+{
+	return m_file.close();
+}
+
+
+ResultSink *CreateResultSink(OutputFormat format)
+{
+	switch (format)
+	{
+	case OUTPUT_BINARY:
+		return new BinaryResultSink();
+	case OUTPUT_TEXT:
+	default:
+		return new TextResultSink();
+	}
+}
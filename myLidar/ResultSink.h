@@ -0,0 +1,86 @@
+#pragma once
+#include <stdint.h>
+#include <memory>
+#include "WaveData.h"
+#include "DeepWave.h"
+#include "BufferedFile.h"
+using namespace std;
+
+
+//ʽ
+enum OutputFormat
+{
+	OUTPUT_TEXT,		//ıԭĸʽͬ
+	OUTPUT_BINARY		//¼
+};
+
+
+#define ResultMaxComponent 8	//Ƽ¼бķޣֻtotalCount
+
+
+//ƽļͷ32ֽڣ
+struct ResultFileHeader
+{
+	char magic[8];			//"HSRESULT"
+	uint32_t version;		//ʽ汾ǰΪ1
+	uint32_t recordSize;	//¼ֽ
+	uint32_t componentMax;	//¼ķ
+	uint32_t reserved[3];
+};
+
+//ƽ¼120ֽڣСˣ
+struct ShotRecord
+{
+	int64_t unixTime;		//UTCʱ䣨UnixԪ
+	uint8_t channel;		//ͨţ2ΪCH2ͨ3ΪCH3ͨ
+	uint8_t count;			//¼еķ
+	uint8_t totalCount;		//ʵʷ255Ϊ255
+	uint8_t reserved;
+	uint32_t surfaceMask;	//ǷΪˮزiλӦi
+	float depth;			//ˮm
+	float redTime;			//ͨˮ㣬ǳˮ¼Ϊ0
+	float param[ResultMaxComponent][3];	//A b sigmaˮ¼bΪֵλãAΪô˲ֵsigmaΪ0
+};
+
+
+//ӿڣ֡writeShotʱclose
+//channelΪtrueʱCH2ͨfalseʱCH3ͨ
+class ResultSink
+{
+public:
+	virtual ~ResultSink() {}
+	virtual bool open(const char *baseName, const WriteOptions &options) = 0;	//baseNameչɸʽ
+	virtual void writeShot(const WaveData &wave, bool channel) = 0;
+	virtual void writeShot(const DeepWave &deep, bool channel) = 0;
+	virtual bool close() = 0;
+};
+
+
+//ıʽWaveData/DeepWaveoperator<<ͬʽд
+class TextResultSink : public ResultSink
+{
+public:
+	bool open(const char *baseName, const WriteOptions &options);
+	void writeShot(const WaveData &wave, bool channel);
+	void writeShot(const DeepWave &deep, bool channel);
+	bool close();
+private:
+	BufferedFile m_file;
+};
+
+
+//ļͷӶShotRecord
+class BinaryResultSink : public ResultSink
+{
+public:
+	bool open(const char *baseName, const WriteOptions &options);
+	void writeShot(const WaveData &wave, bool channel);
+	void writeShot(const DeepWave &deep, bool channel);
+	bool close();
+private:
+	BufferedFile m_file;
+};
+
+
+//ʽ
+ResultSink *CreateResultSink(OutputFormat format);
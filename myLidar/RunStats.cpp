@@ -0,0 +1,464 @@
+/*************************************************
+Description:׶ͳ
+                ׶κʱֲϼơСp50p99֡ʡֽʡLM
+                ЧˮֽͬʱдJSONɰ
+**************************************************/
+#include "RunStats.h"
+#include "Trace.h"
+#include "SimdKernels.h"
+#include <math.h>
+#include <string.h>
+#include <chrono>
+#include <algorithm>
+#include <mutex>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+static const char *stageNames[StageCount] = { "scan", "decode", "filter", "resolve", "optimize", "depth", "write" };
+
+
+const char *StageName(int stage)
+{
+	return (stage >= 0 && stage < StageCount) ? stageNames[stage] : "unknown";
+}
+
+
+RunTotals::RunTotals()
+{
+	memset(this, 0, sizeof(*this));
+}
+
+
+void RunTotals::add(const RunTotals &other)
+{
+	runs += other.runs;
+	frames += other.frames;
+	bytes += other.bytes;
+	iterations += other.iterations;
+	rejected += other.rejected;
+	resyncBytes += other.resyncBytes;
+	seconds += other.seconds;
+	for (int i = 0; i < StageCount; i++)
+		stageNs[i] += other.stageNs[i];
+}
+
+
+//ʱӣns
+static int64_t nowNs()
+{
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+//Чλλãns >= 1
+static int highestBit(uint64_t ns)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse64(&index, ns);
+	return (int)index;
+#else
+	return 63 - __builtin_clzll(ns);
+#endif
+}
+
+
+//ʱڵͰСStageLinearBucketsʱÿnsһͰ֮ÿ2ΪStageSubBucketsͰ
+static int bucketOf(uint64_t ns)
+{
+	if (ns < StageLinearBuckets)
+		return (int)ns;
+	int e = highestBit(ns);
+	int index = StageLinearBuckets + (e - 4) * StageSubBuckets + (int)((ns >> (e - 3)) & (StageSubBuckets - 1));
+	return min(index, StageBuckets - 1);
+}
+
+
+//Ͱ½
+static uint64_t bucketLow(int index)
+{
+	if (index < StageLinearBuckets)
+		return (uint64_t)index;
+	int e = 4 + (index - StageLinearBuckets) / StageSubBuckets;
+	int sub = (index - StageLinearBuckets) % StageSubBuckets;
+	return (uint64_t)(StageSubBuckets + sub) << (e - 3);
+}
+
+
+StageHistogram::StageHistogram()
+{
+	count = 0;
+	total = 0;
+	min = UINT64_MAX;
+	max = 0;
+	m_buckets.assign(StageBuckets, 0);
+}
+
+
+void StageHistogram::add(uint64_t ns)
+{
+	count++;
+	total += ns;
+	if (ns < min)
+		min = ns;
+	if (ns > max)
+		max = ns;
+	m_buckets[bucketOf(ns)]++;
+}
+
+
+uint64_t StageHistogram::percentile(double p) const
+{
+	if (count == 0)
+		return 0;
+	uint64_t rank = (uint64_t)ceil(p * count);
+	if (rank < 1)
+		rank = 1;
+	uint64_t seen = 0;
+	for (int i = 0; i < StageBuckets; i++)
+	{
+		seen += m_buckets[i];
+		if (seen >= rank)
+		{
+			uint64_t low = bucketLow(i);
+			uint64_t high = (i + 1 < StageBuckets) ? bucketLow(i + 1) : low + 1;
+			uint64_t mid = low + (high - low) / 2;
+			return std::min(std::max(mid, min), max);
+		}
+	}
+	return max;
+}
+
+
+RunStats::RunStats(const char *mode, const char *filename, uint64_t fileBytes, const StatsOptions &options)
+	: m_mode(mode), m_filename(filename ? filename : ""), m_fileBytes(fileBytes), m_options(options)
+{
+	m_frames = 0;
+	m_rejected = 0;
+	m_iterations = 0;
+	m_resyncBytes = 0;
+	m_position = 0;
+	m_progress = -1;
+	m_sampleFrames = 0;
+	m_samplePosition = 0;
+	m_frameStages = 0;
+	for (int i = 0; i < StageCount; i++)
+		m_frameNs[i] = 0;
+	memset(m_stageCounters, 0, sizeof(m_stageCounters));
+	memset(&m_lastCounters, 0, sizeof(m_lastCounters));
+
+	//ʱֻͳƺʱ
+	if (m_options.counters)
+	{
+		if (m_counters.open())
+			m_counters.read(m_lastCounters);
+		else
+			printf("Hardware counters unavailable (%s), reporting wall time only.\n", m_counters.error().c_str());
+	}
+	m_start = nowNs();
+	m_last = m_start;
+	m_lastSample = m_start;
+}
+
+
+void RunStats::lap(int stage)
+{
+	int64_t now = nowNs();
+	if (TraceEnabled())
+		TraceRecord(stageNames[stage], m_last, now - m_last, 'X');
+	m_frameNs[stage] += (uint64_t)(now - m_last);
+	m_frameStages |= 1u << stage;
+	m_last = now;
+
+	PerfSample sample;
+	if (m_counters.isOpen() && m_counters.read(sample))
+	{
+		for (int e = 0; e < PerfEventCount; e++)
+			m_stageCounters[stage][e] += sample.value[e] - m_lastCounters.value[e];
+		m_lastCounters = sample;
+	}
+}
+
+
+void RunStats::commitFrame()
+{
+	for (int i = 0; i < StageCount; i++)
+	{
+		if (m_frameStages & (1u << i))
+		{
+			m_stages[i].add(m_frameNs[i]);
+			m_frameNs[i] = 0;
+		}
+	}
+	m_frameStages = 0;
+}
+
+
+void RunStats::frameDone(bool rejected, int iterations)
+{
+	commitFrame();
+	m_frames++;
+	if (rejected)
+		m_rejected++;
+	m_iterations += iterations;
+}
+
+
+/*************************************************
+Function:       벢дһ֡
+Description:	׶κʱΪ֡ڶȡ߳ϵĺʱ֮ͣȴ
+				ܺʱ֡԰ȡ̵߳ʱӼ
+Input:          timing:֡ķֽ׶κʱ rejected:ˮΪ0 iterations:LM
+Output:
+*************************************************/
+void RunStats::frameDone(const FrameTiming &timing, bool rejected, int iterations)
+{
+	for (int i = 0; i < StageCount; i++)
+	{
+		if (timing.stages & (1u << i))
+		{
+			m_frameNs[i] += timing.ns[i];
+			m_frameStages |= 1u << i;
+		}
+	}
+	m_last = nowNs();
+	frameDone(rejected, iterations);
+}
+
+
+void FrameTiming::clear()
+{
+	for (int i = 0; i < StageCount; i++)
+		ns[i] = 0;
+	stages = 0;
+	last = nowNs();
+}
+
+
+void FrameTiming::start()
+{
+	last = nowNs();
+}
+
+
+void FrameTiming::lap(int stage)
+{
+	int64_t now = nowNs();
+	if (TraceEnabled())
+		TraceRecord(stageNames[stage], last, now - last, 'X');
+	ns[stage] += (uint64_t)(now - last);
+	stages |= 1u << stage;
+	last = now;
+}
+
+
+/*************************************************
+Function:       ´
+Description:	Ȱ0.01%ʾֵ仯ʱŴӡ֡printf
+				˲ʱϴβһβһlapʱ̣ʱӣ
+Input:          position:Ѵļλ
+Output:
+*************************************************/
+void RunStats::progress(uint64_t position)
+{
+	m_position = m_fileBytes ? min(position, m_fileBytes) : position;
+	int value = m_fileBytes ? (int)(m_position * 10000 / m_fileBytes) : 0;
+	if (value != m_progress && m_options.progress)
+	{
+		m_progress = value;
+		printf("%5.2f%%", value / 100.0);
+		printf("\b\b\b\b\b\b");
+	}
+	if (m_options.sampleInterval > 0 && (m_last - m_lastSample) * 1e-9 >= m_options.sampleInterval)
+	{
+		sample();
+	}
+}
+
+
+double RunStats::elapsed() const
+{
+	return (m_last - m_start) * 1e-9;
+}
+
+
+//stderrһвۼͱڵ
+void RunStats::sample()
+{
+	double seconds = (m_last - m_lastSample) * 1e-9;
+	fprintf(stderr, "{\"sample\": {\"mode\": \"%s\", \"elapsedSeconds\": %.3f, \"frames\": %llu, \"bytes\": %llu, "
+		"\"progress\": %.4f, \"framesPerSecond\": %.1f, \"bytesPerSecond\": %.1f, \"rejectedShots\": %llu, \"resyncBytes\": %llu}}\n",
+		m_mode.c_str(), elapsed(), (unsigned long long)m_frames, (unsigned long long)m_position,
+		m_fileBytes ? (double)m_position / m_fileBytes : 0.0,
+		(m_frames - m_sampleFrames) / seconds, (m_position - m_samplePosition) / seconds,
+		(unsigned long long)m_rejected, (unsigned long long)m_resyncBytes);
+	fflush(stderr);
+	m_lastSample = m_last;
+	m_sampleFrames = m_frames;
+	m_samplePosition = m_position;
+}
+
+
+//JSONַת壨ļ·еķбܵȣ
+string JsonEscape(const string &text)
+{
+	string out;
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		unsigned char ch = (unsigned char)text[i];
+		if (ch == '"' || ch == '\\')
+		{
+			out += '\\';
+			out += (char)ch;
+		}
+		else if (ch < 0x20)
+		{
+			char buffer[8];
+			snprintf(buffer, sizeof(buffer), "\\u%04x", ch);
+			out += buffer;
+		}
+		else
+			out += (char)ch;
+	}
+	return out;
+}
+
+
+//ĳ׶ÿ֡ƽ
+double RunStats::perShot(int stage, int event) const
+{
+	return m_frames ? (double)m_stageCounters[stage][event] / m_frames : 0.0;
+}
+
+
+bool RunStats::writeJson(const char *path) const
+{
+	FILE *fp = fopen(path, "w");
+	if (fp == NULL)
+	{
+		return false;
+	}
+
+	double seconds = elapsed();
+	fprintf(fp, "{\n");
+	fprintf(fp, "  \"mode\": \"%s\",\n  \"file\": \"%s\",\n", JsonEscape(m_mode).c_str(), JsonEscape(m_filename).c_str());
+	fprintf(fp, "  \"fileBytes\": %llu,\n  \"bytes\": %llu,\n  \"elapsedSeconds\": %.6f,\n",
+		(unsigned long long)m_fileBytes, (unsigned long long)m_position, seconds);
+	fprintf(fp, "  \"frames\": %llu,\n  \"framesPerSecond\": %.1f,\n  \"bytesPerSecond\": %.1f,\n",
+		(unsigned long long)m_frames, seconds > 0 ? m_frames / seconds : 0.0, seconds > 0 ? m_position / seconds : 0.0);
+	fprintf(fp, "  \"lmIterations\": %llu,\n  \"rejectedShots\": %llu,\n  \"resyncBytes\": %llu,\n",
+		(unsigned long long)m_iterations, (unsigned long long)m_rejected, (unsigned long long)m_resyncBytes);
+	fprintf(fp, "  \"counters\": {\"requested\": %s, \"available\": %s, \"error\": \"%s\"},\n",
+		m_options.counters ? "true" : "false", m_counters.isOpen() ? "true" : "false", JsonEscape(m_counters.error()).c_str());
+	//ȵʵʹõָȵʹͬһָȽϲͬĽʱ
+	fprintf(fp, "  \"dispatch\": {\"isa\": \"%s\", \"detected\": \"%s\", \"forced\": %s},\n",
+		CpuIsaName(Kernels().isa), CpuIsaName(DetectedCpuIsa()), KernelIsaForced() ? "true" : "false");
+	fprintf(fp, "  \"stages\": [\n");
+	for (int i = 0; i < StageCount; i++)
+	{
+		const StageHistogram &h = m_stages[i];
+		fprintf(fp, "    {\"name\": \"%s\", \"count\": %llu, \"totalSeconds\": %.6f, \"minNs\": %llu, \"p50Ns\": %llu, \"p99Ns\": %llu, \"maxNs\": %llu",
+			stageNames[i], (unsigned long long)h.count, h.total * 1e-9, (unsigned long long)(h.count ? h.min : 0),
+			(unsigned long long)h.percentile(0.5), (unsigned long long)h.percentile(0.99), (unsigned long long)h.max);
+
+		//¼ÿ֡ںָʱIPC
+		if (m_counters.isOpen())
+		{
+			for (int e = 0; e < PerfEventCount; e++)
+			{
+				if (m_counters.available(e))
+					fprintf(fp, ", \"%sPerShot\": %.1f", PerfEventName(e), perShot(i, e));
+			}
+			if (m_counters.available(PERF_CYCLES) && m_counters.available(PERF_INSTRUCTIONS) && m_stageCounters[i][PERF_CYCLES] > 0)
+				fprintf(fp, ", \"ipc\": %.3f", (double)m_stageCounters[i][PERF_INSTRUCTIONS] / m_stageCounters[i][PERF_CYCLES]);
+		}
+		fprintf(fp, "}%s\n", i + 1 < StageCount ? "," : "");
+	}
+	fprintf(fp, "  ]\n}\n");
+	return fclose(fp) == 0;
+}
+
+
+/*************************************************
+Function:       ͳ
+Description:	һ֮֡ĺʱļβĲҡرļΪһ룻
+				̨ӡ׶κϼƺʱռȡСp50p99ʱдJSONĬ<ģʽ>Stats.json
+Input:
+Output:			ǷдɹδʱΪtrue
+*************************************************/
+RunTotals RunStats::totals() const
+{
+	RunTotals totals;
+	totals.runs = 1;
+	totals.frames = m_frames;
+	totals.bytes = m_position;
+	totals.iterations = m_iterations;
+	totals.rejected = m_rejected;
+	totals.resyncBytes = m_resyncBytes;
+	totals.seconds = elapsed();
+	for (int i = 0; i < StageCount; i++)
+		totals.stageNs[i] = m_stages[i].total;
+	return totals;
+}
+
+
+bool RunStats::report()
+{
+	//ͬʱļʱļĻܱӡഩ
+	static mutex printMutex;
+	lock_guard<mutex> lock(printMutex);
+	commitFrame();
+	if (m_options.totals != NULL)
+		m_options.totals->add(totals());
+	double seconds = elapsed();
+	uint64_t total = 0;
+	for (int i = 0; i < StageCount; i++)
+		total += m_stages[i].total;
+
+	printf("\nStages: %llu frames in %.3f s (%.1f frames/s, %.1f MB/s), %llu LM iterations, %llu rejected, %llu resync bytes.\n",
+		(unsigned long long)m_frames, seconds, seconds > 0 ? m_frames / seconds : 0.0,
+		seconds > 0 ? m_position / seconds / 1048576.0 : 0.0, (unsigned long long)m_iterations,
+		(unsigned long long)m_rejected, (unsigned long long)m_resyncBytes);
+	printf("SIMD: %s (detected %s%s)\n", CpuIsaName(Kernels().isa), CpuIsaName(DetectedCpuIsa()),
+		KernelIsaForced() ? ", forced" : "");
+	printf("  %-9s %10s %7s %10s %10s %10s\n", "stage", "total(s)", "share", "min(us)", "p50(us)", "p99(us)");
+	for (int i = 0; i < StageCount; i++)
+	{
+		const StageHistogram &h = m_stages[i];
+		if (h.count == 0)
+			continue;
+		printf("  %-9s %10.3f %6.1f%% %10.2f %10.2f %10.2f\n", stageNames[i], h.total * 1e-9,
+			total ? 100.0 * h.total / total : 0.0, h.min * 1e-3, h.percentile(0.5) * 1e-3, h.percentile(0.99) * 1e-3);
+	}
+
+	if (m_counters.isOpen())
+	{
+		printf("  %-9s %12s %12s %6s %12s %12s %12s\n", "stage", "cycles/shot", "instr/shot", "IPC", "L1D miss", "LLC miss", "br miss");
+		for (int i = 0; i < StageCount; i++)
+		{
+			if (m_stages[i].count == 0)
+				continue;
+			printf("  %-9s", stageNames[i]);
+			for (int e = PERF_CYCLES; e <= PERF_INSTRUCTIONS; e++)
+				m_counters.available(e) ? printf(" %12.0f", perShot(i, e)) : printf(" %12s", "-");
+			if (m_counters.available(PERF_CYCLES) && m_counters.available(PERF_INSTRUCTIONS) && m_stageCounters[i][PERF_CYCLES] > 0)
+				printf(" %6.2f", (double)m_stageCounters[i][PERF_INSTRUCTIONS] / m_stageCounters[i][PERF_CYCLES]);
+			else
+				printf(" %6s", "-");
+			const int misses[] = { PERF_L1D_MISSES, PERF_LLC_MISSES, PERF_BRANCH_MISSES };
+			for (int k = 0; k < 3; k++)
+				m_counters.available(misses[k]) ? printf(" %12.1f", perShot(i, misses[k])) : printf(" %12s", "-");
+			printf("\n");
+		}
+	}
+
+	if (!m_options.enabled)
+		return true;
+	string path = m_options.path.empty() ? m_mode + "Stats.json" : m_options.path;
+	bool ok = writeJson(path.c_str());
+	if (!ok)
+		printf("Cannot write %s\n", path.c_str());
+	return ok;
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include "PerfCounters.h"
+using namespace std;
+
+
+#define StageLinearBuckets 16		//ʱֱͼа1nsֵͰ
+#define StageSubBuckets 8			//֮ÿ2ٷֵͰ1/8
+#define StageBuckets (StageLinearBuckets + 40 * StageSubBuckets)	//ֱͼͰԼ2^44ns
+
+
+//׶
+enum Stage
+{
+	STAGE_SCAN = 0,				//Ѱ֡ͷΪͬݣ
+	STAGE_DECODE = 1,			//ȡ֡ݡȡͨβѡͨ
+	STAGE_FILTER = 2,			//˲ȥ
+	STAGE_RESOLVE = 3,			//ֵ⡢ֵֽˮ⣩
+	STAGE_OPTIMIZE = 4,			//LMŻ
+	STAGE_DEPTH = 5,			//ˮ
+	STAGE_WRITE = 6,			//λۼӣ
+	StageCount = 7
+};
+
+const char *StageName(int stage);
+
+
+//δĺϼƣδreportʱۼӣݴдȫļĻͳ
+struct RunTotals
+{
+	uint64_t runs;				//AllģʽһļΣ
+	uint64_t frames;
+	uint64_t bytes;				//Ѵļλ֮
+	uint64_t iterations;
+	uint64_t rejected;
+	uint64_t resyncBytes;
+	double seconds;				//δʱ֮
+	uint64_t stageNs[StageCount];	//׶εĺϼƺʱ
+
+	RunTotals();
+	void add(const RunTotals &other);
+};
+
+
+//ͳѡ
+struct StatsOptions
+{
+	bool enabled;				//ǷڴʱдJSONͳ
+	string path;				//JSON·ΪʱΪ<ģʽ>Stats.json
+	double sampleInterval;		//ڲsÿstderrһJSON0Ϊ
+	bool counters;				//Ƿ񰴽׶ζȡӲڡָȱʧȣÿlapһϵͳã
+	bool progress;				//Ƿڿ̨ӡȣʱرգ־е˸
+	RunTotals *totals;			//Ϊʱreportѱͳۼӵ--no-statsʱҲۼӣ
+
+	StatsOptions() : enabled(true), sampleInterval(0), counters(false), progress(true), totals(NULL) {}
+};
+
+
+//дʱһ֡ڶȡ̺߳͹߳ϵķֽ׶κʱɶȡ̰߳֡˳򽻸RunStats::frameDone
+struct FrameTiming
+{
+	uint64_t ns[StageCount];	//׶εۼƺʱ
+	unsigned stages;			//Ľ׶Σλ
+	int64_t last;				//һstartlapʱ
+
+	void clear();				//㲢ʼʱ
+	void start();				//̺߳¿ʼʱ
+	void lap(int stage);		//һstart/lapڵʱstage
+};
+
+
+//׶εĺʱֱֲͼڴ̶¼ʱڴ
+class StageHistogram
+{
+public:
+	StageHistogram();
+	void add(uint64_t ns);
+	uint64_t percentile(double p) const;	//pλ0~1ͰֵСֵ֮
+
+	uint64_t count;
+	uint64_t total;				//ϼƺʱns
+	uint64_t min;
+	uint64_t max;
+
+private:
+	vector<uint64_t> m_buckets;
+};
+
+
+string JsonEscape(const string &text);	//JSONַת壨ļ·еķбܵȣ
+
+
+//һδͳƣ׶κʱֲֽ֡LMЧˮֽͬ
+//lap(stage)Ѿһlapʱý׶Σÿֻһʱӣͬһ֡ڶμͬһ׶ʱۼӣ
+//frameDoneʱÿ׶ΰһ֡һʱֲӲʱlapͬʱȡֵý׶
+class RunStats
+{
+public:
+	RunStats(const char *mode, const char *filename, uint64_t fileBytes, const StatsOptions &options);
+
+	void lap(int stage);							//һlapڵʱstage
+	void frameDone(bool rejected, int iterations = 0);	//һ֡ϣrejectedΪˮΪ0iterationsΪLM
+	void frameDone(const FrameTiming &timing, bool rejected, int iterations = 0);	//дһ֡˳
+	void resync(uint64_t bytes) { m_resyncBytes += bytes; }	//Ѱ֡ͷʱֽ
+	void progress(uint64_t position);				//ǰļλãʾĽȱ仯ʱŴӡʱ
+	bool report();									//ӡ׶λܲдJSONǷдɹ
+	RunTotals totals() const;						//δĺϼ
+
+	const StageHistogram &stage(int index) const { return m_stages[index]; }
+	uint64_t frames() const { return m_frames; }
+	double elapsed() const;							//ʼһlapʱ䣨s
+
+private:
+	void commitFrame();				//֡׶εۼƺʱֲ
+	void sample();
+	bool writeJson(const char *path) const;
+	double perShot(int stage, int event) const;
+
+	string m_mode;
+	string m_filename;
+	uint64_t m_fileBytes;
+	StatsOptions m_options;
+	StageHistogram m_stages[StageCount];
+	uint64_t m_frameNs[StageCount];	//֡׶εۼƺʱ
+	unsigned m_frameStages;			//֡Ľ׶Σλ
+	int64_t m_start;				//ʼʱ̣ns
+	int64_t m_last;					//һlapʱ
+	uint64_t m_frames;
+	uint64_t m_rejected;
+	uint64_t m_iterations;
+	uint64_t m_resyncBytes;
+	uint64_t m_position;			//Ѵļλ
+	int m_progress;					//ѴӡĽȣ0.01%
+	int64_t m_lastSample;			//һβʱ
+	uint64_t m_sampleFrames;		//һβʱ֡
+	uint64_t m_samplePosition;		//һβʱļλ
+	PerfCounters m_counters;		//̵߳Ӳ
+	PerfSample m_lastCounters;		//һlapʱļ
+	uint64_t m_stageCounters[StageCount][PerfEventCount];	//׶εļϼ
+};
@@ -0,0 +1,372 @@
+/*************************************************
+Description:ȵʱָ
+                ʱCPUֵָ֧Ϊֽתֵת˹ƽ
+                ˹롢˹ģͼſɱȾ֡ͷѡʵ֣
+                ͬһԲڲͬķϣ-march
+**************************************************/
+#include "SimdKernels.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86
+extern const SimdKernels g_sse42Kernels;
+extern const SimdKernels g_avx2Kernels;
+extern const SimdKernels g_avx512Kernels;
+#endif
+
+
+static const char *isaNames[CpuIsaCount] = { "scalar", "sse4.2", "avx2", "avx512" };
+
+
+const char *CpuIsaName(int isa)
+{
+	return (isa >= 0 && isa < CpuIsaCount) ? isaNames[isa] : "unknown";
+}
+
+
+bool CpuIsaFromName(const char *name, CpuIsa &isa)
+{
+	for (int i = 0; i < CpuIsaCount; i++)
+	{
+		if (strcmp(name, isaNames[i]) == 0)
+		{
+			isa = (CpuIsa)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+//---------------------------------------------------------------- ʵ
+
+double ExpApprox(double x)
+{
+	if (!(x >= ExpMin))
+		return (x < ExpMin) ? 0 : x;		//NaNԭ
+	if (x > ExpMax)
+		return HUGE_VAL;
+
+	double n = floor(x * ExpLog2e + 0.5);
+	double r = x - n * ExpLn2Hi;
+	r = r - n * ExpLn2Lo;
+
+	double p = 1.0 / 6227020800.0;		//1/13!
+	p = p * r + 1.0 / 479001600.0;
+	p = p * r + 1.0 / 39916800.0;
+	p = p * r + 1.0 / 3628800.0;
+	p = p * r + 1.0 / 362880.0;
+	p = p * r + 1.0 / 40320.0;
+	p = p * r + 1.0 / 5040.0;
+	p = p * r + 1.0 / 720.0;
+	p = p * r + 1.0 / 120.0;
+	p = p * r + 1.0 / 24.0;
+	p = p * r + 1.0 / 6.0;
+	p = p * r + 0.5;
+	p = p * r + 1.0;
+	p = p * r + 1.0;
+
+	//2^nֱӹָλ
+	uint64_t bits = (uint64_t)((int64_t)n + 1023) << 52;
+	double scale;
+	memcpy(&scale, &bits, sizeof(scale));
+	return p * scale;
+}
+
+
+void ScalarByteSwap16(uint16_t *data, int n)
+{
+	for (int i = 0; i < n; i++)
+		data[i] = (uint16_t)((data[i] << 8) | (data[i] >> 8));
+}
+
+
+void ScalarWidenU16ToFloat(const uint16_t *src, float *dst, int n)
+{
+	for (int i = 0; i < n; i++)
+		dst[i] = (float)src[i];
+}
+
+
+void ScalarWidenU16ToInt(const uint16_t *src, int *dst, int n)
+{
+	for (int i = 0; i < n; i++)
+		dst[i] = src[i];
+}
+
+
+//dst[i]begin<=i<endΪsrc[i-2..i+2]˵ľҵ˳ۼ
+void ScalarGaussian5(const float *src, float *dst, const float kernel[5], int begin, int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		dst[i] = src[i - 2] * kernel[0] + src[i - 1] * kernel[1] + src[i] * kernel[2] + src[i + 1] * kernel[3] +
+			src[i + 2] * kernel[4];
+	}
+}
+
+
+static void scalarGaussian5(const float *src, float *dst, const float kernel[5], int n)
+{
+	ScalarGaussian5(src, dst, kernel, 2, n - 2);
+}
+
+
+//Ƚdouble½УԭfloatdoubleȽһ£
+void ScalarPeelSubtract(float *data, const double *g, int n)
+{
+	for (int i = 0; i < n; i++)
+	{
+		if (data[i] > g[i])
+			data[i] -= (float)g[i];
+		else
+			data[i] = 0;
+	}
+}
+
+
+static int scalarArgMaxPositive(const float *data, int n, float *value)
+{
+	int index = -1;
+	float max = 0;
+	for (int i = 0; i < n; i++)
+	{
+		if (data[i] > max)
+		{
+			max = data[i];
+			index = i;
+		}
+	}
+	*value = max;
+	return index;
+}
+
+
+//x[i] = sum(A*exp(-(i-b)^2/(2*sigma^2)))pΪAbsigma
+void ScalarGaussModel(const double *p, int count, double *x, int begin, int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		double sum = 0;
+		for (int k = 0; k < count; k++)
+		{
+			const double *q = p + 3 * k;
+			double d = i - q[1];
+			double term = q[0] * ExpApprox(-d * d / (2 * q[2] * q[2]));
+			sum = (k == 0) ? term : sum + term;
+		}
+		x[i] = sum;
+	}
+}
+
+
+//ΪAbsigmaƫ
+//Aһԭģʹдexp(-(i-b)^2/(2*sigma)*sigma)
+void ScalarGaussJacobian(const double *p, int count, double *jac, int begin, int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		double *row = jac + (size_t)i * 3 * count;
+		for (int k = 0; k < count; k++)
+		{
+			const double *q = p + 3 * k;
+			double d = i - q[1];
+			double e = ExpApprox(-d * d / (2 * q[2] * q[2]));
+			row[3 * k] = ExpApprox(-d * d / (2 * q[2]) * q[2]);
+			row[3 * k + 1] = q[0] * d / (q[2] * q[2]) * e;
+			row[3 * k + 2] = q[0] * d * d / (q[2] * q[2] * q[2]) * e;
+		}
+	}
+}
+
+
+static void scalarGaussModel(const double *p, int count, double *x, int n)
+{
+	ScalarGaussModel(p, count, x, 0, n);
+}
+
+
+static void scalarGaussJacobian(const double *p, int count, double *jac, int n)
+{
+	ScalarGaussJacobian(p, count, jac, 0, n);
+}
+
+
+//begin16ıңֵͬλãûʱһδλãСn-7
+size_t ScalarFindSync(const uint8_t *data, size_t begin, size_t n)
+{
+	size_t offset = begin;
+	for (; offset + 8 <= n; offset += SyncStride)
+	{
+		uint64_t word;
+		memcpy(&word, data + offset, sizeof(word));
+		if (word == SyncWord)
+			return offset;
+	}
+	return offset;
+}
+
+
+static size_t scalarFindSync(const uint8_t *data, size_t n)
+{
+	return ScalarFindSync(data, 0, n);
+}
+
+
+static const SimdKernels g_scalarKernels = {
+	ISA_SCALAR,
+	ScalarByteSwap16,
+	ScalarWidenU16ToFloat,
+	ScalarWidenU16ToInt,
+	scalarGaussian5,
+	ScalarPeelSubtract,
+	scalarArgMaxPositive,
+	scalarGaussModel,
+	scalarGaussJacobian,
+	scalarFindSync
+};
+
+
+//---------------------------------------------------------------- 
+
+#ifdef SIMD_X86
+static void cpuid(int leaf, int subleaf, unsigned int regs[4])
+{
+#if defined(_MSC_VER)
+	int r[4];
+	__cpuidex(r, leaf, subleaf);
+	for (int i = 0; i < 4; i++)
+		regs[i] = (unsigned int)r[i];
+#else
+	__asm__ __volatile__("cpuid" : "=a"(regs[0]), "=b"(regs[1]), "=c"(regs[2]), "=d"(regs[3]) : "a"(leaf), "c"(subleaf));
+#endif
+}
+
+
+//ϵͳļĴ״̬XCR0
+static uint64_t xgetbv0()
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	unsigned int lo, hi;
+	__asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	return ((uint64_t)hi << 32) | lo;
+#endif
+}
+#endif
+
+
+/*************************************************
+Function:       CPUֵָ֧
+Description:	AVX2AVX-512CPU֧⻹ϵͳYMM/ZMMĴ״̬ı棨XCR0
+Input:
+Output:			ָ
+*************************************************/
+static CpuIsa detectIsa()
+{
+#ifdef SIMD_X86
+	unsigned int r[4];
+	cpuid(0, 0, r);
+	unsigned int maxLeaf = r[0];
+	cpuid(1, 0, r);
+	bool sse42 = (r[2] & (1u << 20)) != 0;
+	bool ssse3 = (r[2] & (1u << 9)) != 0;
+	bool osxsave = (r[2] & (1u << 27)) != 0;
+	bool avx = (r[2] & (1u << 28)) != 0;
+	if (!sse42 || !ssse3)
+		return ISA_SCALAR;
+
+	uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+	bool ymm = (xcr0 & 0x6) == 0x6;			//XMMYMM
+	bool zmm = (xcr0 & 0xE6) == 0xE6;		//opmaskZMM
+	if (!avx || !ymm || maxLeaf < 7)
+		return ISA_SSE42;
+
+	cpuid(7, 0, r);
+	bool avx2 = (r[1] & (1u << 5)) != 0;
+	bool avx512f = (r[1] & (1u << 16)) != 0;
+	bool avx512bw = (r[1] & (1u << 30)) != 0;
+	if (!avx2)
+		return ISA_SSE42;
+	if (avx512f && avx512bw && zmm)
+		return ISA_AVX512;
+	return ISA_AVX2;
+#else
+	return ISA_SCALAR;
+#endif
+}
+
+
+static const SimdKernels *tableFor(CpuIsa isa)
+{
+	switch (isa)
+	{
+#ifdef SIMD_X86
+	case ISA_AVX512: return &g_avx512Kernels;
+	case ISA_AVX2: return &g_avx2Kernels;
+	case ISA_SSE42: return &g_sse42Kernels;
+#endif
+	default: return &g_scalarKernels;
+	}
+}
+
+
+struct KernelDispatch
+{
+	CpuIsa detected;
+	const SimdKernels *selected;
+	bool forced;
+
+	KernelDispatch() : detected(detectIsa()), forced(false) { selected = tableFor(detected); }
+};
+
+static KernelDispatch &dispatch()
+{
+	static KernelDispatch d;
+	return d;
+}
+
+
+const SimdKernels &Kernels()
+{
+	return *dispatch().selected;
+}
+
+
+CpuIsa DetectedCpuIsa()
+{
+	return dispatch().detected;
+}
+
+
+bool KernelIsaForced()
+{
+	return dispatch().forced;
+}
+
+
+/*************************************************
+Function:       ָʹõָ
+Description:	ڲԺͱȽϸʵ֣CPUֵָ֧ʱʹֵָ֧ʾ
+				Ӧڿʼǰ
+Input:          isa:ָ
+Output:			ʵʹõָ
+*************************************************/
+CpuIsa SetKernelIsa(CpuIsa isa)
+{
+	KernelDispatch &d = dispatch();
+	if (isa > d.detected)
+	{
+		printf("CPU does not support %s, using %s.\n", CpuIsaName(isa), CpuIsaName(d.detected));
+		isa = d.detected;
+	}
+	d.selected = tableFor(isa);
+	d.forced = true;
+	return isa;
+}
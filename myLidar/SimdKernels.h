@@ -0,0 +1,65 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+
+//ָӵ͵ߣ
+enum CpuIsa
+{
+	ISA_SCALAR = 0,		//ʹSIMD
+	ISA_SSE42 = 1,		//SSE4.2
+	ISA_AVX2 = 2,		//AVX2
+	ISA_AVX512 = 3,		//AVX-512F/BW
+	CpuIsaCount = 4
+};
+
+const char *CpuIsaName(int isa);
+bool CpuIsaFromName(const char *name, CpuIsa &isa);	//scalarsse4.2avx2avx512
+
+
+#define SyncWord 0xEFCDAB8967452301ULL	//֡ͷͬ01 23 45 67 89 AB CD EFСɵ64λ
+#define SyncStride 16					//Ѱ֡ͷĲֽڣֻͬ16ֽڶλ
+
+//ʵֹõexpƣx=n*ln2+r|r|<=ln2/2exp(r)ȡ13̩չHornerFMA
+//ָ˳ͬλһ£libm1ulp
+#define ExpLog2e 1.4426950408889634
+#define ExpLn2Hi 6.93145751953125e-1		//ln2ĸλλΪ0n*ExpLn2Hi룩
+#define ExpLn2Lo 1.42860682030941723212e-6	//ln2ĵλ
+#define ExpMin -708.0						//Сڸֵ0ǹ
+#define ExpMax 709.0						//ڸֵ+inf
+
+
+//ȵһʵ֣ͬһڵĺʹͬһָ
+//ʵֵĽʵλһ£expʹĹýƣָı䴦
+struct SimdKernels
+{
+	CpuIsa isa;
+
+	void (*byteSwap16)(uint16_t *data, int n);											//16λֵֽתԭأ
+	void (*widenU16ToFloat)(const uint16_t *src, float *dst, int n);					//ֵתΪfloat
+	void (*widenU16ToInt)(const uint16_t *src, int *dst, int n);						//ֵתΪint
+	void (*gaussian5)(const float *src, float *dst, const float kernel[5], int n);		//5dst[2..n-3]
+	void (*peelSubtract)(float *data, const double *g, int n);							//data[i]>g[i]ʱȥ(float)g[i]0
+	int (*argMaxPositive)(const float *data, int n, float *value);						//ֵֵ׸λãֵʱ-1valueΪ0
+	void (*gaussModel)(const double *p, int count, double *x, int n);					//count˹0..n-1ϵĵ
+	void (*gaussJacobian)(const double *p, int count, double *jac, int n);				//˹ģͶԸſɱȾn3*countУ
+	size_t (*findSync)(const uint8_t *data, size_t n);									//16ֽڶλѰͬ
+};
+
+
+const SimdKernels &Kernels();			//ǰʹõʵ
+CpuIsa DetectedCpuIsa();				//CPUͲϵͳֵָ֧
+bool KernelIsaForced();					//ǷMYLIDAR_ISASetKernelIsaָ
+CpuIsa SetKernelIsa(CpuIsa isa);		//ָָCPUֵָ֧ʵʹõָ
+
+
+//ʵָ֣ʵһβ
+double ExpApprox(double x);
+void ScalarByteSwap16(uint16_t *data, int n);
+void ScalarWidenU16ToFloat(const uint16_t *src, float *dst, int n);
+void ScalarWidenU16ToInt(const uint16_t *src, int *dst, int n);
+void ScalarGaussian5(const float *src, float *dst, const float kernel[5], int begin, int end);
+void ScalarPeelSubtract(float *data, const double *g, int n);
+void ScalarGaussModel(const double *p, int count, double *x, int begin, int end);
+void ScalarGaussJacobian(const double *p, int count, double *jac, int begin, int end);
+size_t ScalarFindSync(const uint8_t *data, size_t begin, size_t n);
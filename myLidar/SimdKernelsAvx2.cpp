@@ -0,0 +1,264 @@
+/*************************************************
+Description:ȵAVX2ʵ֣256λ
+                ļ-mavx2룬ֻڼ⵽CPU֧ʱɵã
+                ֻintrinsicsͷļͷļAVX2뱻ļ
+**************************************************/
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include "SimdKernels.h"
+#include <string.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+static inline int firstBit(unsigned int mask)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (int)index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+
+static void avx2ByteSwap16(uint16_t *data, int n)
+{
+	const __m256i shuffle = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+		1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+	int i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+		_mm256_storeu_si256((__m256i *)(data + i), _mm256_shuffle_epi8(v, shuffle));
+	}
+	ScalarByteSwap16(data + i, n - i);
+}
+
+
+static void avx2WidenU16ToFloat(const uint16_t *src, float *dst, int n)
+{
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm256_storeu_ps(dst + i, _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(v)));
+	}
+	ScalarWidenU16ToFloat(src + i, dst + i, n - i);
+}
+
+
+static void avx2WidenU16ToInt(const uint16_t *src, int *dst, int n)
+{
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm256_storeu_si256((__m256i *)(dst + i), _mm256_cvtepu16_epi32(v));
+	}
+	ScalarWidenU16ToInt(src + i, dst + i, n - i);
+}
+
+
+static void avx2Gaussian5(const float *src, float *dst, const float kernel[5], int n)
+{
+	const __m256 k0 = _mm256_set1_ps(kernel[0]);
+	const __m256 k1 = _mm256_set1_ps(kernel[1]);
+	const __m256 k2 = _mm256_set1_ps(kernel[2]);
+	const __m256 k3 = _mm256_set1_ps(kernel[3]);
+	const __m256 k4 = _mm256_set1_ps(kernel[4]);
+	int i = 2;
+	for (; i + 8 <= n - 2; i += 8)
+	{
+		__m256 acc = _mm256_mul_ps(_mm256_loadu_ps(src + i - 2), k0);
+		acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(src + i - 1), k1));
+		acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(src + i), k2));
+		acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(src + i + 1), k3));
+		acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(src + i + 2), k4));
+		_mm256_storeu_ps(dst + i, acc);
+	}
+	ScalarGaussian5(src, dst, kernel, i, n - 2);
+}
+
+
+static void avx2PeelSubtract(float *data, const double *g, int n)
+{
+	const __m256i even = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256 f = _mm256_loadu_ps(data + i);
+		__m256d glo = _mm256_loadu_pd(g + i);
+		__m256d ghi = _mm256_loadu_pd(g + i + 4);
+		__m256d mlo = _mm256_cmp_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(f)), glo, _CMP_GT_OQ);
+		__m256d mhi = _mm256_cmp_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(f, 1)), ghi, _CMP_GT_OQ);
+		//64λȽϽȡ32λƴ8float
+		__m128i masklo = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_castpd_si256(mlo), even));
+		__m128i maskhi = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_castpd_si256(mhi), even));
+		__m256 mask = _mm256_castsi256_ps(_mm256_inserti128_si256(_mm256_castsi128_si256(masklo), maskhi, 1));
+		__m256 gf = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(glo)), _mm256_cvtpd_ps(ghi), 1);
+		_mm256_storeu_ps(data + i, _mm256_and_ps(mask, _mm256_sub_ps(f, gf)));
+	}
+	ScalarPeelSubtract(data + i, g + i, n - i);
+}
+
+
+static int avx2ArgMaxPositive(const float *data, int n, float *value)
+{
+	int i = 0;
+	__m256 vmax = _mm256_setzero_ps();
+	for (; i + 8 <= n; i += 8)
+		vmax = _mm256_max_ps(vmax, _mm256_loadu_ps(data + i));
+	__m128 m = _mm_max_ps(_mm256_castps256_ps128(vmax), _mm256_extractf128_ps(vmax, 1));
+	m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+	m = _mm_max_ps(m, _mm_shuffle_ps(m, m, 1));
+	float max = _mm_cvtss_f32(m);
+
+	int index = -1;
+	if (max > 0)
+	{
+		const __m256 target = _mm256_set1_ps(max);
+		for (int j = 0; j < i; j += 8)
+		{
+			int mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(data + j), target, _CMP_EQ_OQ));
+			if (mask != 0)
+			{
+				index = j + firstBit((unsigned int)mask);
+				break;
+			}
+		}
+	}
+	for (; i < n; i++)
+	{
+		if (data[i] > max)
+		{
+			max = data[i];
+			index = i;
+		}
+	}
+	*value = max;
+	return index;
+}
+
+
+//ExpApproxͬ˳
+static inline __m256d expApprox(__m256d x)
+{
+	__m256d n = _mm256_floor_pd(_mm256_add_pd(_mm256_mul_pd(x, _mm256_set1_pd(ExpLog2e)), _mm256_set1_pd(0.5)));
+	__m256d r = _mm256_sub_pd(x, _mm256_mul_pd(n, _mm256_set1_pd(ExpLn2Hi)));
+	r = _mm256_sub_pd(r, _mm256_mul_pd(n, _mm256_set1_pd(ExpLn2Lo)));
+
+	__m256d p = _mm256_set1_pd(1.0 / 6227020800.0);
+	p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(1.0 / 479001600.0));
+	p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(1.0 / 39916800.0));
+	p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(1.0 / 3628800.0));
+	p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(1.0 / 362880.0));
+	p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(1.0 / 40320.0));
+	p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(1.0 / 5040.0));
+	p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(1.0 / 720.0));
+	p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(1.0 / 120.0));
+	p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(1.0 / 24.0));
+	p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(1.0 / 6.0));
+	p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(0.5));
+	p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(1.0));
+	p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(1.0));
+
+	__m256i bits = _mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(n)), _mm256_set1_epi64x(1023));
+	__m256d result = _mm256_mul_pd(p, _mm256_castsi256_pd(_mm256_slli_epi64(bits, 52)));
+
+	const __m256d inf = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FF0000000000000LL));
+	result = _mm256_blendv_pd(result, _mm256_setzero_pd(), _mm256_cmp_pd(x, _mm256_set1_pd(ExpMin), _CMP_LT_OQ));
+	return _mm256_blendv_pd(result, inf, _mm256_cmp_pd(x, _mm256_set1_pd(ExpMax), _CMP_GT_OQ));
+}
+
+
+static void avx2GaussModel(const double *p, int count, double *x, int n)
+{
+	const __m256d sign = _mm256_set1_pd(-0.0);
+	const __m256d lanes = _mm256_setr_pd(0, 1, 2, 3);
+	int i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m256d iv = _mm256_add_pd(_mm256_set1_pd(i), lanes);
+		__m256d sum = _mm256_setzero_pd();
+		for (int k = 0; k < count; k++)
+		{
+			const double *q = p + 3 * k;
+			__m256d d = _mm256_sub_pd(iv, _mm256_set1_pd(q[1]));
+			__m256d t = _mm256_mul_pd(_mm256_xor_pd(d, sign), d);
+			__m256d e = expApprox(_mm256_div_pd(t, _mm256_set1_pd(2 * q[2] * q[2])));
+			__m256d term = _mm256_mul_pd(_mm256_set1_pd(q[0]), e);
+			sum = (k == 0) ? term : _mm256_add_pd(sum, term);
+		}
+		_mm256_storeu_pd(x + i, sum);
+	}
+	ScalarGaussModel(p, count, x, i, n);
+}
+
+
+static void avx2GaussJacobian(const double *p, int count, double *jac, int n)
+{
+	const __m256d sign = _mm256_set1_pd(-0.0);
+	const __m256d lanes = _mm256_setr_pd(0, 1, 2, 3);
+	const int m = 3 * count;
+	int i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m256d iv = _mm256_add_pd(_mm256_set1_pd(i), lanes);
+		for (int k = 0; k < count; k++)
+		{
+			const double *q = p + 3 * k;
+			__m256d a = _mm256_set1_pd(q[0]);
+			__m256d sigma = _mm256_set1_pd(q[2]);
+			__m256d d = _mm256_sub_pd(iv, _mm256_set1_pd(q[1]));
+			__m256d t = _mm256_mul_pd(_mm256_xor_pd(d, sign), d);
+			__m256d e = expApprox(_mm256_div_pd(t, _mm256_set1_pd(2 * q[2] * q[2])));
+			__m256d ad = _mm256_mul_pd(a, d);
+			double col[3][4];
+			_mm256_storeu_pd(col[0], expApprox(_mm256_mul_pd(_mm256_div_pd(t, _mm256_set1_pd(2 * q[2])), sigma)));
+			_mm256_storeu_pd(col[1], _mm256_mul_pd(_mm256_div_pd(ad, _mm256_set1_pd(q[2] * q[2])), e));
+			_mm256_storeu_pd(col[2], _mm256_mul_pd(_mm256_div_pd(_mm256_mul_pd(ad, d), _mm256_set1_pd(q[2] * q[2] * q[2])), e));
+			for (int l = 0; l < 4; l++)
+			{
+				double *row = jac + (size_t)(i + l) * m + 3 * k;
+				row[0] = col[0][l];
+				row[1] = col[1][l];
+				row[2] = col[2][l];
+			}
+		}
+	}
+	ScalarGaussJacobian(p, count, jac, i, n);
+}
+
+
+//ÿαȽ32ֽ16ֽڶλ
+static size_t avx2FindSync(const uint8_t *data, size_t n)
+{
+	const __m256i word = _mm256_set1_epi64x((long long)SyncWord);
+	size_t offset = 0;
+	for (; offset + 32 <= n; offset += 32)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i *)(data + offset));
+		int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, word))) & 0x5;
+		if (mask != 0)
+			return offset + ((mask & 1) ? 0 : 16);
+	}
+	return ScalarFindSync(data, offset, n);
+}
+
+
+extern const SimdKernels g_avx2Kernels = {
+	ISA_AVX2,
+	avx2ByteSwap16,
+	avx2WidenU16ToFloat,
+	avx2WidenU16ToInt,
+	avx2Gaussian5,
+	avx2PeelSubtract,
+	avx2ArgMaxPositive,
+	avx2GaussModel,
+	avx2GaussJacobian,
+	avx2FindSync
+};
+#endif
@@ -0,0 +1,276 @@
+/*************************************************
+Description:ȵAVX-512ʵ֣512λҪAVX-512FAVX-512BW
+                ļ-mavx512f -mavx512bw룬ֻڼ⵽CPU֧ʱɵã
+                ֻintrinsicsͷļͷļAVX-512뱻ļ
+**************************************************/
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include "SimdKernels.h"
+#include <string.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+//GCCintrinsicsδֱֵͨ-Wall±δʼȫmaskzʽ
+#define AllLanes8 ((__mmask8)0xFF)
+#define AllLanes16 ((__mmask16)0xFFFF)
+
+
+//256λƴһ512λloڵͰ벿֣
+static inline __m512 combine256(__m256 lo, __m256 hi)
+{
+	__m512d v = _mm512_maskz_insertf64x4(AllLanes8, _mm512_setzero_pd(), _mm256_castps_pd(lo), 0);
+	return _mm512_castpd_ps(_mm512_maskz_insertf64x4(AllLanes8, v, _mm256_castps_pd(hi), 1));
+}
+
+
+static inline int firstBit(unsigned int mask)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (int)index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+
+static void avx512ByteSwap16(uint16_t *data, int n)
+{
+	const __m512i shuffle = _mm512_maskz_broadcast_i32x4(AllLanes16, _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14));
+	int i = 0;
+	for (; i + 32 <= n; i += 32)
+	{
+		__m512i v = _mm512_loadu_si512((const void *)(data + i));
+		_mm512_storeu_si512((void *)(data + i), _mm512_shuffle_epi8(v, shuffle));
+	}
+	ScalarByteSwap16(data + i, n - i);
+}
+
+
+static void avx512WidenU16ToFloat(const uint16_t *src, float *dst, int n)
+{
+	int i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+		_mm512_storeu_ps(dst + i, _mm512_maskz_cvtepi32_ps(AllLanes16, _mm512_maskz_cvtepu16_epi32(AllLanes16, v)));
+	}
+	ScalarWidenU16ToFloat(src + i, dst + i, n - i);
+}
+
+
+static void avx512WidenU16ToInt(const uint16_t *src, int *dst, int n)
+{
+	int i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+		_mm512_storeu_si512((void *)(dst + i), _mm512_maskz_cvtepu16_epi32(AllLanes16, v));
+	}
+	ScalarWidenU16ToInt(src + i, dst + i, n - i);
+}
+
+
+static void avx512Gaussian5(const float *src, float *dst, const float kernel[5], int n)
+{
+	const __m512 k0 = _mm512_set1_ps(kernel[0]);
+	const __m512 k1 = _mm512_set1_ps(kernel[1]);
+	const __m512 k2 = _mm512_set1_ps(kernel[2]);
+	const __m512 k3 = _mm512_set1_ps(kernel[3]);
+	const __m512 k4 = _mm512_set1_ps(kernel[4]);
+	int i = 2;
+	for (; i + 16 <= n - 2; i += 16)
+	{
+		__m512 acc = _mm512_mul_ps(_mm512_loadu_ps(src + i - 2), k0);
+		acc = _mm512_add_ps(acc, _mm512_mul_ps(_mm512_loadu_ps(src + i - 1), k1));
+		acc = _mm512_add_ps(acc, _mm512_mul_ps(_mm512_loadu_ps(src + i), k2));
+		acc = _mm512_add_ps(acc, _mm512_mul_ps(_mm512_loadu_ps(src + i + 1), k3));
+		acc = _mm512_add_ps(acc, _mm512_mul_ps(_mm512_loadu_ps(src + i + 2), k4));
+		_mm512_storeu_ps(dst + i, acc);
+	}
+	ScalarGaussian5(src, dst, kernel, i, n - 2);
+}
+
+
+static void avx512PeelSubtract(float *data, const double *g, int n)
+{
+	int i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		__m256 flo = _mm256_loadu_ps(data + i);
+		__m256 fhi = _mm256_loadu_ps(data + i + 8);
+		__m512d glo = _mm512_loadu_pd(g + i);
+		__m512d ghi = _mm512_loadu_pd(g + i + 8);
+		__mmask8 mlo = _mm512_cmp_pd_mask(_mm512_maskz_cvtps_pd(AllLanes8, flo), glo, _CMP_GT_OQ);
+		__mmask8 mhi = _mm512_cmp_pd_mask(_mm512_maskz_cvtps_pd(AllLanes8, fhi), ghi, _CMP_GT_OQ);
+		__mmask16 mask = (__mmask16)(mlo | ((unsigned int)mhi << 8));
+		__m512 f = _mm512_loadu_ps(data + i);
+		__m512 gf = combine256(_mm512_maskz_cvtpd_ps(AllLanes8, glo), _mm512_maskz_cvtpd_ps(AllLanes8, ghi));
+		_mm512_storeu_ps(data + i, _mm512_maskz_sub_ps(mask, f, gf));
+	}
+	ScalarPeelSubtract(data + i, g + i, n - i);
+}
+
+
+static int avx512ArgMaxPositive(const float *data, int n, float *value)
+{
+	int i = 0;
+	__m512 vmax = _mm512_setzero_ps();
+	for (; i + 16 <= n; i += 16)
+		vmax = _mm512_maskz_max_ps(AllLanes16, vmax, _mm512_loadu_ps(data + i));
+	float lanes[16];
+	_mm512_storeu_ps(lanes, vmax);
+	float max = lanes[0];
+	for (int l = 1; l < 16; l++)
+		max = (lanes[l] > max) ? lanes[l] : max;
+
+	int index = -1;
+	if (max > 0)
+	{
+		const __m512 target = _mm512_set1_ps(max);
+		for (int j = 0; j < i; j += 16)
+		{
+			__mmask16 mask = _mm512_cmp_ps_mask(_mm512_loadu_ps(data + j), target, _CMP_EQ_OQ);
+			if (mask != 0)
+			{
+				index = j + firstBit((unsigned int)mask);
+				break;
+			}
+		}
+	}
+	for (; i < n; i++)
+	{
+		if (data[i] > max)
+		{
+			max = data[i];
+			index = i;
+		}
+	}
+	*value = max;
+	return index;
+}
+
+
+//ExpApproxͬ˳
+static inline __m512d expApprox(__m512d x)
+{
+	__m512d n = _mm512_maskz_roundscale_pd(AllLanes8, _mm512_add_pd(_mm512_mul_pd(x, _mm512_set1_pd(ExpLog2e)), _mm512_set1_pd(0.5)),
+		_MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+	__m512d r = _mm512_sub_pd(x, _mm512_mul_pd(n, _mm512_set1_pd(ExpLn2Hi)));
+	r = _mm512_sub_pd(r, _mm512_mul_pd(n, _mm512_set1_pd(ExpLn2Lo)));
+
+	__m512d p = _mm512_set1_pd(1.0 / 6227020800.0);
+	p = _mm512_add_pd(_mm512_mul_pd(p, r), _mm512_set1_pd(1.0 / 479001600.0));
+	p = _mm512_add_pd(_mm512_mul_pd(p, r), _mm512_set1_pd(1.0 / 39916800.0));
+	p = _mm512_add_pd(_mm512_mul_pd(p, r), _mm512_set1_pd(1.0 / 3628800.0));
+	p = _mm512_add_pd(_mm512_mul_pd(p, r), _mm512_set1_pd(1.0 / 362880.0));
+	p = _mm512_add_pd(_mm512_mul_pd(p, r), _mm512_set1_pd(1.0 / 40320.0));
+	p = _mm512_add_pd(_mm512_mul_pd(p, r), _mm512_set1_pd(1.0 / 5040.0));
+	p = _mm512_add_pd(_mm512_mul_pd(p, r), _mm512_set1_pd(1.0 / 720.0));
+	p = _mm512_add_pd(_mm512_mul_pd(p, r), _mm512_set1_pd(1.0 / 120.0));
+	p = _mm512_add_pd(_mm512_mul_pd(p, r), _mm512_set1_pd(1.0 / 24.0));
+	p = _mm512_add_pd(_mm512_mul_pd(p, r), _mm512_set1_pd(1.0 / 6.0));
+	p = _mm512_add_pd(_mm512_mul_pd(p, r), _mm512_set1_pd(0.5));
+	p = _mm512_add_pd(_mm512_mul_pd(p, r), _mm512_set1_pd(1.0));
+	p = _mm512_add_pd(_mm512_mul_pd(p, r), _mm512_set1_pd(1.0));
+
+	__m512i bits = _mm512_add_epi64(_mm512_maskz_cvtepi32_epi64(AllLanes8, _mm512_maskz_cvtpd_epi32(AllLanes8, n)), _mm512_set1_epi64(1023));
+	__m512d result = _mm512_mul_pd(p, _mm512_castsi512_pd(_mm512_maskz_slli_epi64(AllLanes8, bits, 52)));
+
+	const __m512d inf = _mm512_castsi512_pd(_mm512_set1_epi64(0x7FF0000000000000LL));
+	result = _mm512_mask_mov_pd(result, _mm512_cmp_pd_mask(x, _mm512_set1_pd(ExpMin), _CMP_LT_OQ), _mm512_setzero_pd());
+	return _mm512_mask_mov_pd(result, _mm512_cmp_pd_mask(x, _mm512_set1_pd(ExpMax), _CMP_GT_OQ), inf);
+}
+
+
+static void avx512GaussModel(const double *p, int count, double *x, int n)
+{
+	const __m512d sign = _mm512_set1_pd(-0.0);
+	const __m512d lanes = _mm512_setr_pd(0, 1, 2, 3, 4, 5, 6, 7);
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m512d iv = _mm512_add_pd(_mm512_set1_pd(i), lanes);
+		__m512d sum = _mm512_setzero_pd();
+		for (int k = 0; k < count; k++)
+		{
+			const double *q = p + 3 * k;
+			__m512d d = _mm512_sub_pd(iv, _mm512_set1_pd(q[1]));
+			__m512d t = _mm512_mul_pd(_mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(d), _mm512_castpd_si512(sign))), d);
+			__m512d e = expApprox(_mm512_div_pd(t, _mm512_set1_pd(2 * q[2] * q[2])));
+			__m512d term = _mm512_mul_pd(_mm512_set1_pd(q[0]), e);
+			sum = (k == 0) ? term : _mm512_add_pd(sum, term);
+		}
+		_mm512_storeu_pd(x + i, sum);
+	}
+	ScalarGaussModel(p, count, x, i, n);
+}
+
+
+static void avx512GaussJacobian(const double *p, int count, double *jac, int n)
+{
+	const __m512d sign = _mm512_set1_pd(-0.0);
+	const __m512d lanes = _mm512_setr_pd(0, 1, 2, 3, 4, 5, 6, 7);
+	const int m = 3 * count;
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m512d iv = _mm512_add_pd(_mm512_set1_pd(i), lanes);
+		for (int k = 0; k < count; k++)
+		{
+			const double *q = p + 3 * k;
+			__m512d a = _mm512_set1_pd(q[0]);
+			__m512d sigma = _mm512_set1_pd(q[2]);
+			__m512d d = _mm512_sub_pd(iv, _mm512_set1_pd(q[1]));
+			__m512d t = _mm512_mul_pd(_mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(d), _mm512_castpd_si512(sign))), d);
+			__m512d e = expApprox(_mm512_div_pd(t, _mm512_set1_pd(2 * q[2] * q[2])));
+			__m512d ad = _mm512_mul_pd(a, d);
+			double col[3][8];
+			_mm512_storeu_pd(col[0], expApprox(_mm512_mul_pd(_mm512_div_pd(t, _mm512_set1_pd(2 * q[2])), sigma)));
+			_mm512_storeu_pd(col[1], _mm512_mul_pd(_mm512_div_pd(ad, _mm512_set1_pd(q[2] * q[2])), e));
+			_mm512_storeu_pd(col[2], _mm512_mul_pd(_mm512_div_pd(_mm512_mul_pd(ad, d), _mm512_set1_pd(q[2] * q[2] * q[2])), e));
+			for (int l = 0; l < 8; l++)
+			{
+				double *row = jac + (size_t)(i + l) * m + 3 * k;
+				row[0] = col[0][l];
+				row[1] = col[1][l];
+				row[2] = col[2][l];
+			}
+		}
+	}
+	ScalarGaussJacobian(p, count, jac, i, n);
+}
+
+
+//ÿαȽ64ֽ16ֽڶĸλã024664λ֣
+static size_t avx512FindSync(const uint8_t *data, size_t n)
+{
+	const __m512i word = _mm512_set1_epi64((long long)SyncWord);
+	size_t offset = 0;
+	for (; offset + 64 <= n; offset += 64)
+	{
+		__m512i v = _mm512_loadu_si512((const void *)(data + offset));
+		unsigned int mask = _mm512_cmpeq_epi64_mask(v, word) & 0x55;
+		if (mask != 0)
+			return offset + 8 * firstBit(mask);
+	}
+	return ScalarFindSync(data, offset, n);
+}
+
+
+extern const SimdKernels g_avx512Kernels = {
+	ISA_AVX512,
+	avx512ByteSwap16,
+	avx512WidenU16ToFloat,
+	avx512WidenU16ToInt,
+	avx512Gaussian5,
+	avx512PeelSubtract,
+	avx512ArgMaxPositive,
+	avx512GaussModel,
+	avx512GaussJacobian,
+	avx512FindSync
+};
+#endif
@@ -0,0 +1,255 @@
+/*************************************************
+Description:ȵSSE4.2ʵ֣128λ
+                ļ-msse4.2룬ֻڼ⵽CPU֧ʱɵã
+                ֻintrinsicsͷļͷļSSE4.2뱻ļ
+**************************************************/
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include "SimdKernels.h"
+#include <string.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+static inline int firstBit(unsigned int mask)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (int)index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+
+static void sse42ByteSwap16(uint16_t *data, int n)
+{
+	const __m128i shuffle = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+		_mm_storeu_si128((__m128i *)(data + i), _mm_shuffle_epi8(v, shuffle));
+	}
+	ScalarByteSwap16(data + i, n - i);
+}
+
+
+static void sse42WidenU16ToFloat(const uint16_t *src, float *dst, int n)
+{
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm_storeu_ps(dst + i, _mm_cvtepi32_ps(_mm_cvtepu16_epi32(v)));
+		_mm_storeu_ps(dst + i + 4, _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_srli_si128(v, 8))));
+	}
+	ScalarWidenU16ToFloat(src + i, dst + i, n - i);
+}
+
+
+static void sse42WidenU16ToInt(const uint16_t *src, int *dst, int n)
+{
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_cvtepu16_epi32(v));
+		_mm_storeu_si128((__m128i *)(dst + i + 4), _mm_cvtepu16_epi32(_mm_srli_si128(v, 8)));
+	}
+	ScalarWidenU16ToInt(src + i, dst + i, n - i);
+}
+
+
+static void sse42Gaussian5(const float *src, float *dst, const float kernel[5], int n)
+{
+	const __m128 k0 = _mm_set1_ps(kernel[0]);
+	const __m128 k1 = _mm_set1_ps(kernel[1]);
+	const __m128 k2 = _mm_set1_ps(kernel[2]);
+	const __m128 k3 = _mm_set1_ps(kernel[3]);
+	const __m128 k4 = _mm_set1_ps(kernel[4]);
+	int i = 2;
+	for (; i + 4 <= n - 2; i += 4)
+	{
+		__m128 acc = _mm_mul_ps(_mm_loadu_ps(src + i - 2), k0);
+		acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(src + i - 1), k1));
+		acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(src + i), k2));
+		acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(src + i + 1), k3));
+		acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(src + i + 2), k4));
+		_mm_storeu_ps(dst + i, acc);
+	}
+	ScalarGaussian5(src, dst, kernel, i, n - 2);
+}
+
+
+static void sse42PeelSubtract(float *data, const double *g, int n)
+{
+	int i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 f = _mm_loadu_ps(data + i);
+		__m128d glo = _mm_loadu_pd(g + i);
+		__m128d ghi = _mm_loadu_pd(g + i + 2);
+		__m128d mlo = _mm_cmpgt_pd(_mm_cvtps_pd(f), glo);
+		__m128d mhi = _mm_cmpgt_pd(_mm_cvtps_pd(_mm_movehl_ps(f, f)), ghi);
+		__m128 mask = _mm_shuffle_ps(_mm_castpd_ps(mlo), _mm_castpd_ps(mhi), _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 gf = _mm_movelh_ps(_mm_cvtpd_ps(glo), _mm_cvtpd_ps(ghi));
+		_mm_storeu_ps(data + i, _mm_and_ps(mask, _mm_sub_ps(f, gf)));
+	}
+	ScalarPeelSubtract(data + i, g + i, n - i);
+}
+
+
+static int sse42ArgMaxPositive(const float *data, int n, float *value)
+{
+	int i = 0;
+	__m128 vmax = _mm_setzero_ps();
+	for (; i + 4 <= n; i += 4)
+		vmax = _mm_max_ps(vmax, _mm_loadu_ps(data + i));
+	vmax = _mm_max_ps(vmax, _mm_movehl_ps(vmax, vmax));
+	vmax = _mm_max_ps(vmax, _mm_shuffle_ps(vmax, vmax, 1));
+	float max = _mm_cvtss_f32(vmax);
+
+	int index = -1;
+	if (max > 0)
+	{
+		const __m128 target = _mm_set1_ps(max);
+		for (int j = 0; j < i; j += 4)
+		{
+			int mask = _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(data + j), target));
+			if (mask != 0)
+			{
+				index = j + firstBit((unsigned int)mask);
+				break;
+			}
+		}
+	}
+	for (; i < n; i++)
+	{
+		if (data[i] > max)
+		{
+			max = data[i];
+			index = i;
+		}
+	}
+	*value = max;
+	return index;
+}
+
+
+//ExpApproxͬ˳
+static inline __m128d expApprox(__m128d x)
+{
+	__m128d n = _mm_floor_pd(_mm_add_pd(_mm_mul_pd(x, _mm_set1_pd(ExpLog2e)), _mm_set1_pd(0.5)));
+	__m128d r = _mm_sub_pd(x, _mm_mul_pd(n, _mm_set1_pd(ExpLn2Hi)));
+	r = _mm_sub_pd(r, _mm_mul_pd(n, _mm_set1_pd(ExpLn2Lo)));
+
+	__m128d p = _mm_set1_pd(1.0 / 6227020800.0);
+	p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1.0 / 479001600.0));
+	p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1.0 / 39916800.0));
+	p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1.0 / 3628800.0));
+	p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1.0 / 362880.0));
+	p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1.0 / 40320.0));
+	p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1.0 / 5040.0));
+	p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1.0 / 720.0));
+	p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1.0 / 120.0));
+	p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1.0 / 24.0));
+	p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1.0 / 6.0));
+	p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(0.5));
+	p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1.0));
+	p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1.0));
+
+	__m128i bits = _mm_add_epi64(_mm_cvtepi32_epi64(_mm_cvtpd_epi32(n)), _mm_set1_epi64x(1023));
+	__m128d result = _mm_mul_pd(p, _mm_castsi128_pd(_mm_slli_epi64(bits, 52)));
+
+	const __m128d inf = _mm_castsi128_pd(_mm_set1_epi64x(0x7FF0000000000000LL));
+	result = _mm_blendv_pd(result, _mm_setzero_pd(), _mm_cmplt_pd(x, _mm_set1_pd(ExpMin)));
+	return _mm_blendv_pd(result, inf, _mm_cmpgt_pd(x, _mm_set1_pd(ExpMax)));
+}
+
+
+static void sse42GaussModel(const double *p, int count, double *x, int n)
+{
+	const __m128d sign = _mm_set1_pd(-0.0);
+	int i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		__m128d iv = _mm_set_pd(i + 1, i);
+		__m128d sum = _mm_setzero_pd();
+		for (int k = 0; k < count; k++)
+		{
+			const double *q = p + 3 * k;
+			__m128d d = _mm_sub_pd(iv, _mm_set1_pd(q[1]));
+			__m128d t = _mm_mul_pd(_mm_xor_pd(d, sign), d);
+			__m128d e = expApprox(_mm_div_pd(t, _mm_set1_pd(2 * q[2] * q[2])));
+			__m128d term = _mm_mul_pd(_mm_set1_pd(q[0]), e);
+			sum = (k == 0) ? term : _mm_add_pd(sum, term);
+		}
+		_mm_storeu_pd(x + i, sum);
+	}
+	ScalarGaussModel(p, count, x, i, n);
+}
+
+
+static void sse42GaussJacobian(const double *p, int count, double *jac, int n)
+{
+	const __m128d sign = _mm_set1_pd(-0.0);
+	const int m = 3 * count;
+	int i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		__m128d iv = _mm_set_pd(i + 1, i);
+		double *row = jac + (size_t)i * m;
+		for (int k = 0; k < count; k++)
+		{
+			const double *q = p + 3 * k;
+			__m128d a = _mm_set1_pd(q[0]);
+			__m128d sigma = _mm_set1_pd(q[2]);
+			__m128d d = _mm_sub_pd(iv, _mm_set1_pd(q[1]));
+			__m128d t = _mm_mul_pd(_mm_xor_pd(d, sign), d);
+			__m128d e = expApprox(_mm_div_pd(t, _mm_set1_pd(2 * q[2] * q[2])));
+			__m128d j0 = expApprox(_mm_mul_pd(_mm_div_pd(t, _mm_set1_pd(2 * q[2])), sigma));
+			__m128d ad = _mm_mul_pd(a, d);
+			__m128d j1 = _mm_mul_pd(_mm_div_pd(ad, _mm_set1_pd(q[2] * q[2])), e);
+			__m128d j2 = _mm_mul_pd(_mm_div_pd(_mm_mul_pd(ad, d), _mm_set1_pd(q[2] * q[2] * q[2])), e);
+			_mm_storel_pd(row + 3 * k, j0);
+			_mm_storel_pd(row + 3 * k + 1, j1);
+			_mm_storel_pd(row + 3 * k + 2, j2);
+			_mm_storeh_pd(row + m + 3 * k, j0);
+			_mm_storeh_pd(row + m + 3 * k + 1, j1);
+			_mm_storeh_pd(row + m + 3 * k + 2, j2);
+		}
+	}
+	ScalarGaussJacobian(p, count, jac, i, n);
+}
+
+
+static size_t sse42FindSync(const uint8_t *data, size_t n)
+{
+	const __m128i word = _mm_set1_epi64x((long long)SyncWord);
+	size_t offset = 0;
+	for (; offset + 16 <= n; offset += 16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *)(data + offset));
+		if (_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(v, word))) & 1)
+			return offset;
+	}
+	return ScalarFindSync(data, offset, n);
+}
+
+
+extern const SimdKernels g_sse42Kernels = {
+	ISA_SSE42,
+	sse42ByteSwap16,
+	sse42WidenU16ToFloat,
+	sse42WidenU16ToInt,
+	sse42Gaussian5,
+	sse42PeelSubtract,
+	sse42ArgMaxPositive,
+	sse42GaussModel,
+	sse42GaussJacobian,
+	sse42FindSync
+};
+#endif
@@ -0,0 +1,106 @@
+#ifndef SmallVector_H
+#define SmallVector_H
+
+#include <string.h>
+#include <new>
+#include <type_traits>
+
+
+//洢СԪزNʱݴڶڲڴ棻
+//NʱתΪѴ洢operator new룬AllocCounterΪvectorһ¡ֻڿɰֽڿĽṹ
+template <typename T, int N>
+class SmallVector
+{
+	static_assert(std::is_trivially_copyable<T>::value, "SmallVector only holds trivially copyable types");
+
+public:
+	typedef T *iterator;
+	typedef const T *const_iterator;
+
+	SmallVector() : m_data(m_inline), m_size(0), m_capacity(N) {}
+	SmallVector(const SmallVector &other) : m_data(m_inline), m_size(0), m_capacity(N)
+	{
+		assign(other.begin(), other.end());
+	}
+	SmallVector &operator=(const SmallVector &other)
+	{
+		if (this != &other)
+			assign(other.begin(), other.end());
+		return *this;
+	}
+	~SmallVector()
+	{
+		if (m_data != m_inline)
+			::operator delete(m_data);
+	}
+
+	iterator begin() { return m_data; }
+	iterator end() { return m_data + m_size; }
+	const_iterator begin() const { return m_data; }
+	const_iterator end() const { return m_data + m_size; }
+
+	size_t size() const { return m_size; }
+	size_t capacity() const { return m_capacity; }
+	bool empty() const { return m_size == 0; }
+	T *data() { return m_data; }
+	const T *data() const { return m_data; }
+
+	T &operator[](size_t i) { return m_data[i]; }
+	const T &operator[](size_t i) const { return m_data[i]; }
+	T &front() { return m_data[0]; }
+	T &back() { return m_data[m_size - 1]; }
+
+	void clear() { m_size = 0; }
+
+	void push_back(const T &value)
+	{
+		if (m_size == m_capacity)
+			reserve(m_capacity * 2);
+		m_data[m_size++] = value;
+	}
+
+	//ֻıԪظԪֵʼ
+	void resize(size_t n)
+	{
+		reserve(n);
+		for (size_t i = m_size; i < n; i++)
+			m_data[i] = T();
+		m_size = n;
+	}
+
+	void assign(const_iterator first, const_iterator last)
+	{
+		size_t n = last - first;
+		reserve(n);
+		memmove(m_data, first, n * sizeof(T));
+		m_size = n;
+	}
+
+	iterator erase(iterator pos)
+	{
+		memmove(pos, pos + 1, (end() - pos - 1) * sizeof(T));
+		m_size--;
+		return pos;
+	}
+
+	void reserve(size_t n)
+	{
+		if (n <= m_capacity)
+			return;
+		T *buffer = (T *)::operator new(n * sizeof(T));
+		memcpy(buffer, m_data, m_size * sizeof(T));
+		if (m_data != m_inline)
+			::operator delete(m_data);
+		m_data = buffer;
+		m_capacity = n;
+	}
+
+private:
+	T m_inline[N];		//洢
+	T *m_data;			//ǰѣ
+	size_t m_size;		//Ԫظ
+	size_t m_capacity;	//ǰ
+};
+
+
+#endif
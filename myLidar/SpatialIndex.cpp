@@ -0,0 +1,360 @@
+/*************************************************
+Description:ˮ׵ռ
+**************************************************/
+#include "SpatialIndex.h"
+#include "Platform.h"
+#include "Trace.h"
+#include "WorkerPool.h"
+#include <math.h>
+#include <algorithm>
+
+#define QaParallelMinPoints 2048			//һеڸֵʱָ̳߳
+#define QaMadScale 1.4826					//ֲ̬MADΪ׼ϵ
+
+
+//ֵݣżʱȡмƽ
+static float median(vector<float> &values)
+{
+	size_t mid = values.size() / 2;
+	nth_element(values.begin(), values.begin() + mid, values.end());
+	float m = values[mid];
+	if (values.size() % 2 == 0)
+	{
+		m = (m + *max_element(values.begin(), values.begin() + mid)) / 2;
+	}
+	return m;
+}
+
+
+SpatialIndex::SpatialIndex()
+{
+	m_open = false;
+	m_cellSize = DefaultQaRadius;
+	m_resident = 0;
+	m_maxResident = 0;
+	m_points = 0;
+	m_spilled = 0;
+	m_spill = NULL;
+	m_spillSize = 0;
+	m_spillError = false;
+}
+
+
+SpatialIndex::~SpatialIndex()
+{
+	close();
+}
+
+
+/*************************************************
+Function:       
+Description:    ߳ȡ뾶ڴ޼㳣פޣʱļڵһдʱ
+Input:          spillPath:ʱļ· options:ѡ
+Output:         ǷЧ
+*************************************************/
+bool SpatialIndex::open(const char *spillPath, const QaOptions &options)
+{
+	close();
+	if (!(options.radius > 0))
+	{
+		return false;
+	}
+
+	m_options = options;
+	m_cellSize = options.radius;
+	m_spillPath = spillPath;
+	m_maxResident = max((size_t)QaBlockCells, options.memoryLimit / sizeof(IndexedPoint));
+	m_resident = 0;
+	m_points = 0;
+	m_spilled = 0;
+	m_spillSize = 0;
+	m_spillError = false;
+	m_open = true;
+	return true;
+}
+
+
+void SpatialIndex::add(const IndexedPoint &point)
+{
+	if (!m_open || !isfinite(point.x) || !isfinite(point.y))
+	{
+		return;
+	}
+
+	BlockKey key = { floorDiv((int64_t)floor(point.x / m_cellSize), QaBlockCells),
+		floorDiv((int64_t)floor(point.y / m_cellSize), QaBlockCells) };
+	m_blocks[key].points.push_back(point);
+	m_points++;
+	if (++m_resident >= m_maxResident)
+	{
+		spill();
+	}
+}
+
+
+/*************************************************
+Function:       дפ
+Description:    ĳפ׷ӵʱļĩβ¼λãͷųפڴ
+Input:
+Output:
+*************************************************/
+void SpatialIndex::spill()
+{
+	if (m_spill == NULL)
+	{
+		m_spill = fopen(m_spillPath.c_str(), "w+b");
+		if (m_spill == NULL)
+		{
+			m_spillError = true;
+			return;
+		}
+	}
+
+	_fseeki64(m_spill, m_spillSize, SEEK_SET);
+	for (auto &item : m_blocks)
+	{
+		Block &block = item.second;
+		if (block.points.empty())
+		{
+			continue;
+		}
+
+		size_t count = block.points.size();
+		if (fwrite(block.points.data(), sizeof(IndexedPoint), count, m_spill) != count)
+		{
+			m_spillError = true;
+			return;
+		}
+		SpillChunk chunk = { m_spillSize, count };
+		block.chunks.push_back(chunk);
+		m_spillSize += count * sizeof(IndexedPoint);
+		m_spilled += count;
+		vector<IndexedPoint>().swap(block.points);
+	}
+	m_resident = 0;
+}
+
+
+/*************************************************
+Function:       
+Description:    ʱļеĵͳפ㣬ڸ򲢼¼ʼλã
+                ͷĳפڴ棨ֻһ飩
+Input:          key: block:
+Output:         loaded:ĵ
+*************************************************/
+void SpatialIndex::loadBlock(const BlockKey &key, Block &block, LoadedBlock &loaded)
+{
+	vector<IndexedPoint> points;
+	for (size_t i = 0; i < block.chunks.size(); i++)
+	{
+		const SpillChunk &chunk = block.chunks[i];
+		size_t start = points.size();
+		points.resize(start + chunk.count);
+		if (_fseeki64(m_spill, chunk.offset, SEEK_SET) != 0
+			|| fread(&points[start], sizeof(IndexedPoint), chunk.count, m_spill) != chunk.count)
+		{
+			points.resize(start);
+			m_spillError = true;
+		}
+	}
+	points.insert(points.end(), block.points.begin(), block.points.end());
+	vector<IndexedPoint>().swap(block.points);
+	block.chunks.clear();
+
+	//
+	const int cells = QaBlockCells * QaBlockCells;
+	vector<uint32_t> cellOf(points.size());
+	loaded.cellStart.assign(cells + 1, 0);
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		int64_t cx = (int64_t)floor(points[i].x / m_cellSize) - key.x * QaBlockCells;
+		int64_t cy = (int64_t)floor(points[i].y / m_cellSize) - key.y * QaBlockCells;
+		cellOf[i] = (uint32_t)(cy * QaBlockCells + cx);
+		loaded.cellStart[cellOf[i] + 1]++;
+	}
+	for (int c = 0; c < cells; c++)
+	{
+		loaded.cellStart[c + 1] += loaded.cellStart[c];
+	}
+
+	vector<uint32_t> next(loaded.cellStart.begin(), loaded.cellStart.end() - 1);
+	loaded.points.resize(points.size());
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		loaded.points[next[cellOf[i]]++] = points[i];
+	}
+}
+
+
+/*************************************************
+Function:       һ
+Description:    ڸΧ8ҳ벻뾶ĵ㣨
+                ʱΪ㣻ˮֵMAD
+                ֵ֮madThreshold׼MADСminSigmaʱΪȺ
+Input:          point: loaded: depths/deviations:ʱ
+Output:         
+*************************************************/
+int SpatialIndex::checkPoint(const IndexedPoint &point, const LoadedMap &loaded, vector<float> &depths, vector<float> &deviations) const
+{
+	const double r2 = m_options.radius * m_options.radius;
+	int64_t cx = (int64_t)floor(point.x / m_cellSize);
+	int64_t cy = (int64_t)floor(point.y / m_cellSize);
+
+	depths.clear();
+	for (int64_t gy = cy - 1; gy <= cy + 1; gy++)
+	{
+		for (int64_t gx = cx - 1; gx <= cx + 1; gx++)
+		{
+			BlockKey key = { floorDiv(gx, QaBlockCells), floorDiv(gy, QaBlockCells) };
+			auto it = loaded.find(key);
+			if (it == loaded.end())
+			{
+				continue;
+			}
+
+			const LoadedBlock &block = it->second;
+			size_t cell = (size_t)((gy - key.y * QaBlockCells) * QaBlockCells + (gx - key.x * QaBlockCells));
+			for (uint32_t k = block.cellStart[cell]; k < block.cellStart[cell + 1]; k++)
+			{
+				const IndexedPoint &q = block.points[k];
+				double dx = q.x - point.x;
+				double dy = q.y - point.y;
+				if (&q != &point && dx * dx + dy * dy <= r2)
+				{
+					depths.push_back(q.depth);
+				}
+			}
+		}
+	}
+
+	if ((int)depths.size() < m_options.minNeighbours || depths.empty())
+	{
+		return QA_ISOLATED;
+	}
+
+	float m = median(depths);
+	deviations.resize(depths.size());
+	for (size_t i = 0; i < depths.size(); i++)
+	{
+		deviations[i] = fabs(depths[i] - m);
+	}
+	double sigma = max(QaMadScale * median(deviations), m_options.minSigma);
+	return (fabs(point.depth - m) > m_options.madThreshold * sigma) ? QA_OUTLIER : QA_ACCEPTED;
+}
+
+
+void SpatialIndex::checkRange(const vector<const IndexedPoint *> &points, size_t begin, size_t end, const LoadedMap &loaded, vector<uint8_t> &flags) const
+{
+	vector<float> depths;
+	vector<float> deviations;
+	for (size_t i = begin; i < end; i++)
+	{
+		flags[i] = (uint8_t)checkPoint(*points[i], loaded, depths, deviations);
+	}
+}
+
+
+/*************************************************
+Function:       
+Description:    鰴д뱾кһУжһ֮ǰУ
+                еĵֶν̳߳ؼ飨ֻĿ飩
+                ȫɺڵ߳а˳
+Input:          pool:̳߳أȡãNULLʱڵ߳м output:ÿ㼰
+Output:         ͳ
+*************************************************/
+QaStats SpatialIndex::filter(WorkerPool *pool, const function<void(const IndexedPoint &, int)> &output)
+{
+	QaStats stats = { 0, 0, 0, m_spilled };
+	if (!m_open)
+	{
+		return stats;
+	}
+
+	vector<BlockKey> keys;
+	keys.reserve(m_blocks.size());
+	for (auto &item : m_blocks)
+	{
+		keys.push_back(item.first);
+	}
+	sort(keys.begin(), keys.end(), [](const BlockKey &a, const BlockKey &b) { return a.y < b.y || (a.y == b.y && a.x < b.x); });
+
+	const int threads = pool != NULL ? pool->threads() : 1;
+
+	LoadedMap loaded;
+	vector<const IndexedPoint *> center;
+	vector<uint8_t> flags;
+	size_t rowBegin = 0;
+	while (rowBegin < keys.size())
+	{
+		int64_t row = keys[rowBegin].y;
+		size_t rowEnd = rowBegin;
+		while (rowEnd < keys.size() && keys[rowEnd].y == row) rowEnd++;
+		size_t nextEnd = rowEnd;
+		while (nextEnd < keys.size() && keys[nextEnd].y == row + 1) nextEnd++;
+
+		TraceScope trace("qaRow");
+
+		//жزڵУ뱾кһУһڴһʱ룩
+		for (auto it = loaded.begin(); it != loaded.end();)
+		{
+			it = (it->first.y < row - 1) ? loaded.erase(it) : ++it;
+		}
+		for (size_t k = rowBegin; k < nextEnd; k++)
+		{
+			if (loaded.find(keys[k]) == loaded.end())
+			{
+				loadBlock(keys[k], m_blocks[keys[k]], loaded[keys[k]]);
+			}
+		}
+
+		center.clear();
+		for (size_t k = rowBegin; k < rowEnd; k++)
+		{
+			const LoadedBlock &block = loaded[keys[k]];
+			for (size_t p = 0; p < block.points.size(); p++)
+			{
+				center.push_back(&block.points[p]);
+			}
+		}
+		flags.resize(center.size());
+
+		if (threads > 1 && center.size() >= QaParallelMinPoints)
+		{
+			size_t step = (center.size() + threads - 1) / threads;
+			int pieces = (int)((center.size() + step - 1) / step);
+			pool->run(pieces, [&](int piece)
+			{
+				size_t begin = piece * step;
+				checkRange(center, begin, min(begin + step, center.size()), loaded, flags);
+			});
+		}
+		else
+		{
+			checkRange(center, 0, center.size(), loaded, flags);
+		}
+
+		for (size_t k = 0; k < center.size(); k++)
+		{
+			stats.points++;
+			if (flags[k] == QA_ISOLATED) stats.isolated++;
+			if (flags[k] == QA_OUTLIER) stats.outliers++;
+			output(*center[k], flags[k]);
+		}
+		rowBegin = rowEnd;
+	}
+	return stats;
+}
+
+
+void SpatialIndex::close()
+{
+	if (m_spill != NULL)
+	{
+		fclose(m_spill);
+		m_spill = NULL;
+		remove(m_spillPath.c_str());
+	}
+	m_blocks.clear();
+	m_resident = 0;
+	m_open = false;
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <functional>
+using namespace std;
+
+class WorkerPool;
+
+#define QaBlockCells 64						//ÿı߳߳뾶
+#define DefaultQaRadius 2.0					//Ĭ뾶굥λͬUTMʱΪm
+#define DefaultQaMemoryLimit (256 << 20)	//Ĭϳפڴĵֽ
+
+
+//ˮ׵
+enum QaFlag
+{
+	QA_ACCEPTED = 0,			//ͨ
+	QA_ISOLATED = 1,			//
+	QA_OUTLIER = 2				//ƫֵֵ
+};
+
+
+//ѡ
+struct QaOptions
+{
+	bool enabled;				//Ƿ
+	double radius;				//뾶
+	int minNeighbours;			//ڣٵ
+	double madThreshold;		//ֵ֮ñı׼MAD1.4826*MADʱ޳
+	double minSigma;			//׼MADޣmˮƽ̹ʱֵΪ0
+	size_t memoryLimit;			//פڴĵֽʱѵдʱļ
+
+	QaOptions() : enabled(true), radius(DefaultQaRadius), minNeighbours(3), madThreshold(3.0),
+		minSigma(0.05), memoryLimit(DefaultQaMemoryLimit) {}
+};
+
+
+//еˮ׵
+struct IndexedPoint
+{
+	double x;					//ƽ꣨UTM򾭶ȣ
+	double y;					//ƽ꣨UTMγȣ
+	double lon;
+	double lat;
+	double gpsTime;
+	float height;				//ˮ
+	float depth;				//ֱˮ
+};
+
+
+//ͳ
+struct QaStats
+{
+	uint64_t points;
+	uint64_t isolated;
+	uint64_t outliers;
+	uint64_t spilledPoints;		//дʱļĵ
+};
+
+
+//ˮ׵ռƽѵֵ߳ΪQaBlockCells뾶飬룻
+//פڴʱѸĵ׷дʱļ
+//ʱδֻڴУͬһеĵָ̳߳صĸ̲߳м
+class SpatialIndex
+{
+public:
+	SpatialIndex();
+	~SpatialIndex();
+
+	bool open(const char *spillPath, const QaOptions &options);
+	void add(const IndexedPoint &point);
+	//мȫ㣬һмڵ߳еĵͼpoolΪNULLʱڵ߳м
+	QaStats filter(WorkerPool *pool, const function<void(const IndexedPoint &, int)> &output);
+	void close();								//ɾʱļ
+
+	bool isOpen() const { return m_open; }
+	uint64_t pointCount() const { return m_points; }
+
+private:
+	struct BlockKey
+	{
+		int64_t x;
+		int64_t y;
+		bool operator==(const BlockKey &other) const { return x == other.x && y == other.y; }
+	};
+
+	struct BlockKeyHash
+	{
+		size_t operator()(const BlockKey &key) const
+		{
+			return (size_t)(key.x * 0x9E3779B97F4A7C15ULL ^ (key.y + 0x632BE59BD9B4E019ULL));
+		}
+	};
+
+	struct SpillChunk
+	{
+		int64_t offset;			//ʱļеƫ
+		size_t count;			//
+	};
+
+	//飺פĵдʱļĵ
+	struct Block
+	{
+		vector<IndexedPoint> points;
+		vector<SpillChunk> chunks;
+	};
+
+	//ʱ飺㰴cellStartΪpointsеʼλ
+	struct LoadedBlock
+	{
+		vector<IndexedPoint> points;
+		vector<uint32_t> cellStart;
+	};
+
+	typedef unordered_map<BlockKey, LoadedBlock, BlockKeyHash> LoadedMap;
+
+	void spill();												//ѳפĵдʱļ
+	void loadBlock(const BlockKey &key, Block &block, LoadedBlock &loaded);	//벢
+	int checkPoint(const IndexedPoint &point, const LoadedMap &loaded, vector<float> &depths, vector<float> &deviations) const;
+	void checkRange(const vector<const IndexedPoint *> &points, size_t begin, size_t end, const LoadedMap &loaded, vector<uint8_t> &flags) const;
+
+	bool m_open;
+	QaOptions m_options;
+	double m_cellSize;				//߳뾶
+	unordered_map<BlockKey, Block, BlockKeyHash> m_blocks;
+	size_t m_resident;				//פ
+	size_t m_maxResident;			//פ
+	uint64_t m_points;
+	uint64_t m_spilled;
+
+	FILE *m_spill;
+	string m_spillPath;
+	int64_t m_spillSize;			//ʱļ
+	bool m_spillError;
+};
@@ -0,0 +1,377 @@
+/*************************************************
+Description:ϳHSԭʼļֵ
+**************************************************/
+#include "SyntheticData.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#define SynthPi 3.14159265358979323846
+#define SynthMetersPerDegree 111320.0		//ÿγȵĽƳȣm
+#define SynthSigmaRange 6					//˹زļ㷶Χsigmaı
+#define SynthShallowSurface { 55, 75 }		//һλزˮزλ÷Χ
+#define SynthDeepSurface { 250, 330 }		//λزˮزλ÷Χ
+#define SynthBottomMargin 10				//һλزˮ׻زĩβС
+#define SynthDeepTailMargin 100				//λزˮ׻زĩβС루βݻᱻ޳
+#define SynthMaxJunk 256					//ֽڵ󳤶
+
+
+SynthOptions::SynthOptions()
+{
+	seed = 1;
+	deep = false;
+	deepLength = 1006;
+	pulseRate = 5000;
+	angle = 0;
+	minDepth = 2;
+	maxDepth = 15;
+	surfaceAmplitude[0] = 300;
+	surfaceAmplitude[1] = 590;
+	bottomAmplitude[0] = 80;
+	bottomAmplitude[1] = 250;
+	surfaceSigma = 3;
+	bottomSigma = 4;
+	baseline = 100;
+	noise = 0.2;
+	corruptRate = 0;
+	corruptKinds = (1 << SYNTH_BITFLIP) | (1 << SYNTH_BADSYNC) | (1 << SYNTH_TRUNCATED) | (1 << SYNTH_JUNK);
+	gpsWeek = 2040;
+	gpsSecond = 200000;
+	lat = 22.5;
+	lon = 113.9;
+	height = 50;
+	heading = 90;
+	speed = 60;
+	codeDiscResolution = 16;
+	scanRate = 20;
+}
+
+
+//׷˫
+static void put16(vector<uint8_t> &out, uint16_t v) { out.push_back((uint8_t)(v >> 8)); out.push_back((uint8_t)v); }
+static void put32(vector<uint8_t> &out, uint32_t v) { put16(out, (uint16_t)(v >> 16)); put16(out, (uint16_t)v); }
+static void putDouble(vector<uint8_t> &out, double v)
+{
+	uint64_t bits;
+	memcpy(&bits, &v, sizeof(bits));
+	put32(out, (uint32_t)(bits >> 32));
+	put32(out, (uint32_t)bits);
+}
+
+
+/*************************************************
+Function:       ϳ
+Description:    ̬ˮʽÿˮӦĻزʱ
+                һλزͬWaveData::CalcuDepthǣλزͬDeepWave::CalcuDeepDepthByRed
+Input:          options:ϳɲ
+Output:
+*************************************************/
+HsSynthesizer::HsSynthesizer(const SynthOptions &options) : m_options(options), m_rng(options.seed)
+{
+	//֡Ϊ16ֽڵ88+3*(654+2*L1)+650  0 (mod 16)L1ģ86
+	if (m_options.deepLength < 6)
+	{
+		m_options.deepLength = 6;
+	}
+	m_options.deepLength += (6 - m_options.deepLength % 8 + 8) % 8;
+
+	normal_distribution<float> gauss(0, 1);
+	mt19937_64 noiseRng(options.seed ^ 0x9E3779B97F4A7C15ULL);
+	m_noiseTable.resize(SynthNoiseTableSize);
+	for (size_t i = 0; i < m_noiseTable.size(); i++)
+	{
+		m_noiseTable[i] = gauss(noiseRng);
+	}
+
+	m_shallowNsPerMeter = 2 * SynthShallowWater / (SynthLightSpeed * cos(asin(sin(m_options.angle) / SynthShallowWater)));
+	m_deepNsPerMeter = 2 * SynthDeepWater / SynthLightSpeed;
+}
+
+
+double HsSynthesizer::uniform(double a, double b)
+{
+	return a + (b - a) * ((m_rng() >> 11) * (1.0 / 9007199254740992.0));
+}
+
+
+/*************************************************
+Function:       ϳɲ
+Description:    ˹زֻSynthSigmaRangesigmaۼӣ
+                ̬λðȡ
+Input:          n: center/amplitude/sigma:ز count:ز
+Output:         out:ֵ
+*************************************************/
+void HsSynthesizer::wave(int n, const double *center, const double *amplitude, const double *sigma, int count, uint16_t *out)
+{
+	vector<float> value(n, (float)m_options.baseline);
+	for (int k = 0; k < count; k++)
+	{
+		int first = max(0, (int)floor(center[k] - SynthSigmaRange * sigma[k]));
+		int last = min(n - 1, (int)ceil(center[k] + SynthSigmaRange * sigma[k]));
+		for (int i = first; i <= last; i++)
+		{
+			double t = (i - center[k]) / sigma[k];
+			value[i] += (float)(amplitude[k] * exp(-t * t / 2));
+		}
+	}
+
+	const size_t mask = SynthNoiseTableSize - 1;
+	size_t index = (size_t)m_rng() & mask;
+	size_t stride = ((size_t)m_rng() & mask) | 1;
+	float noise = (float)m_options.noise;
+	for (int i = 0; i < n; i++)
+	{
+		float v = floor(value[i] + noise * m_noiseTable[index] + 0.5f);
+		out[i] = (uint16_t)min(65535.0f, max(0.0f, v));
+		index = (index + stride) & mask;
+	}
+}
+
+
+//дһͨͨͷͨšS0L0͵һβֵdeepCount>=0ʱӶλز
+void HsSynthesizer::channel(vector<uint8_t> &out, uint16_t number, const double *center, const double *amplitude,
+	const double *sigma, int count, const double *deepCenter, const double *deepAmplitude, const double *deepSigma, int deepCount)
+{
+	put32(out, SynthChannelMarker);
+	put16(out, number);
+	put16(out, 0);
+	put16(out, SynthShallowLength);
+	m_samples.resize(max(SynthShallowLength, m_options.deepLength));
+	wave(SynthShallowLength, center, amplitude, sigma, count, m_samples.data());
+	for (int i = 0; i < SynthShallowLength; i++)
+	{
+		put16(out, m_samples[i]);
+	}
+
+	if (deepCount >= 0)
+	{
+		put16(out, SynthShallowLength);
+		put16(out, (uint16_t)m_options.deepLength);
+		wave(m_options.deepLength, deepCenter, deepAmplitude, deepSigma, deepCount, m_samples.data());
+		for (int i = 0; i < m_options.deepLength; i++)
+		{
+			put16(out, m_samples[i]);
+		}
+	}
+}
+
+
+/*************************************************
+Function:       һ֡
+Description:    λתֻĶCH2CH3Ĳֵͬͷ𻵸дͬͷһֽڣ
+                ضϱ֡ͷ֮ȣ16ֽ
+Input:          begin:֡outеʼλ truth.corruption:
+Output:         out:Ķ truth.bytes:ضϺ֡
+*************************************************/
+void HsSynthesizer::corrupt(vector<uint8_t> &out, size_t begin, SynthTruth &truth)
+{
+	size_t frameBytes = out.size() - begin;
+	switch (truth.corruption)
+	{
+	case SYNTH_BITFLIP:
+	{
+		//CH2֡ͷһ֮ͨʼCH2CH3ĲֵԽλز
+		size_t channelBytes = 10 + 2 * SynthShallowLength + (m_options.deep ? 4 + 2 * m_options.deepLength : 0);
+		int flips = 1 + (int)(m_rng() % 8);
+		for (int k = 0; k < flips; k++)
+		{
+			size_t ch = 1 + m_rng() % 2;
+			size_t pos = begin + SynthHeaderSize + ch * channelBytes + 10 + m_rng() % (2 * SynthShallowLength);
+			out[pos] ^= (uint8_t)(1 << (m_rng() % 8));
+		}
+		break;
+	}
+	case SYNTH_BADSYNC:
+	{
+		size_t pos = begin + m_rng() % 8;
+		out[pos] = (uint8_t)(out[pos] ^ (1 + m_rng() % 255));
+		break;
+	}
+	case SYNTH_TRUNCATED:
+	{
+		size_t blocks = (frameBytes - SynthHeaderSize) / SynthFrameAlign;
+		size_t keep = (SynthHeaderSize + SynthFrameAlign - 1) / SynthFrameAlign * SynthFrameAlign + SynthFrameAlign * (m_rng() % blocks);
+		out.resize(begin + keep);
+		break;
+	}
+	default:
+		break;
+	}
+	truth.bytes = (uint32_t)(out.size() - begin);
+}
+
+
+/*************************************************
+Function:       ϳһ֡
+Description:    ƵGPSʱغλã̬ȡڶ̶ɨת٣
+                ˮΪλزеˮλãηΧʱöβˮ׻ز
+Input:          index:֡
+Output:         out:׷ӵ֡ truth:ֵ
+*************************************************/
+void HsSynthesizer::frame(uint64_t index, vector<uint8_t> &out, SynthTruth &truth)
+{
+	memset(&truth, 0, sizeof(truth));
+	truth.frame = index;
+
+	//
+	truth.corruption = SYNTH_INTACT;
+	if (m_options.corruptRate > 0 && uniform(0, 1) < m_options.corruptRate && (m_options.corruptKinds & 0x1E) != 0)
+	{
+		do
+		{
+			truth.corruption = 1 + (int)(m_rng() % 4);
+		} while ((m_options.corruptKinds & (1u << truth.corruption)) == 0);
+	}
+
+	//ֽڣ16ֺֽ֡Ķ룩
+	if (truth.corruption == SYNTH_JUNK)
+	{
+		size_t junk = SynthFrameAlign * (1 + m_rng() % (SynthMaxJunk / SynthFrameAlign));
+		for (size_t i = 0; i < junk; i++)
+		{
+			out.push_back((uint8_t)m_rng());
+		}
+	}
+	size_t begin = out.size();
+	truth.offset = begin;
+
+	//ʱ䡢λú̬
+	double elapsed = index / m_options.pulseRate;
+	double second = m_options.gpsSecond + elapsed;
+	uint16_t week = (uint16_t)(m_options.gpsWeek + (int)floor(second / 604800));
+	second -= 604800 * floor(second / 604800);
+	double distance = m_options.speed * elapsed;
+	double heading = m_options.heading * SynthPi / 180;
+	double lat = m_options.lat + distance * cos(heading) / SynthMetersPerDegree;
+	double lon = m_options.lon + distance * sin(heading) / (SynthMetersPerDegree * cos(lat * SynthPi / 180));
+	double pitch = 0.5 * sin(2 * SynthPi * 0.1 * elapsed);
+	double roll = 1.0 * sin(2 * SynthPi * 0.07 * elapsed);
+	uint32_t code = 0;
+	if (m_options.codeDiscResolution > 0 && m_options.codeDiscResolution < 32)
+	{
+		double turn = m_options.scanRate * elapsed;
+		code = (uint32_t)((turn - floor(turn)) * (double)(1u << m_options.codeDiscResolution));
+	}
+	truth.gpsWeek = week;
+	truth.gpsSecond = second;
+
+	//ˮͻزλ
+	const double shallowRange[2] = SynthShallowSurface;
+	const double deepRange[2] = SynthDeepSurface;
+	truth.depth = uniform(m_options.minDepth, m_options.maxDepth);
+	double surface = uniform(shallowRange[0], shallowRange[1]);
+	double bottom = surface + truth.depth * m_shallowNsPerMeter;
+	double deepSurface = uniform(deepRange[0], deepRange[1]);
+	double deepBottom = deepSurface + truth.depth * m_deepNsPerMeter;
+	bool hasBottom = bottom < SynthShallowLength - SynthBottomMargin;
+	bool hasDeepBottom = deepBottom < m_options.deepLength - SynthDeepTailMargin;
+	truth.shallowSurface = (int)floor(surface + 0.5);
+	truth.shallowBottom = hasBottom ? (int)floor(bottom + 0.5) : -1;
+	truth.deepSurface = m_options.deep ? (int)floor(deepSurface + 0.5) : -1;
+	truth.deepBottom = (m_options.deep && hasDeepBottom) ? (int)floor(deepBottom + 0.5) : -1;
+
+	//֡ͷ
+	const uint8_t sync[8] = SynthSync;
+	out.insert(out.end(), sync, sync + 8);
+	put16(out, 0);
+	put16(out, week);
+	putDouble(out, second);
+	put32(out, (uint32_t)(index % 1000000));
+	putDouble(out, m_options.heading);
+	putDouble(out, pitch);
+	putDouble(out, roll);
+	putDouble(out, lat);
+	putDouble(out, lon);
+	putDouble(out, m_options.height);
+	put32(out, m_options.codeDiscResolution);
+	put32(out, code);
+	put32(out, 4);
+	put32(out, SynthShallowLength);
+
+	//CH1ֻˮزCH2ˮ׻زCH3̹ˮ׻زǿCH4ֻб
+	double surfaceA = uniform(m_options.surfaceAmplitude[0], m_options.surfaceAmplitude[1]);
+	double bottomA = uniform(m_options.bottomAmplitude[0], m_options.bottomAmplitude[1]);
+	double center[2] = { surface, bottom };
+	double deepCenter[2] = { deepSurface, deepBottom };
+	double sigma[2] = { m_options.surfaceSigma, m_options.bottomSigma };
+	double redA[1] = { surfaceA * 0.5 };
+	double blueA[2] = { surfaceA, bottomA * 0.6 };
+	double greenA[2] = { surfaceA, bottomA };
+	int deepCount = m_options.deep ? (hasDeepBottom ? 2 : 1) : -1;
+	int count = hasBottom ? 2 : 1;
+	channel(out, 1, center, redA, sigma, 1, deepCenter, redA, sigma, m_options.deep ? 1 : -1);
+	channel(out, 2, center, blueA, sigma, count, deepCenter, blueA, sigma, deepCount);
+	channel(out, 3, center, greenA, sigma, count, deepCenter, greenA, sigma, deepCount);
+	channel(out, 4, center, NULL, sigma, 0, deepCenter, NULL, sigma, -1);
+
+	truth.bytes = (uint32_t)(out.size() - begin);
+	if (truth.corruption != SYNTH_INTACT && truth.corruption != SYNTH_JUNK)
+	{
+		corrupt(out, begin, truth);
+	}
+}
+
+
+/*************************************************
+Function:       ϳԭʼļ
+Description:    ֡ϳɺдֵ֡дΪCSV
+                ֡,ƫ,ֽ,GPS,,ˮ,һˮ,һˮ,ˮ,ˮ,
+Input:          path:· truthPath:ֵ·ΪNULL options:ϳɲ
+                frames:֡ bytes:֡Ϊ0ʱļС writeOptions:дļѡ
+Output:         stats:ϳͳƣǷȫдɹ
+*************************************************/
+bool GenerateRawFile(const char *path, const char *truthPath, const SynthOptions &options,
+	uint64_t frames, uint64_t bytes, const WriteOptions &writeOptions, SynthStats &stats)
+{
+	memset(&stats, 0, sizeof(stats));
+	BufferedFile raw;
+	if (!raw.open(path, "wb", writeOptions))
+	{
+		return false;
+	}
+	BufferedFile truthFile;
+	if (truthPath != NULL)
+	{
+		if (!truthFile.open(truthPath, "wb", writeOptions))
+		{
+			raw.close();
+			return false;
+		}
+		const char *title = "frame,offset,bytes,gpsWeek,gpsSecond,depth,shallowSurface,shallowBottom,deepSurface,deepBottom,corruption\n";
+		truthFile.write(title, strlen(title));
+	}
+
+	HsSynthesizer synth(options);
+	vector<uint8_t> buffer;
+	SynthTruth truth;
+	char line[256];
+	for (uint64_t index = 0; frames > 0 ? index < frames : stats.bytes < bytes; index++)
+	{
+		buffer.clear();
+		synth.frame(index, buffer, truth);
+		raw.write(buffer.data(), buffer.size());
+		truth.offset += stats.bytes;
+		stats.bytes += buffer.size();
+		stats.frames++;
+		if (truth.corruption != SYNTH_INTACT)
+		{
+			stats.corrupted++;
+		}
+
+		if (truthPath != NULL)
+		{
+			int n = snprintf(line, sizeof(line), "%llu,%llu,%u,%u,%.6f,%.4f,%d,%d,%d,%d,%d\n",
+				(unsigned long long)truth.frame, (unsigned long long)truth.offset, truth.bytes,
+				(unsigned)truth.gpsWeek, truth.gpsSecond, truth.depth, truth.shallowSurface, truth.shallowBottom,
+				truth.deepSurface, truth.deepBottom, truth.corruption);
+			truthFile.write(line, n);
+		}
+	}
+
+	bool ok = raw.close();
+	if (truthPath != NULL)
+	{
+		ok = truthFile.close() && ok;
+	}
+	return ok;
+}
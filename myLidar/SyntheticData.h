@@ -0,0 +1,124 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include <random>
+#include "BufferedFile.h"
+using namespace std;
+
+
+#define SynthSync { 1, 35, 69, 103, 137, 171, 205, 239 }	//֡ͬͷ
+#define SynthChannelMarker 3952125274u		//ͨͷ0xEB90...
+#define SynthHeaderSize 88					//֡ͷֽ
+#define SynthShallowLength 320				//һλز
+#define SynthFrameAlign 16					//ֽ֡֡ȡʱ16ֽڲѰ֡ͷ
+#define SynthNoiseTableSize 65536			//Ԥɵ̬
+#define SynthShallowWater 1.334				//WaveDataˮһµ
+#define SynthDeepWater 1.34					//DeepWaveˮһµ
+#define SynthLightSpeed 0.3					//ˮһµĹ٣m/ns
+
+
+//
+enum SynthCorruption
+{
+	SYNTH_INTACT = 0,			//
+	SYNTH_BITFLIP = 1,			//תλ
+	SYNTH_BADSYNC = 2,			//֡ͬͷ𻵣֡Ӧ
+	SYNTH_TRUNCATED = 3,		//֡;ض
+	SYNTH_JUNK = 4				//֡ǰֽ
+};
+
+
+//ϳɲ
+struct SynthOptions
+{
+	uint64_t seed;				//ӣͬͬļ
+	bool deep;					//CH1~CH3Ƿλز
+	int deepLength;				//λزȣȡģ86ʹ֡Ϊ16ֽ
+	double pulseRate;			//ƵʣHz
+	double angle;				//ǣļ㹫ʽزʱ˵ֵͬ
+	double minDepth;			//ˮΧm
+	double maxDepth;
+	double surfaceAmplitude[2];	//ˮزΧ
+	double bottomAmplitude[2];	//ˮ׻زΧ
+	double surfaceSigma;		//ˮزȣ㣩
+	double bottomSigma;			//ˮ׻ز
+	double baseline;			//
+	double noise;				//׼
+	double corruptRate;			//ÿ֡𻵵ĸ
+	uint32_t corruptKinds;		//õͣ1<<SynthCorruptionϣ
+
+	//ƽ̨켣
+	uint16_t gpsWeek;
+	double gpsSecond;			//ʼ
+	double lat;					//ʼγȣ㣩
+	double lon;					//ʼȣ㣩
+	double height;				//ߣm
+	double heading;				//򣨡㣩
+	double speed;				//٣m/s
+	uint32_t codeDiscResolution;	//λ0Ϊɨ跽λ
+	double scanRate;			//ɨ辵ת٣ת/s
+
+	SynthOptions();
+};
+
+
+//һֵ֡
+struct SynthTruth
+{
+	uint64_t frame;				//֡
+	uint64_t offset;			//֡ļеʼλãֽ֮
+	uint32_t bytes;				//дֽ֡
+	uint16_t gpsWeek;
+	double gpsSecond;
+	double depth;				//ˮm
+	int shallowSurface;			//һλزˮ桢ˮ׻زλã㣩ڷΧʱΪ-1
+	int shallowBottom;
+	int deepSurface;			//λزˮ桢ˮ׻زλ
+	int deepBottom;
+	int corruption;				//SynthCorruption
+};
+
+
+//ϳͳ
+struct SynthStats
+{
+	uint64_t frames;
+	uint64_t bytes;
+	uint64_t corrupted;
+};
+
+
+//HSԭʼݺϳɣ֡ͷΪ4ͨͨͷͨšS0L0320ֵ
+//CH1~CH3ɴλزCH1⣩ֻˮزCH2CH3̣ˮˮ׻زCH4ֻб
+//ˮڸΧˮ浽ˮ׵Ļزʱˮʽ㣬ɵõֵ֪Ĳ
+class HsSynthesizer
+{
+public:
+	HsSynthesizer(const SynthOptions &options);
+
+	//ɵindex֡׷ӵoutֵoffsetoutԭȣ
+	void frame(uint64_t index, vector<uint8_t> &out, SynthTruth &truth);
+
+	//֡ϳnĲΣ߼Ӹ˹زȡuint16Χ
+	void wave(int n, const double *center, const double *amplitude, const double *sigma, int count, uint16_t *out);
+
+	const SynthOptions &options() const { return m_options; }
+
+private:
+	double uniform(double a, double b);
+	void channel(vector<uint8_t> &out, uint16_t number, const double *center, const double *amplitude,
+		const double *sigma, int count, const double *deepCenter, const double *deepAmplitude, const double *deepSigma, int deepCount);
+	void corrupt(vector<uint8_t> &out, size_t begin, SynthTruth &truth);
+
+	SynthOptions m_options;
+	mt19937_64 m_rng;
+	vector<float> m_noiseTable;		//̬δλðȡ
+	vector<uint16_t> m_samples;
+	double m_shallowNsPerMeter;		//һλزÿˮӦ˫ʱ䣨ns
+	double m_deepNsPerMeter;		//λزÿˮӦ˫ʱ
+};
+
+
+//ϳԭʼļ֡frames>0ʱ֡дbytesֽڣtruthPathǿʱдֵCSV
+bool GenerateRawFile(const char *path, const char *truthPath, const SynthOptions &options,
+	uint64_t frames, uint64_t bytes, const WriteOptions &writeOptions, SynthStats &stats);
@@ -4,6 +4,8 @@ Date:2019-01-02
 Description:ʱϵͳת
 **************************************************/
 #include "TimeConvert.h"
+#include "Platform.h"
+#include <math.h>
 
 
 double FRAC(double morigin)
@@ -64,40 +66,78 @@ void GPSTimeToJulianDay(PGPSTIME pgt, PJULIANDAY pjd)
 
 void CommonTimeToGPSTime(PCOMMONTIME pct, PGPSTIME pgt)
 {
-	PJULIANDAY pjd = new JULIANDAY;
-	CommonTimeToJulianDay(pct, pjd);
-	JulianDayToGPSTime(pjd, pgt);
-	delete pjd;
+	JULIANDAY jd;
+	CommonTimeToJulianDay(pct, &jd);
+	JulianDayToGPSTime(&jd, pgt);
 }
 
 void GPSTimeToCommonTime(PGPSTIME pgt, PCOMMONTIME pct)
 {
-	PJULIANDAY pjd = new JULIANDAY;
-	GPSTimeToJulianDay(pgt, pjd);
-	JulianDayToCommonTime(pjd, pct);
-	delete pjd;//ɾnewָ룬Ȼڴй©
+	JULIANDAY jd;//мջϣ֡ʱڴ
+	GPSTimeToJulianDay(pgt, &jd);
+	JulianDayToCommonTime(&jd, pct);
+}
+
+void InitGPSDayCache(PGPSDAYCACHE pcache)
+{
+	pcache->wn = 0;
+	pcache->dow = -1;
+	pcache->year = 0;
+	pcache->month = 0;
+	pcache->day = 0;
+}
+
+void GPSTimeToCommonTimeCached(int wn, double sow, PGPSDAYCACHE pcache, PCOMMONTIME pct)
+{
+	double whole = floor(sow);
+	long sn = (long)whole;//
+	long dow = sn / 86400;//
+	long sod = sn - dow * 86400;//
+	if (sod < 0)
+	{
+		dow -= 1;
+		sod += 86400;
+	}
+
+	//ʱžռ㵱ڣͬһGPSڵʱֻ
+	if (wn != pcache->wn || dow != pcache->dow)
+	{
+		GPSTIME gt;
+		COMMONTIME midnight;
+		gt.wn = wn;
+		gt.tow.sn = dow * 86400;
+		gt.tow.tos = 0;
+		GPSTimeToCommonTime(&gt, &midnight);
+		pcache->wn = wn;
+		pcache->dow = (int)dow;
+		pcache->year = midnight.year;
+		pcache->month = midnight.month;
+		pcache->day = midnight.day;
+	}
+
+	pct->year = pcache->year;
+	pct->month = pcache->month;
+	pct->day = pcache->day;
+	pct->hour = (int)(sod / 3600);
+	pct->minute = (int)(sod % 3600 / 60);
+	pct->second = sod % 60 + (sow - whole);
 }
 
 void CommonTimeToDOY(PCOMMONTIME pct, PDOY pdoy)
 {
-	PCOMMONTIME pcto = new COMMONTIME;
-	pcto->year = pct->year;
-	pcto->month = 1;
-	pcto->day = 1;
-	pcto->hour = 0;
-	pcto->minute = 0;
-	pcto->second = 0;
+	COMMONTIME cto = { pct->year, 1, 1, 0, 0, 0 };//11ʱ
 
-	PJULIANDAY pjdo = new JULIANDAY;
+	JULIANDAY jdo;
 
 	double JD, JDO;
-	CommonTimeToJulianDay(pcto, pjdo);
-	JDO = pjdo->day + (pjdo->tod.sn + pjdo->tod.tos) / 86400;
+	CommonTimeToJulianDay(&cto, &jdo);
+	JDO = jdo.day + (jdo.tod.sn + jdo.tod.tos) / 86400;
 
-	PJULIANDAY pjd = new JULIANDAY;
-	CommonTimeToJulianDay(pct, pjd);
+	JULIANDAY jd;
+	COMMONTIME ct = *pct;//CommonTimeToJulianDayд12µ£ø
+	CommonTimeToJulianDay(&ct, &jd);
 
-	JD = pjd->day + (pjd->tod.sn + pjd->tod.tos) / 86400;
+	JD = jd.day + (jd.tod.sn + jd.tod.tos) / 86400;
 
 	pdoy->day = short(JD - JDO + 1);
 	pdoy->year = pct->year;
@@ -106,26 +146,15 @@ void CommonTimeToDOY(PCOMMONTIME pct, PDOY pdoy)
 		+ pct->minute * 60 + pct->second);
 	pdoy->tod.tos = pct->second - int(pct->second);    
 	/*pct->hour*3600+pct->minute*60+pct->second-pdoy->tod.sn;*/
-	
-	delete pcto;
-	delete pjdo;
-	delete pjd;
-
 }
 
 void DOYToCommonTime(PDOY pdoy, PCOMMONTIME pct)
 {
-	PCOMMONTIME pcto = new COMMONTIME;
-	pcto->year = pdoy->year;
-	pcto->month = 1;
-	pcto->day = 1;
-	pcto->hour = 0;
-	pcto->minute = 0;
-	pcto->second = 0;
-	PJULIANDAY pjdo = new JULIANDAY;
+	COMMONTIME cto = { pdoy->year, 1, 1, 0, 0, 0 };//11ʱ
+	JULIANDAY jdo;
 	double JD, JDO;
-	CommonTimeToJulianDay(pcto, pjdo);
-	JDO = pjdo->day + (pjdo->tod.sn + pjdo->tod.tos) / 86400;
+	CommonTimeToJulianDay(&cto, &jdo);
+	JDO = jdo.day + (jdo.tod.sn + jdo.tod.tos) / 86400;
 	JD = JDO + pdoy->day + (pdoy->tod.sn + pdoy->tod.tos) / 86400 - 1;
 	long a, b, c, d, e;
 	a = (long)(JD + 0.5);
@@ -141,46 +170,144 @@ void DOYToCommonTime(PDOY pdoy, PCOMMONTIME pct)
 		- pct->hour * 3600) / 60);
 	pct->second = pdoy->tod.sn + pdoy->tod.tos
 		- pct->hour * 3600 - pct->minute * 60;
-
-	delete pcto;
-	delete pjdo;
 }
 
 void GPSTimeToDOY(PGPSTIME pgt, PDOY pdoy)
 {
-	PJULIANDAY pjd = new JULIANDAY;
-	GPSTimeToJulianDay(pgt, pjd);
-	PCOMMONTIME pct = new COMMONTIME;
-	JulianDayToCommonTime(pjd, pct);
-	CommonTimeToDOY(pct, pdoy);
-
-	delete pjd;
-	delete pct;
+	JULIANDAY jd;
+	GPSTimeToJulianDay(pgt, &jd);
+	COMMONTIME ct;
+	JulianDayToCommonTime(&jd, &ct);
+	CommonTimeToDOY(&ct, pdoy);
 }
 
 void DOYToGPSTime(PDOY pdoy, PGPSTIME pgt)
 {
-	PCOMMONTIME pct = new COMMONTIME;
-	DOYToCommonTime(pdoy, pct);
-	CommonTimeToGPSTime(pct, pgt);
-
-	delete pct;
+	COMMONTIME ct;
+	DOYToCommonTime(pdoy, &ct);
+	CommonTimeToGPSTime(&ct, pgt);
 }
 
 void JulianDayToDOY(PJULIANDAY pjd, PDOY pdoy)
 {
-	PCOMMONTIME pct = new COMMONTIME;
-	JulianDayToCommonTime(pjd, pct);
-	CommonTimeToDOY(pct, pdoy);
-
-	delete pct;
+	COMMONTIME ct;
+	JulianDayToCommonTime(pjd, &ct);
+	CommonTimeToDOY(&ct, pdoy);
 }
 
 void DOYToJulianDay(PDOY pdoy, PJULIANDAY pjd)
 {
-	PCOMMONTIME pct = new COMMONTIME;
-	DOYToCommonTime(pdoy, pct);
-	CommonTimeToJulianDay(pct, pjd);
+	COMMONTIME ct;
+	DOYToCommonTime(pdoy, &ct);
+	CommonTimeToJulianDay(&ct, pjd);
+}
 
-	delete pct;
+
+#define GPSEpochUnix 315964800LL		//GPS1980-01-06 00:00:00 UTCUnix
+#define SecondsPerWeek 604800LL
+#define SecondsPerDay 86400LL
+#define NsPerSecond 1000000000LL
+
+//Чʱ̣UTCUnix룩kЧGPS-UTCΪk+1
+//IERSµʱڱβ׷
+static const int64_t leapUnixSecond[] = {
+	362793600,	//1981-07-01
+	394329600,	//1982-07-01
+	425865600,	//1983-07-01
+	489024000,	//1985-07-01
+	567993600,	//1988-01-01
+	631152000,	//1990-01-01
+	662688000,	//1991-01-01
+	709948800,	//1992-07-01
+	741484800,	//1993-07-01
+	773020800,	//1994-07-01
+	820454400,	//1996-01-01
+	867715200,	//1997-07-01
+	915148800,	//1999-01-01
+	1136073600,	//2006-01-01
+	1230768000,	//2009-01-01
+	1341100800,	//2012-07-01
+	1435708800,	//2015-07-01
+	1483228800,	//2017-01-01
+};
+static const int leapCount = sizeof(leapUnixSecond) / sizeof(leapUnixSecond[0]);
+
+int GPSLeapSeconds(int64_t gpsSecond)
+{
+	//һǰ飬ʵݼڵһαȽϾͷ
+	for (int k = leapCount - 1; k >= 0; k--)
+	{
+		if (gpsSecond >= leapUnixSecond[k] - GPSEpochUnix + k + 1)
+			return k + 1;
+	}
+	return 0;
+}
+
+int UnixLeapSeconds(int64_t unixSecond)
+{
+	for (int k = leapCount - 1; k >= 0; k--)
+	{
+		if (unixSecond >= leapUnixSecond[k])
+			return k + 1;
+	}
+	return 0;
+}
+
+void GPSTimeToUnixNs(const uint16_t *week, const double *sow, int64_t *unixNs, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		int64_t ns = (int64_t)(sow[i] * NsPerSecond + 0.5);//룬벻604800double㹻
+		int64_t gpsSecond = week[i] * SecondsPerWeek + (int64_t)sow[i];//ֻжϣ64λ
+		unixNs[i] = (week[i] * SecondsPerWeek + GPSEpochUnix - GPSLeapSeconds(gpsSecond)) * NsPerSecond + ns;
+	}
+}
+
+void UnixNsToGPSTime(const int64_t *unixNs, uint16_t *week, double *sow, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		int64_t unixSecond = floorDiv(unixNs[i], NsPerSecond);
+		int64_t subNs = unixNs[i] - unixSecond * NsPerSecond;
+		int64_t gpsSecond = unixSecond - GPSEpochUnix + UnixLeapSeconds(unixSecond);
+		int64_t wn = floorDiv(gpsSecond, SecondsPerWeek);
+		week[i] = (uint16_t)wn;
+		sow[i] = (double)(gpsSecond - wn * SecondsPerWeek) + subNs / (double)NsPerSecond;
+	}
+}
+
+void UnixNsToCommonTime(const int64_t *unixNs, PCOMMONTIME pct, size_t n)
+{
+	int64_t lastDays = INT64_MIN;	//һڵգڵͬһʱֱ
+	int year = 0, month = 0, day = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		int64_t unixSecond = floorDiv(unixNs[i], NsPerSecond);
+		int64_t subNs = unixNs[i] - unixSecond * NsPerSecond;
+		int64_t days = floorDiv(unixSecond, SecondsPerDay);
+		int64_t sod = unixSecond - days * SecondsPerDay;
+
+		if (days != lastDays)
+		{
+			//1970-01-01ڣ31Ϊף400Ϊһڣȫ
+			int64_t z = days + 719468;
+			int64_t era = floorDiv(z, 146097);
+			int64_t doe = z - era * 146097;								//ڵ[0,146096]
+			int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;	//ڵ[0,399]
+			int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);			//31[0,365]
+			int64_t mp = (5 * doy + 2) / 153;								//3[0,11]
+
+			day = (int)(doy - (153 * mp + 2) / 5 + 1);
+			month = (int)(mp < 10 ? mp + 3 : mp - 9);
+			year = (int)(yoe + era * 400 + (month <= 2));
+			lastDays = days;
+		}
+
+		pct[i].year = year;
+		pct[i].month = month;
+		pct[i].day = day;
+		pct[i].hour = (int)(sod / 3600);
+		pct[i].minute = (int)(sod % 3600 / 60);
+		pct[i].second = sod % 60 + subNs / (double)NsPerSecond;
+	}
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 #ifndef TIMECONVERT_H
 #define TIMECONVERT_H
 
+#include <stdint.h>
+#include <stddef.h>
+
 //UTCʱṹ
 struct Time
 {
@@ -74,6 +77,17 @@ typedef struct tagDOY
 
 typedef DOY *PDOY;
 
+typedef struct tagGPSDAYCACHE
+{
+	int wn;    //ӦGPS
+	int dow;   //Ӧգ-1ʾЧ
+	int year;  //GPS
+	int month;
+	int day;
+}GPSDAYCACHE;//GPSջ棺ͬһGPSڵʱ̹õ
+
+typedef GPSDAYCACHE *PGPSDAYCACHE;
+
 double FRAC(double morigin);// ȡС
 
 
@@ -89,6 +103,10 @@ void CommonTimeToGPSTime(PCOMMONTIME pct, PGPSTIME pgt);//ͨ
 
 void GPSTimeToCommonTime(PGPSTIME pgt, PCOMMONTIME pct);//GPSʱͨʱת
 
+void InitGPSDayCache(PGPSDAYCACHE pcache);//GPSջΪЧ
+
+void GPSTimeToCommonTimeCached(int wn, double sow, PGPSDAYCACHE pcache, PCOMMONTIME pct);//GPSܺ뵽ͨʱתGPSջ棬С֣
+
 void CommonTimeToDOY(PCOMMONTIME pct, PDOY pdoy);//ͨʱ
 
 void DOYToCommonTime(PDOY pdoy, PCOMMONTIME pct);//յͨʱ
@@ -102,4 +120,18 @@ void JulianDayToDOY(PJULIANDAY pjd, PDOY pdoy);//
 void DOYToJulianDay(PDOY pdoy, PJULIANDAY pjd);//յ
 
 
+//תת㣬ڴ棬ʺϴʱʱβѯ
+//UnixʱUTCƣ1970-01-01 00:00:00GPSʱUTC֮õ
+
+int GPSLeapSeconds(int64_t gpsSecond);//GPSʱGPSӦGPS-UTC
+
+int UnixLeapSeconds(int64_t unixSecond);//UTCUnix룩ӦGPS-UTC
+
+void GPSTimeToUnixNs(const uint16_t *week, const double *sow, int64_t *unixNs, size_t n);//GPSܡ뵽Unix
+
+void UnixNsToGPSTime(const int64_t *unixNs, uint16_t *week, double *sow, size_t n);//Unix뵽GPSܡ
+
+void UnixNsToCommonTime(const int64_t *unixNs, PCOMMONTIME pct, size_t n);//Unix뵽ͨʱUTC
+
+
 #endif
\ No newline at end of file
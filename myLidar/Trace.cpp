@@ -0,0 +1,192 @@
+/*************************************************
+Description:ʱ߼¼
+                ̰߳¼дԼĻλдߣ
+                ʱͳһдChrome trace JSONchrome://tracingPerfettoв鿴
+                롢̨д̵߳ص͵ȴ
+**************************************************/
+#include "Trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+
+
+atomic<bool> g_traceEnabled(false);
+
+
+//̵߳¼λֻ߳д룬headreleaseʽдʱacquireʽȡ
+struct TraceRing
+{
+	vector<TraceEvent> events;
+	atomic<uint64_t> head;		//д¼
+	int tid;					//ʱе߳
+	string name;
+
+	TraceRing(int id) : events(TraceRingSize), head(0), tid(id) {}
+};
+
+
+//̵߳Ļ߳˳󻺳ԱдΪֹ
+//˳ʱдJSONatexitԿʹ
+struct TraceRegistry
+{
+	mutex lock;
+	vector<unique_ptr<TraceRing> > rings;
+	string path;				//JSON·
+	int64_t start;				//ʼ¼ʱ
+	bool exitHook;				//Ƿעatexit
+
+	TraceRegistry() : start(0), exitHook(false) {}
+};
+
+static TraceRegistry &registry()
+{
+	static TraceRegistry *r = new TraceRegistry;
+	return *r;
+}
+
+static thread_local TraceRing *threadRing = NULL;
+
+
+int64_t TraceNow()
+{
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+//ǰ̵߳Ļ״ʹʱ
+static TraceRing *currentRing()
+{
+	if (threadRing == NULL)
+	{
+		TraceRegistry &r = registry();
+		lock_guard<mutex> lock(r.lock);
+		r.rings.push_back(unique_ptr<TraceRing>(new TraceRing((int)r.rings.size() + 1)));
+		threadRing = r.rings.back().get();
+	}
+	return threadRing;
+}
+
+
+void TraceRecord(const char *name, int64_t start, int64_t value, char phase)
+{
+	TraceRing *ring = currentRing();
+	uint64_t head = ring->head.load(memory_order_relaxed);
+	TraceEvent &e = ring->events[head & (TraceRingSize - 1)];
+	e.name = name;
+	e.start = start;
+	e.value = value;
+	e.phase = phase;
+	ring->head.store(head + 1, memory_order_release);
+}
+
+
+void TraceThreadName(const char *name)
+{
+	TraceRing *ring = currentRing();
+	lock_guard<mutex> lock(registry().lock);
+	ring->name = name;
+}
+
+
+static void traceAtExit()
+{
+	TraceStop();
+}
+
+
+/*************************************************
+Function:       ʼ¼ʱ
+Description:	ո߳Ѽ¼¼ǰ߳Ϊmain
+				״εʱעatexit˳ǰδTraceStopʱԶд
+Input:          path:Chrome trace JSON·
+Output:			Ƿʼ¼
+*************************************************/
+bool TraceStart(const char *path)
+{
+	if (path == NULL || path[0] == 0)
+		return false;
+	TraceRegistry &r = registry();
+	{
+		lock_guard<mutex> lock(r.lock);
+		r.path = path;
+		r.start = TraceNow();
+		for (size_t i = 0; i < r.rings.size(); i++)
+			r.rings[i]->head.store(0, memory_order_relaxed);
+		if (!r.exitHook)
+		{
+			r.exitHook = true;
+			atexit(traceAtExit);
+		}
+	}
+	TraceThreadName("main");
+	g_traceEnabled = true;
+	return true;
+}
+
+
+/*************************************************
+Function:       ֹͣ¼дChrome trace JSON
+Description:	¼Ϊ"ph":"X"Ϊ"ph":"C"ʱΪԿʼ¼ʱ̵΢
+				ÿ̸߳thread_nameԪݡλдʱֻTraceRingSize¼
+				Ӧڸ̵߳Ĵãд߳¼ܲ
+Input:
+Output:			Ƿдɹδڼ¼ʱtrue
+*************************************************/
+bool TraceStop()
+{
+	if (!g_traceEnabled.exchange(false))
+		return true;
+
+	TraceRegistry &r = registry();
+	lock_guard<mutex> lock(r.lock);
+	FILE *fp = fopen(r.path.c_str(), "w");
+	if (fp == NULL)
+	{
+		printf("Cannot write %s\n", r.path.c_str());
+		return false;
+	}
+
+	uint64_t events = 0;
+	uint64_t overwritten = 0;
+	bool first = true;
+	fprintf(fp, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+	for (size_t k = 0; k < r.rings.size(); k++)
+	{
+		TraceRing &ring = *r.rings[k];
+		uint64_t head = ring.head.load(memory_order_acquire);
+		uint64_t begin = head > TraceRingSize ? head - TraceRingSize : 0;
+		overwritten += begin;
+		if (!ring.name.empty())
+		{
+			fprintf(fp, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+				first ? "" : ",\n", ring.tid, ring.name.c_str());
+			first = false;
+		}
+		for (uint64_t i = begin; i < head; i++)
+		{
+			const TraceEvent &e = ring.events[i & (TraceRingSize - 1)];
+			double ts = (e.start - r.start) / 1000.0;
+			if (e.phase == 'X')
+			{
+				fprintf(fp, "%s{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+					first ? "" : ",\n", e.name, ring.tid, ts, e.value / 1000.0);
+			}
+			else
+			{
+				fprintf(fp, "%s{\"name\": \"%s\", \"ph\": \"C\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"args\": {\"value\": %lld}}",
+					first ? "" : ",\n", e.name, ring.tid, ts, (long long)e.value);
+			}
+			first = false;
+			events++;
+		}
+	}
+	fprintf(fp, "\n]}\n");
+	bool ok = fclose(fp) == 0;
+	printf("\nTrace: %llu events from %d threads (%llu overwritten) written to %s%s.\n",
+		(unsigned long long)events, (int)r.rings.size(), (unsigned long long)overwritten, r.path.c_str(), ok ? "" : ", write failed");
+	return ok;
+}
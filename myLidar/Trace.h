@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+using namespace std;
+
+
+#define TraceRingSize (1 << 18)		//ÿ̵߳¼λС2ݣд󸲸¼
+
+
+//ʱ¼
+struct TraceEvent
+{
+	const char *name;			//¼Ϊַָֻ̬룩
+	int64_t start;				//ʼʱ̣ns
+	int64_t value;				//¼Ϊʱ䣨ns¼Ϊֵ
+	char phase;					//'X'¼ʼͽ'C'
+};
+
+
+extern atomic<bool> g_traceEnabled;
+
+
+bool TraceStart(const char *path);	//ʼ¼TraceStop˳ʱдChrome trace JSON
+bool TraceStop();					//ֹͣ¼дǷдɹ
+int64_t TraceNow();					//ʱӣns
+void TraceRecord(const char *name, int64_t start, int64_t value, char phase);	//¼ǰ̵߳Ļλ
+void TraceThreadName(const char *name);	//õǰ߳ʱʾ
+
+inline bool TraceEnabled()
+{
+	return g_traceEnabled.load(memory_order_relaxed);
+}
+
+//¼гȣ
+inline void TraceCounter(const char *name, int64_t value)
+{
+	if (TraceEnabled())
+		TraceRecord(name, TraceNow(), value, 'C');
+}
+
+
+//¼ʱ¿ʼʱ̣ʱдһ¼δʼ¼ʱֻһοأʱ
+class TraceScope
+{
+public:
+	TraceScope(const char *name) : m_name(name), m_start(TraceEnabled() ? TraceNow() : -1) {}
+	~TraceScope()
+	{
+		if (m_start >= 0)
+			TraceRecord(m_name, m_start, TraceNow() - m_start, 'X');
+	}
+
+private:
+	const char *m_name;
+	int64_t m_start;
+};
@@ -0,0 +1,140 @@
+/*************************************************
+Description:WGS84γȵUTMͶӰ
+**************************************************/
+#include "UtmProjection.h"
+#include <math.h>
+
+#define UtmPi 3.14159265358979323846
+#define UtmDegToRad (UtmPi / 180)
+#define UtmA 6378137.0						//WGS84ᣨm
+#define UtmFlattening (1 / 298.257223563)	//WGS84
+
+
+/*************************************************
+Function:       ѡUTMͶӰ
+Description:    ÿ6һŲϲγ56~64㣬3~12㣩Ϊ32
+                ˹߶Ⱥγ72~84㣩31~37912ϲ
+Input:          lat:γȣ㣩 lon:ȣ㣩
+Output:         ͶӰţ1~60
+*************************************************/
+int UtmZone(double lat, double lon)
+{
+	double lon180 = lon - 360 * floor((lon + 180) / 360);		//㵽[-180,180)
+	int zone = (int)floor((lon180 + 180) / 6) + 1;
+	if (zone > 60)
+	{
+		zone = 60;
+	}
+
+	if (lat >= 56 && lat < 64 && lon180 >= 3 && lon180 < 12)
+	{
+		zone = 32;
+	}
+	else if (lat >= 72 && lat < 84 && lon180 >= 0 && lon180 < 42)
+	{
+		if (lon180 < 9) zone = 31;
+		else if (lon180 < 21) zone = 33;
+		else if (lon180 < 33) zone = 35;
+		else zone = 37;
+	}
+	return zone;
+}
+
+
+/*************************************************
+Function:       ͶӰ
+Description:    ɵn߻ϵAͿϵ1~6
+Input:          zone:ͶӰ north:Ƿ񱱰
+Output:
+*************************************************/
+UtmProjection::UtmProjection(int zone, bool north)
+{
+	double n = UtmFlattening / (2 - UtmFlattening);
+	double n2 = n * n, n3 = n2 * n, n4 = n3 * n, n5 = n4 * n, n6 = n5 * n;
+
+	m_scaleA = UtmScaleFactor * UtmA / (1 + n) * (1 + n2 / 4 + n4 / 64 + n6 / 256);
+	m_eccentricity = 2 * sqrt(n) / (1 + n);
+
+	m_alpha[0] = n / 2 - 2 * n2 / 3 + 5 * n3 / 16 + 41 * n4 / 180 - 127 * n5 / 288 + 7891 * n6 / 37800;
+	m_alpha[1] = 13 * n2 / 48 - 3 * n3 / 5 + 557 * n4 / 1440 + 281 * n5 / 630 - 1983433 * n6 / 1935360;
+	m_alpha[2] = 61 * n3 / 240 - 103 * n4 / 140 + 15061 * n5 / 26880 + 167603 * n6 / 181440;
+	m_alpha[3] = 49561 * n4 / 161280 - 179 * n5 / 168 + 6601661 * n6 / 7257600;
+	m_alpha[4] = 34729 * n5 / 80640 - 3418889 * n6 / 1995840;
+	m_alpha[5] = 212378941 * n6 / 319334400;
+
+	setZone(zone, north);
+}
+
+
+void UtmProjection::setZone(int zone, bool north)
+{
+	m_zone = zone;
+	m_north = north;
+	m_centralLon = (zone * 6 - 183) * UtmDegToRad;
+}
+
+
+/*************************************************
+Function:       
+Description:    γγȵtõī''
+                Ը+i = ' + jsin(2j')򣨦'='+i'
+                Clenshawʵչsin/cos(2')sinh/cosh(2')ɴϵõ
+                ѭûз֧
+Input:          n: lat/lon:γȾȣ㣩
+Output:         east/north:걱꣨m
+*************************************************/
+void UtmProjection::forward(size_t n, const double *__restrict lat, const double *__restrict lon,
+	double *__restrict east, double *__restrict north) const
+{
+	const double e = m_eccentricity;
+	const double lon0 = m_centralLon;
+	const double scaleA = m_scaleA;
+	const double falseNorthing = m_north ? 0 : UtmFalseNorthingSouth;
+	const double a1 = m_alpha[0], a2 = m_alpha[1], a3 = m_alpha[2];
+	const double a4 = m_alpha[3], a5 = m_alpha[4], a6 = m_alpha[5];
+
+	for (size_t i = 0; i < n; i++)
+	{
+		double phi = lat[i] * UtmDegToRad;
+		double lambda = lon[i] * UtmDegToRad - lon0;
+		lambda -= 2 * UtmPi * floor((lambda + UtmPi) / (2 * UtmPi));		//㵽[-,)
+
+		//γ
+		double sinPhi = sin(phi);
+		double t = sinh(atanh(sinPhi) - e * atanh(e * sinPhi));
+
+		//ɰãͬһǶͬʱsincosʱϲΪsincos
+		double u = tan(lambda / 2);
+		double u2 = 1 + u * u;
+		double sinLambda = 2 * u / u2;
+		double cosLambda = (2 - u2) / u2;
+		double xi = atan2(t, cosLambda);
+		double x = sinLambda / sqrt(1 + t * t);
+		double eta = atanh(x);
+
+		//sin(2')2cos(2')2'tcos˴ãe^(2') = (1+x)/(1-x)
+		double r2 = t * t + cosLambda * cosLambda;
+		double s2 = 2 * t * cosLambda / r2, c2 = (cosLambda * cosLambda - t * t) / r2;
+		double ex = (1 + x) / (1 - x), ey = (1 - x) / (1 + x);
+		double sh2 = (ex - ey) / 2, ch2 = (ex + ey) / 2;
+		double sinR = s2 * ch2, sinI = c2 * sh2;
+		double cosR = 2 * c2 * ch2, cosI = -2 * s2 * sh2;
+
+		//Clenshawƣy_k = _k + 2cos(2')y_{k+1} - y_{k+2}
+		double yR = a6, yI = 0;
+		double zR = 0, zI = 0;
+		double wR, wI;
+		wR = a5 + cosR * yR - cosI * yI - zR; wI = cosR * yI + cosI * yR - zI; zR = yR; zI = yI; yR = wR; yI = wI;
+		wR = a4 + cosR * yR - cosI * yI - zR; wI = cosR * yI + cosI * yR - zI; zR = yR; zI = yI; yR = wR; yI = wI;
+		wR = a3 + cosR * yR - cosI * yI - zR; wI = cosR * yI + cosI * yR - zI; zR = yR; zI = yI; yR = wR; yI = wI;
+		wR = a2 + cosR * yR - cosI * yI - zR; wI = cosR * yI + cosI * yR - zI; zR = yR; zI = yI; yR = wR; yI = wI;
+		wR = a1 + cosR * yR - cosI * yI - zR; wI = cosR * yI + cosI * yR - zI; yR = wR; yI = wI;
+
+		//jsin(2j') = sin(2')y_1
+		double sumR = sinR * yR - sinI * yI;
+		double sumI = sinR * yI + sinI * yR;
+
+		north[i] = falseNorthing + scaleA * (xi + sumR);
+		east[i] = UtmFalseEasting + scaleA * (eta + sumI);
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <stddef.h>
+
+
+#define UtmScaleFactor 0.9996				//뾭߱
+#define UtmFalseEasting 500000.0			//ӳm
+#define UtmFalseNorthingSouth 10000000.0	//ϰӳm
+#define UtmSeriesOrder 6					//
+
+
+//γѡUTMͶӰ1~60Ųϲ˹߶Ⱥִ
+int UtmZone(double lat, double lon);
+
+//UTMͶӰӦEPSG루WGS84 / UTM
+inline int UtmEpsg(int zone, bool north) { return (north ? 32600 : 32700) + zone; }
+
+
+//WGS84γȵUTM㣨īͶӰ6׿ھ1mm
+//ͬһͶӰͬһĵ㰴ô㣬֤
+class UtmProjection
+{
+public:
+	UtmProjection(int zone = 31, bool north = true);
+	void setZone(int zone, bool north);
+	int zone() const { return m_zone; }
+	bool north() const { return m_north; }
+	int epsg() const { return UtmEpsg(m_zone, m_north); }
+
+	//lat/lon:γȾȣ㣩 east/north:걱꣨m
+	void forward(size_t n, const double *lat, const double *lon, double *east, double *north) const;
+
+private:
+	int m_zone;
+	bool m_north;
+	double m_centralLon;				//뾭ߣȣ
+	double m_scaleA;					//ӳ߻ϵ
+	double m_eccentricity;				//һƫ
+	double m_alpha[UtmSeriesOrder];		//ϵ
+};
@@ -1,8 +1,15 @@
 #include "WaveData.h"
+#include "Trace.h"
+#include "SimdKernels.h"
 #include <numeric>
+#include <algorithm>
 
 #define PulseWidth 4        //弤ֵο
+#define PeelSigmaRange 6    //ʱ˹ļ㷶Χsigmaı
+#define PeelBlockSize 16    //ʱֵֿĿС
+#define PeelBlockCount (320 / PeelBlockSize)
 #define TimeDifference 8    //UTCʱ
+#define OptimizeWorkSize LM_DER_WORKSZ(6 * 3, 320)    //LMС˹320ֵ
 
 #define BLUE true
 #define GREEN false
@@ -19,7 +26,14 @@
 extern float angle;
 
 
-bool WaveData::ostreamFlag = BLUE;
+thread_local bool WaveData::ostreamFlag = BLUE;
+
+
+//LM̱߳ڴ棨levmarLINSOLVERS_RETAIN_MEMORY߳̽ʱͷ
+struct SolverMemory
+{
+	~SolverMemory() { dAx_eq_b_LU_noLapack(NULL, NULL, NULL, 0); }
+};
 
 
 /*ܣ  ˹
@@ -57,297 +71,154 @@ void gaussian(float src[], float dst[]) {
 	float kernel[5];
 	gau_kernel(kernel, 5, 1);
 	//gaussian,ʱ߽ûӴ
-	for (int i = (5 - 1) / 2; i <= 319 - (5 - 1) / 2; i++) {
-		dst[i] = src[i - 2] * kernel[0] + src[i - 1] * kernel[1] + src[i] * kernel[2] + src[i + 1] * kernel[3] +
-			src[i + 2] * kernel[4];
-	}
+	Kernels().gaussian5(src, dst, kernel, 320);
 }
 
 
-/*ܣ	ݵı׼
-//*:
-//resultSet
-//stdev	ֵΪ׼
-//*
+/*ܣ	һڸֵ
+//temp	
+//first,last	µ䣬ڵĿ
+//blockMax,blockArg	ֵλãֵʱΪ0-1
 */
-float calculateSigma(vector<float> resultSet) {
-	double sum = std::accumulate(std::begin(resultSet), std::end(resultSet), 0.0);
-	double mean = sum / resultSet.size(); //ֵ
-
-	double accum = 0.0;
-	for (vector<float>::iterator iter = resultSet.begin(); iter != resultSet.end(); iter++) {
-		accum += (*iter - mean) * (*iter - mean);
-	};
-
-	float stdev = (float)sqrt(accum / (resultSet.size() - 1)); //
-
-	return stdev;
-}
-
-
-
-/*ܣ	˹ģ
-//*p:	
-//*x  ԭʼݣֵ
-//m	ά
-//n	ֵά
-//*data:
-*/
-void expfun2(double *p, double *x, int m, int n, void *data) {
-	register int i;
-	for (i = 0; i < n; ++i) {
-		//дx[i]֮Ĺϵʽ﷽̵ұûй۲ֵֻв
-		x[i] = p[0] * exp(-(i - p[1]) * (i - p[1]) / (2 * p[2] * p[2]))
-			+ p[3] * exp(-(i - p[4]) * (i - p[4]) / (2 * p[5] * p[5]));
+static void updateBlockMax(const float temp[], int first, int last, float blockMax[], int blockArg[]) {
+	for (int k = first / PeelBlockSize; k <= last / PeelBlockSize; k++) {
+		int arg = Kernels().argMaxPositive(temp + k * PeelBlockSize, PeelBlockSize, &blockMax[k]);
+		blockArg[k] = (arg >= 0) ? k * PeelBlockSize + arg : -1;
 	}
 }
 
 
-/*ܣ	˹ģ͵ſɱȾ
-//*p:	
-//jac ſɱȾ
-//m	ά
-//n	ֵά
-//*data:
+/*ܣ	ɸֵõȫֵ
+//A	ֵֵʱΪ0
+//ֵ	ֵλãɨһȡһֵʱΪ-1
 */
-void jacexpfun2(double *p, double *jac, int m, int n, void *data) {
-	register int i, j;
-	//дſ˱Ⱦ
-	for (i = j = 0; i < n; ++i) {
-		jac[j++] = exp(-(i - p[1]) * (i - p[1]) / (2 * p[2]) * p[2]);
-		jac[j++] = p[0] * (i - p[1]) / (p[2] * p[2]) * exp(-(i - p[1]) * (i - p[1]) / (2 * p[2] * p[2]));
-		jac[j++] = p[0] * (i - p[1]) * (i - p[1]) / (p[2] * p[2] * p[2]) *
-			exp(-(i - p[1]) * (i - p[1]) / (2 * p[2] * p[2]));
-
-		jac[j++] = exp(-(i - p[4]) * (i - p[4]) / (2 * p[5]) * p[5]);
-		jac[j++] = p[3] * (i - p[4]) / (p[5] * p[5]) * exp(-(i - p[4]) * (i - p[4]) / (2 * p[5] * p[5]));
-		jac[j++] = p[3] * (i - p[4]) * (i - p[4]) / (p[5] * p[5] * p[5]) *
-			exp(-(i - p[4]) * (i - p[4]) / (2 * p[5] * p[5]));
+static int findBlockMax(const float blockMax[], const int blockArg[], float &A) {
+	int index = -1;
+	A = 0;
+	for (int k = 0; k < PeelBlockCount; k++) {
+		if (blockMax[k] > A) {
+			A = blockMax[k];
+			index = blockArg[k];
+		}
 	}
+	return index;
 }
 
 
-/*ܣ	˹ģ
-//*p:	
-//*x  ԭʼݣֵ
-//m	ά
-//n	ֵά
-//*data:
+/*ܣ	һ˹
+//ݣ	ֻbPeelSigmaRange*sigmaΧڼ˹ֵΧֵСԺԣ
+//		ĸ˹ֵ֮Գexp(-1/sigma^2)õƴexp
+//		˹ֵȥ˹ֵضΪ0Ϳֵĸָٰ
+//temp	
+//A,b,sigma	˹
 */
-void expfun3(double *p, double *x, int m, int n, void *data) {
-	register int i;
-	for (i = 0; i < n; ++i) {
-		//дx[i]֮Ĺϵʽ﷽̵ұûй۲ֵֻв
-		x[i] = p[0] * exp(-(i - p[1]) * (i - p[1]) / (2 * p[2] * p[2]))
-			+ p[3] * exp(-(i - p[4]) * (i - p[4]) / (2 * p[5] * p[5]))
-			+ p[6] * exp(-(i - p[7]) * (i - p[7]) / (2 * p[8] * p[8]));
+static void peelGaussian(float temp[], float A, int b, float sigma, float blockMax[], int blockArg[]) {
+	//sigmaΪ0ʱֻӰֵ㱾
+	if (!(sigma > 0)) {
+		temp[b] = 0;
+		updateBlockMax(temp, b, b, blockMax, blockArg);
+		return;
 	}
-}
-
 
-/*ܣ	˹ģ͵ſɱȾ
-//*p:	
-//jac ſɱȾ
-//m	ά
-//n	ֵά
-//*data:
-*/
-void jacexpfun3(double *p, double *jac, int m, int n, void *data) {
-	register int i, j;
-	//дſ˱Ⱦ
-	for (i = j = 0; i < n; ++i) {
-		jac[j++] = exp(-(i - p[1]) * (i - p[1]) / (2 * p[2]) * p[2]);
-		jac[j++] = p[0] * (i - p[1]) / (p[2] * p[2]) * exp(-(i - p[1]) * (i - p[1]) / (2 * p[2] * p[2]));
-		jac[j++] = p[0] * (i - p[1]) * (i - p[1]) / (p[2] * p[2] * p[2]) *
-			exp(-(i - p[1]) * (i - p[1]) / (2 * p[2] * p[2]));
-
-		jac[j++] = exp(-(i - p[4]) * (i - p[4]) / (2 * p[5]) * p[5]);
-		jac[j++] = p[3] * (i - p[4]) / (p[5] * p[5]) * exp(-(i - p[4]) * (i - p[4]) / (2 * p[5] * p[5]));
-		jac[j++] = p[3] * (i - p[4]) * (i - p[4]) / (p[5] * p[5] * p[5]) *
-			exp(-(i - p[4]) * (i - p[4]) / (2 * p[5] * p[5]));
-
-		jac[j++] = exp(-(i - p[7]) * (i - p[7]) / (2 * p[8]) * p[8]);
-		jac[j++] = p[6] * (i - p[7]) / (p[8] * p[8]) * exp(-(i - p[7]) * (i - p[7]) / (2 * p[8] * p[8]));
-		jac[j++] = p[6] * (i - p[7]) * (i - p[7]) / (p[8] * p[8] * p[8]) *
-			exp(-(i - p[7]) * (i - p[7]) / (2 * p[8] * p[8]));
+	int first = (int)ceil(b - PeelSigmaRange * sigma);
+	int last = (int)floor(b + PeelSigmaRange * sigma);
+	if (first < 0)
+		first = 0;
+	if (last > 319)
+		last = 319;
+
+	double s2 = 2.0 * sigma * sigma;
+	double x = first - b;
+	double g = A * exp(-x * x / s2);			//ǰĸ˹ֵ
+	double r = exp(-(2 * x + 1) / s2);			//һ뵱ǰĸ˹ֵ֮
+	double q = exp(-2 / s2);					//ڱֵ֮
+
+	//ǰ
+	double gauss[320];
+	for (int m = first; m <= last; m++) {
+		gauss[m - first] = g;
+		g *= r;
+		r *= q;
 	}
+
+	Kernels().peelSubtract(temp + first, gauss, last - first + 1);
+	updateBlockMax(temp, first, last, blockMax, blockArg);
 }
 
 
-/*ܣ	˹ģ
-//*p:	
-//*x  ԭʼݣֵ
-//m	ά
-//n	ֵά
-//*data:
+/*ܣ	ݵı׼
+//*:
+//resultSet
+//stdev	ֵΪ׼
+//*
 */
-void expfun4(double *p, double *x, int m, int n, void *data) {
-	register int i;
-	for (i = 0; i < n; ++i) {
-		//дx[i]֮Ĺϵʽ﷽̵ұûй۲ֵֻв
-		x[i] = p[0] * exp(-(i - p[1]) * (i - p[1]) / (2 * p[2] * p[2]))
-			+ p[3] * exp(-(i - p[4]) * (i - p[4]) / (2 * p[5] * p[5]))
-			+ p[6] * exp(-(i - p[7]) * (i - p[7]) / (2 * p[8] * p[8]))
-			+ p[9] * exp(-(i - p[10]) * (i - p[10]) / (2 * p[11] * p[11]));
-	}
+float calculateSigma(const vector<float> &resultSet) {
+	return calculateSigma(resultSet.data(), (int)resultSet.size());
 }
 
 
-/*ܣ	˹ģ͵ſɱȾ
-//*p:	
-//jac ſɱȾ
-//m	ά
-//n	ֵά
-//*data:
+/*ܣ	һݵı׼ֱԭϼ㣬
+//resultSetʼλ
+//n	ݸ
 */
-void jacexpfun4(double *p, double *jac, int m, int n, void *data) {
-	register int i, j;
-	//дſ˱Ⱦ
-	for (i = j = 0; i < n; ++i) {
-		jac[j++] = exp(-(i - p[1]) * (i - p[1]) / (2 * p[2]) * p[2]);
-		jac[j++] = p[0] * (i - p[1]) / (p[2] * p[2]) * exp(-(i - p[1]) * (i - p[1]) / (2 * p[2] * p[2]));
-		jac[j++] = p[0] * (i - p[1]) * (i - p[1]) / (p[2] * p[2] * p[2]) *
-			exp(-(i - p[1]) * (i - p[1]) / (2 * p[2] * p[2]));
-
-		jac[j++] = exp(-(i - p[4]) * (i - p[4]) / (2 * p[5]) * p[5]);
-		jac[j++] = p[3] * (i - p[4]) / (p[5] * p[5]) * exp(-(i - p[4]) * (i - p[4]) / (2 * p[5] * p[5]));
-		jac[j++] = p[3] * (i - p[4]) * (i - p[4]) / (p[5] * p[5] * p[5]) *
-			exp(-(i - p[4]) * (i - p[4]) / (2 * p[5] * p[5]));
-
-		jac[j++] = exp(-(i - p[7]) * (i - p[7]) / (2 * p[8]) * p[8]);
-		jac[j++] = p[6] * (i - p[7]) / (p[8] * p[8]) * exp(-(i - p[7]) * (i - p[7]) / (2 * p[8] * p[8]));
-		jac[j++] = p[6] * (i - p[7]) * (i - p[7]) / (p[8] * p[8] * p[8]) *
-			exp(-(i - p[7]) * (i - p[7]) / (2 * p[8] * p[8]));
-
-		jac[j++] = exp(-(i - p[10]) * (i - p[10]) / (2 * p[11]) * p[11]);
-		jac[j++] = p[9] * (i - p[10]) / (p[11] * p[11]) * exp(-(i - p[10]) * (i - p[10]) / (2 * p[11] * p[11]));
-		jac[j++] = p[9] * (i - p[10]) * (i - p[10]) / (p[11] * p[11] * p[11]) *
-			exp(-(i - p[10]) * (i - p[10]) / (2 * p[11] * p[11]));
-	}
-}
+float calculateSigma(const float *resultSet, int n) {
+	double sum = std::accumulate(resultSet, resultSet + n, 0.0);
+	double mean = sum / n; //ֵ
 
+	double accum = 0.0;
+	for (const float *iter = resultSet; iter != resultSet + n; iter++) {
+		accum += (*iter - mean) * (*iter - mean);
+	};
 
-/*ܣ	˹ģ
-//*p:	
-//*x  ԭʼݣֵ
-//m	ά
-//n	ֵά
-//*data:
-*/
-void expfun5(double *p, double *x, int m, int n, void *data) {
-	register int i;
-	for (i = 0; i < n; ++i) {
-		//дx[i]֮Ĺϵʽ﷽̵ұûй۲ֵֻв
-		x[i] = p[0] * exp(-(i - p[1]) * (i - p[1]) / (2 * p[2] * p[2]))
-			+ p[3] * exp(-(i - p[4]) * (i - p[4]) / (2 * p[5] * p[5]))
-			+ p[6] * exp(-(i - p[7]) * (i - p[7]) / (2 * p[8] * p[8]))
-			+ p[9] * exp(-(i - p[10]) * (i - p[10]) / (2 * p[11] * p[11]))
-			+ p[12] * exp(-(i - p[13]) * (i - p[13]) / (2 * p[14] * p[14]));
-	}
+	float stdev = (float)sqrt(accum / (n - 1)); //
+
+	return stdev;
 }
 
 
-/*ܣ	˹ģ͵ſɱȾ
-//*p:	
-//jac ſɱȾ
-//m	ά
-//n	ֵά
-//*data:
+/*ܣ	ɸ˹ߣÿֻڶԳPeelSigmaRangesigmaڼ
+//param	
+//count	
+//curve	ߣn
 */
-void jacexpfun5(double *p, double *jac, int m, int n, void *data) {
-	register int i, j;
-	//дſ˱Ⱦ
-	for (i = j = 0; i < n; ++i) {
-		jac[j++] = exp(-(i - p[1]) * (i - p[1]) / (2 * p[2]) * p[2]);
-		jac[j++] = p[0] * (i - p[1]) / (p[2] * p[2]) * exp(-(i - p[1]) * (i - p[1]) / (2 * p[2] * p[2]));
-		jac[j++] = p[0] * (i - p[1]) * (i - p[1]) / (p[2] * p[2] * p[2]) *
-			exp(-(i - p[1]) * (i - p[1]) / (2 * p[2] * p[2]));
-
-		jac[j++] = exp(-(i - p[4]) * (i - p[4]) / (2 * p[5]) * p[5]);
-		jac[j++] = p[3] * (i - p[4]) / (p[5] * p[5]) * exp(-(i - p[4]) * (i - p[4]) / (2 * p[5] * p[5]));
-		jac[j++] = p[3] * (i - p[4]) * (i - p[4]) / (p[5] * p[5] * p[5]) *
-			exp(-(i - p[4]) * (i - p[4]) / (2 * p[5] * p[5]));
-
-		jac[j++] = exp(-(i - p[7]) * (i - p[7]) / (2 * p[8]) * p[8]);
-		jac[j++] = p[6] * (i - p[7]) / (p[8] * p[8]) * exp(-(i - p[7]) * (i - p[7]) / (2 * p[8] * p[8]));
-		jac[j++] = p[6] * (i - p[7]) * (i - p[7]) / (p[8] * p[8] * p[8]) *
-			exp(-(i - p[7]) * (i - p[7]) / (2 * p[8] * p[8]));
-
-		jac[j++] = exp(-(i - p[10]) * (i - p[10]) / (2 * p[11]) * p[11]);
-		jac[j++] = p[9] * (i - p[10]) / (p[11] * p[11]) * exp(-(i - p[10]) * (i - p[10]) / (2 * p[11] * p[11]));
-		jac[j++] = p[9] * (i - p[10]) * (i - p[10]) / (p[11] * p[11] * p[11]) *
-			exp(-(i - p[10]) * (i - p[10]) / (2 * p[11] * p[11]));
-
-		jac[j++] = exp(-(i - p[13]) * (i - p[13]) / (2 * p[14]) * p[14]);
-		jac[j++] = p[12] * (i - p[13]) / (p[14] * p[14]) * exp(-(i - p[13]) * (i - p[13]) / (2 * p[14] * p[14]));
-		jac[j++] = p[12] * (i - p[13]) * (i - p[13]) / (p[14] * p[14] * p[14]) *
-			exp(-(i - p[13]) * (i - p[13]) / (2 * p[14] * p[14]));
+void GaussianCurve(const GaussParameter *param, int count, float *curve, int n) {
+	std::fill(curve, curve + n, 0.0f);
+	for (int k = 0; k < count; k++) {
+		float sigma = fabs(param[k].sigma);
+		if (sigma == 0)
+			continue;
+		int begin = max(0, (int)floor(param[k].b - PeelSigmaRange * sigma));
+		int end = min(n - 1, (int)ceil(param[k].b + PeelSigmaRange * sigma));
+		for (int i = begin; i <= end; i++) {
+			curve[i] += param[k].A * exp(-(i - param[k].b) * (i - param[k].b) / (2 * sigma * sigma));
+		}
 	}
 }
 
 
-/*ܣ	˹ģ
-//*p:	
+
+/*ܣ	m/3˹ģ
+//ݣ	x[i] = sum(A*exp(-(i-b)^2/(2*sigma^2)))CPUֵָ֧ѡʵ
+//*p:	ΪAbsigma
 //*x  ԭʼݣֵ
 //m	ά
 //n	ֵά
 //*data:
 */
-void expfun6(double *p, double *x, int m, int n, void *data) {
-	register int i;
-	for (i = 0; i < n; ++i) {
-		//дx[i]֮Ĺϵʽ﷽̵ұûй۲ֵֻв
-		x[i] = p[0] * exp(-(i - p[1]) * (i - p[1]) / (2 * p[2] * p[2]))
-			+ p[3] * exp(-(i - p[4]) * (i - p[4]) / (2 * p[5] * p[5]))
-			+ p[6] * exp(-(i - p[7]) * (i - p[7]) / (2 * p[8] * p[8]))
-			+ p[9] * exp(-(i - p[10]) * (i - p[10]) / (2 * p[11] * p[11]))
-			+ p[12] * exp(-(i - p[13]) * (i - p[13]) / (2 * p[14] * p[14]))
-			+ p[15] * exp(-(i - p[16]) * (i - p[16]) / (2 * p[17] * p[17]));
-	}
+void expfun(double *p, double *x, int m, int n, void *data) {
+	Kernels().gaussModel(p, m / 3, x, n);
 }
 
 
-/*ܣ	˹ģ͵ſɱȾ
+/*ܣ	m/3˹ģ͵ſɱȾ
 //*p:	
-//jac ſɱȾ
+//jac ſɱȾnm
 //m	ά
 //n	ֵά
 //*data:
 */
-void jacexpfun6(double *p, double *jac, int m, int n, void *data) {
-	register int i, j;
-	//дſ˱Ⱦ
-	for (i = j = 0; i < n; ++i) {
-		jac[j++] = exp(-(i - p[1]) * (i - p[1]) / (2 * p[2]) * p[2]);
-		jac[j++] = p[0] * (i - p[1]) / (p[2] * p[2]) * exp(-(i - p[1]) * (i - p[1]) / (2 * p[2] * p[2]));
-		jac[j++] = p[0] * (i - p[1]) * (i - p[1]) / (p[2] * p[2] * p[2]) *
-			exp(-(i - p[1]) * (i - p[1]) / (2 * p[2] * p[2]));
-
-		jac[j++] = exp(-(i - p[4]) * (i - p[4]) / (2 * p[5]) * p[5]);
-		jac[j++] = p[3] * (i - p[4]) / (p[5] * p[5]) * exp(-(i - p[4]) * (i - p[4]) / (2 * p[5] * p[5]));
-		jac[j++] = p[3] * (i - p[4]) * (i - p[4]) / (p[5] * p[5] * p[5]) *
-			exp(-(i - p[4]) * (i - p[4]) / (2 * p[5] * p[5]));
-
-		jac[j++] = exp(-(i - p[7]) * (i - p[7]) / (2 * p[8]) * p[8]);
-		jac[j++] = p[6] * (i - p[7]) / (p[8] * p[8]) * exp(-(i - p[7]) * (i - p[7]) / (2 * p[8] * p[8]));
-		jac[j++] = p[6] * (i - p[7]) * (i - p[7]) / (p[8] * p[8] * p[8]) *
-			exp(-(i - p[7]) * (i - p[7]) / (2 * p[8] * p[8]));
-
-		jac[j++] = exp(-(i - p[10]) * (i - p[10]) / (2 * p[11]) * p[11]);
-		jac[j++] = p[9] * (i - p[10]) / (p[11] * p[11]) * exp(-(i - p[10]) * (i - p[10]) / (2 * p[11] * p[11]));
-		jac[j++] = p[9] * (i - p[10]) * (i - p[10]) / (p[11] * p[11] * p[11]) *
-			exp(-(i - p[10]) * (i - p[10]) / (2 * p[11] * p[11]));
-
-		jac[j++] = exp(-(i - p[13]) * (i - p[13]) / (2 * p[14]) * p[14]);
-		jac[j++] = p[12] * (i - p[13]) / (p[14] * p[14]) * exp(-(i - p[13]) * (i - p[13]) / (2 * p[14] * p[14]));
-		jac[j++] = p[12] * (i - p[13]) * (i - p[13]) / (p[14] * p[14] * p[14]) *
-			exp(-(i - p[13]) * (i - p[13]) / (2 * p[14] * p[14]));
-
-		jac[j++] = exp(-(i - p[16]) * (i - p[16]) / (2 * p[17]) * p[17]);
-		jac[j++] = p[15] * (i - p[16]) / (p[17] * p[17]) * exp(-(i - p[16]) * (i - p[16]) / (2 * p[17] * p[17]));
-		jac[j++] = p[15] * (i - p[16]) * (i - p[16]) / (p[17] * p[17] * p[17]) *
-			exp(-(i - p[16]) * (i - p[16]) / (2 * p[17] * p[17]));
-	}
+void jacexpfun(double *p, double *jac, int m, int n, void *data) {
+	Kernels().gaussJacobian(p, m / 3, jac, n);
 }
 
 
@@ -356,19 +227,41 @@ void jacexpfun6(double *p, double *jac, int m, int n, void *data) {
 */
 WaveData::WaveData() {
 	m_time = { 0, 0, 0, 0, 0, 0 };
+	m_unixTime = 0;
 	m_BlueNoise = 0;
 	m_GreenNoise = 0;
 	blueDepth = 0;
 	greenDepth = 0;
+	m_LMIterations = 0;
+	InitGPSDayCache(&m_DayCache);
+
+	//һ뵽λ֮֡
+	m_BlueWave.reserve(320);
+	m_GreenWave.reserve(320);
+	m_FilterBuffer.reserve(320);
+	m_LMWork.resize(OptimizeWorkSize);
 }
 
 
 WaveData::~WaveData() {
-	//ֶͷvectorڴ棬֪ûбҪ
-	vector<float>().swap(m_BlueWave);
-	vector<float>().swap(m_GreenWave);
-	vector<GaussParameter>().swap(m_BlueGauPra);
-	vector<GaussParameter>().swap(m_GreenGauPra);
+}
+
+
+/*ܣ	λΪչʱ״̬
+//ݣ	ͬһ֡ʱÿ֡ʼãвڴ
+*/
+void WaveData::Reset() {
+	m_time = { 0, 0, 0, 0, 0, 0 };
+	m_unixTime = 0;
+	m_BlueWave.clear();
+	m_GreenWave.clear();
+	m_BlueNoise = 0;
+	m_GreenNoise = 0;
+	m_BlueGauPra.clear();
+	m_GreenGauPra.clear();
+	blueDepth = 0;
+	greenDepth = 0;
+	m_LMIterations = 0;
 }
 
 
@@ -376,25 +269,22 @@ WaveData::~WaveData() {
 //*&hs:	ԭʼLidar
 */
 void WaveData::GetData(HS_Lidar &hs) {
-	//GPS->UTC->BeiJing
-	PGPSTIME pgt = new GPSTIME;
-	PCOMMONTIME pct = new COMMONTIME;
-	pgt->wn = (int)hs.header.nGPSWeek;
-	pgt->tow.sn = (long)hs.header.dGPSSecond;
-	pgt->tow.tos = 0;
-	GPSTimeToCommonTime(pgt, pct);
-	m_time.year = pct->year;
-	m_time.month = pct->month;
-	m_time.day = pct->day;
-	m_time.hour = pct->hour + TimeDifference;    //ֱתΪʱ
-	m_time.minute = pct->minute;
-	m_time.second = (int)pct->second;
-	delete pgt;
-	delete pct;
+	//GPS->UTC->BeiJingͬһGPSڵֻ֡
+	COMMONTIME ct;
+	GPSTimeToCommonTimeCached((int)hs.header.nGPSWeek, hs.header.dGPSSecond, &m_DayCache, &ct);
+	m_time.year = ct.year;
+	m_time.month = ct.month;
+	m_time.day = ct.day;
+	m_time.hour = ct.hour + TimeDifference;    //ֱתΪʱ
+	m_time.minute = ct.minute;
+	m_time.second = (int)ct.second;
+	GPSTimeToUnixNs(&hs.header.nGPSWeek, &hs.header.dGPSSecond, &m_unixTime, 1);
 
 	//ȡͨ
-	m_BlueWave.assign(&hs.CH2.nD0[0], &hs.CH2.nD0[320]);
-	m_GreenWave.assign(&hs.CH3.nD0[0], &hs.CH3.nD0[320]);
+	m_BlueWave.resize(320);
+	m_GreenWave.resize(320);
+	Kernels().widenU16ToFloat(hs.CH2.nD0, m_BlueWave.data(), 320);
+	Kernels().widenU16ToFloat(hs.CH3.nD0, m_GreenWave.data(), 320);
 }
 
 
@@ -403,6 +293,7 @@ void WaveData::GetData(HS_Lidar &hs) {
 //&noise	¼
 */
 void WaveData::Filter(vector<float> &srcWave, float &noise) {
+	TraceScope trace("Filter");
 	/*
 	//------------------ȡstart---------------------
 	//ЧݵĽȡʵЧáʱûм
@@ -478,7 +369,7 @@ void WaveData::Filter(vector<float> &srcWave, float &noise) {
 	*/
 
 	//˹˲ȥ
-	vector<float> dstWave;
+	vector<float> &dstWave = m_FilterBuffer;    //óԱ
 	dstWave.assign(srcWave.begin(), srcWave.end());
 	gaussian(&srcWave[0], &dstWave[0]);
 
@@ -499,12 +390,13 @@ void WaveData::Filter(vector<float> &srcWave, float &noise) {
 //&noise	¼
 */
 void WaveData::FilterWithRegion(vector<float> &srcWave, float &noise,int *ans) {
+	TraceScope trace("FilterWithRegion");
 
 	//------------------ȡstart---------------------
 	//ЧݵĽȡʵЧáʱûм
+	//α׼ֱsrcWaveϼ㣬ٿӶ
 	int m = 30, n = 30;//Ȥ˵
-	vector<float> vm(srcWave.begin(), srcWave.begin() + m);
-	float Svm = calculateSigma(vm);
+	float Svm = calculateSigma(srcWave.data(), m);
 
 	//ǰȡ
 	for (int i = 30; i < srcWave.size() - 1; i++)
@@ -520,10 +412,8 @@ void WaveData::FilterWithRegion(vector<float> &srcWave, float &noise,int *ans) {
 			}
 			if (n > m)
 			{
-				vector<float> v1(srcWave.begin(), srcWave.begin() + m);
-				vector<float> v2(srcWave.begin(), srcWave.begin() + n);
-				float Sv1 = calculateSigma(v1);
-				float Sv2 = calculateSigma(v2);
+				float Sv1 = calculateSigma(srcWave.data(), m);
+				float Sv2 = calculateSigma(srcWave.data(), n);
 				if (Sv1 > 1.5*Svm || Sv2 > 2 * Sv1)
 					break;
 			}
@@ -531,8 +421,7 @@ void WaveData::FilterWithRegion(vector<float> &srcWave, float &noise,int *ans) {
 		}
 	}
 	int k = 50, l = 50;//Ȥ˵
-	vector<float> vk(srcWave.end() - k, srcWave.end());
-	float Svk = calculateSigma(vk);
+	float Svk = calculateSigma(srcWave.data() + srcWave.size() - k, k);
 
 	//ǰȡ
 	for (int i = 50; i < srcWave.size() - 1; i++)
@@ -548,10 +437,8 @@ void WaveData::FilterWithRegion(vector<float> &srcWave, float &noise,int *ans) {
 			}
 			if (l > k)
 			{
-				vector<float> v1(srcWave.end() - k, srcWave.end());
-				vector<float> v2(srcWave.end() - l, srcWave.end());
-				float Sv1 = calculateSigma(v1);
-				float Sv2 = calculateSigma(v2);
+				float Sv1 = calculateSigma(srcWave.data() + srcWave.size() - k, k);
+				float Sv2 = calculateSigma(srcWave.data() + srcWave.size() - l, l);
 				if (Sv1 > 1.5 * Svk || Sv2 > 2 * Sv1)
 					break;
 			}
@@ -576,7 +463,7 @@ void WaveData::FilterWithRegion(vector<float> &srcWave, float &noise,int *ans) {
 
 
 	//˹˲ȥ
-	vector<float> dstWave;
+	vector<float> &dstWave = m_FilterBuffer;    //óԱ
 	dstWave.assign(srcWave.begin(), srcWave.end());
 	gaussian(&srcWave[0], &dstWave[0]);
 
@@ -596,7 +483,8 @@ void WaveData::FilterWithRegion(vector<float> &srcWave, float &noise,int *ans) {
 //&srcWave:		ͨԭʼ
 //&waveParam	ͨĸ˹
 */
-void WaveData::Resolve(vector<float> &srcWave, vector <GaussParameter> &waveParam, float &noise) {
+void WaveData::Resolve(vector<float> &srcWave, GaussList &waveParam, float &noise) {
+	TraceScope trace("Resolve");
 	//ԭʼ
 	float data[320], temp[320];
 	int i = 0, m = 0;
@@ -627,16 +515,21 @@ void WaveData::Resolve(vector<float> &srcWave, vector <GaussParameter> &wavePara
 	bool wavetypeFlag = true;            //жˮˮ׻زflag
 	float surfaceMin, surfaceMax;    //ˮزλڵĿƷΧ
 
+	//ֵֻӰĿ
+	float blockMax[PeelBlockCount];
+	int blockArg[PeelBlockCount];
+	for (m = 0; m < PeelBlockCount; m++) {
+		updateBlockMax(temp, m * PeelBlockSize, (m + 1) * PeelBlockSize - 1, blockMax, blockArg);
+	}
+
 	//ѭ
 	do {
-		A = 0;
 		//ֵ¼λ
-		for (m = 0; m < 320; m++) {
-			if (temp[m] > A) {
-				A = temp[m];
-				b = (float)m;
-			}
+		int maxIndex = findBlockMax(blockMax, blockArg, A);
+		if (maxIndex < 0) {
+			return;		//ȫ루ֵbδֵʱҰλ
 		}
+		b = (float)maxIndex;
 
 		//ѰҰλ
 		for (m = (int)b; m < 319; m++) {
@@ -717,22 +610,11 @@ void WaveData::Resolve(vector<float> &srcWave, vector <GaussParameter> &wavePara
 			waveParam.push_back(param);
 		}
 
-		//
-		for (m = 0; m < 320; m++) {
-			if (temp[m] > A * exp(-(m - b) * (m - b) / (2 * sigma * sigma))) {
-				temp[m] -= A * exp(-(m - b) * (m - b) / (2 * sigma * sigma));
-			}
-			else
-				temp[m] = 0;
-		}
+		//룬Ӱֵ
+		peelGaussian(temp, A, (int)b, sigma, blockMax, blockArg);
 
 		//жǷ
-		A = 0;
-		for (m = 0; m < 320; m++) {
-			if (temp[m] > A) {
-				A = temp[m];
-			}
-		}
+		findBlockMax(blockMax, blockArg, A);
 
 
 	} while (A > 3 * noise);//ѭ!!!ֵ̽
@@ -742,27 +624,26 @@ void WaveData::Resolve(vector<float> &srcWave, vector <GaussParameter> &wavePara
 	//Ը˹ɸѡʱСһֵ޳СķvectorsigmaֵΪ0
 	for (int i = 0; i < waveParam.size() - 1; i++) {
 		for (int j = i + 1; j < waveParam.size(); j++) {
-			if (abs(waveParam.at(i).b - waveParam.at(j).b) < PulseWidth)//Key
+			if (abs(waveParam[i].b - waveParam[j].b) < PulseWidth)//Key
 			{
-				if (waveParam.at(i).A >= waveParam.at(j).A) {
-					waveParam.at(j).sigma = 0;
+				if (waveParam[i].A >= waveParam[j].A) {
+					waveParam[j].sigma = 0;
 				}
 				else {
-					waveParam.at(i).sigma = 0;
+					waveParam[i].sigma = 0;
 				}
 			}
 		}
 	}
 
-	//ٽsigmaСֵķ޳
-	for (gaussPraIter = waveParam.begin(); gaussPraIter != waveParam.end();) {
-		if (gaussPraIter->sigma < ((float)PulseWidth / 8)) {
-			gaussPraIter = waveParam.erase(gaussPraIter);
-		}
-		else {
-			++gaussPraIter;
+	//ٽsigmaСֵķ޳ԭذ˳ǰƱķ
+	size_t count = 0;
+	for (size_t i = 0; i < waveParam.size(); i++) {
+		if (!(waveParam[i].sigma < ((float)PulseWidth / 8))) {
+			waveParam[count++] = waveParam[i];
 		}
 	}
+	waveParam.resize(count);
 }
 
 
@@ -771,7 +652,11 @@ void WaveData::Resolve(vector<float> &srcWave, vector <GaussParameter> &wavePara
 //&waveParam	ͨĸ˹
 //LM㷨ο	https://blog.csdn.net/shajun0153/article/details/75073137
 */
-void WaveData::Optimize(vector<float> &srcWave, vector <GaussParameter> &waveParam) {
+void WaveData::Optimize(vector<float> &srcWave, GaussList &waveParam) {
+	TraceScope trace("Optimize");
+	static thread_local SolverMemory solverMemory;	//̵߳һεǰ죬߳̽ʱͷڴ
+	(void)solverMemory;
+	GaussList::iterator gaussPraIter;
 	int size = (int)waveParam.size();
 	//ֵΪ˫
 	switch (size) {
@@ -796,8 +681,8 @@ void WaveData::Optimize(vector<float> &srcWave, vector <GaussParameter> &wavePar
 
 		double info[LM_INFO_SZ];
 		// õں
-		int ret = dlevmar_der(expfun2,    //ֵ֮ϵĺָ
-			jacexpfun2,                    //ſ˱Ⱦĺָ
+		int ret = dlevmar_der(expfun,       //ֵ֮ϵĺָ
+			jacexpfun,                     //ſ˱Ⱦĺָ
 			p,                            //ʼĴһ
 			x,                            //ֵ
 			m,                            //ά
@@ -805,8 +690,10 @@ void WaveData::Optimize(vector<float> &srcWave, vector <GaussParameter> &wavePar
 			1000,                        //
 			NULL,                        //opts,       //һЩ
 			info,                        //СһЩҪΪNULL
-			NULL, NULL, NULL            //һЩڴָ룬ʱҪ
+			m_LMWork.data(), NULL, NULL    //ʹԤڴ棬Э͸ݲҪ
 		);
+		if (ret > 0)
+			m_LMIterations += ret;			//ֵΪʧʱΪ-1
 		/*printf("Levenberg-Marquardt returned in %g iter, reason %g, sumsq %g [%g]\n", info[5], info[6], info[1], info[0]);
 		printf("Bestfit parameters: A:%.7g b:%.7g sigma:%.7g A:%.7g b:%.7g sigma:%.7g\n", p[0], p[1], p[2], p[3], p[4], p[5]);
 		printf("ʱ: %.7g ns\n", abs(p[4] - p[1]));*/
@@ -842,8 +729,8 @@ void WaveData::Optimize(vector<float> &srcWave, vector <GaussParameter> &wavePar
 
 		double info[LM_INFO_SZ];
 		// õں
-		int ret = dlevmar_der(expfun3,    //ֵ֮ϵĺָ
-			jacexpfun3,                    //ſ˱Ⱦĺָ
+		int ret = dlevmar_der(expfun,       //ֵ֮ϵĺָ
+			jacexpfun,                     //ſ˱Ⱦĺָ
 			p,                            //ʼĴһ
 			x,                            //ֵ
 			m,                            //ά
@@ -851,8 +738,10 @@ void WaveData::Optimize(vector<float> &srcWave, vector <GaussParameter> &wavePar
 			1000,                        //
 			NULL,                        //opts,       //һЩ
 			info,                        //СһЩҪΪNULL
-			NULL, NULL, NULL            //һЩڴָ룬ʱҪ
+			m_LMWork.data(), NULL, NULL    //ʹԤڴ棬Э͸ݲҪ
 		);
+		if (ret > 0)
+			m_LMIterations += ret;
 		/*printf("Levenberg-Marquardt returned in %g iter, reason %g, sumsq %g [%g]\n", info[5], info[6], info[1], info[0]);
 		printf("Bestfit parameters: A:%.7g b:%.7g sigma:%.7g A:%.7g b:%.7g sigma:%.7g\n", p[0], p[1], p[2], p[3], p[4], p[5]);
 		printf("ʱ: %.7g ns\n", abs(p[4] - p[1]));*/
@@ -888,8 +777,8 @@ void WaveData::Optimize(vector<float> &srcWave, vector <GaussParameter> &wavePar
 
 		double info[LM_INFO_SZ];
 		// õں
-		int ret = dlevmar_der(expfun4,    //ֵ֮ϵĺָ
-			jacexpfun4,                    //ſ˱Ⱦĺָ
+		int ret = dlevmar_der(expfun,       //ֵ֮ϵĺָ
+			jacexpfun,                     //ſ˱Ⱦĺָ
 			p,                            //ʼĴһ
 			x,                            //ֵ
 			m,                            //ά
@@ -897,8 +786,10 @@ void WaveData::Optimize(vector<float> &srcWave, vector <GaussParameter> &wavePar
 			1000,                        //
 			NULL,                        //opts,       //һЩ
 			info,                        //СһЩҪΪNULL
-			NULL, NULL, NULL            //һЩڴָ룬ʱҪ
+			m_LMWork.data(), NULL, NULL    //ʹԤڴ棬Э͸ݲҪ
 		);
+		if (ret > 0)
+			m_LMIterations += ret;
 		/*printf("Levenberg-Marquardt returned in %g iter, reason %g, sumsq %g [%g]\n", info[5], info[6], info[1], info[0]);
 		printf("Bestfit parameters: A:%.7g b:%.7g sigma:%.7g A:%.7g b:%.7g sigma:%.7g\n", p[0], p[1], p[2], p[3], p[4], p[5]);
 		printf("ʱ: %.7g ns\n", abs(p[4] - p[1]));*/
@@ -934,8 +825,8 @@ void WaveData::Optimize(vector<float> &srcWave, vector <GaussParameter> &wavePar
 
 		double info[LM_INFO_SZ];
 		// õں
-		int ret = dlevmar_der(expfun5,    //ֵ֮ϵĺָ
-			jacexpfun5,                    //ſ˱Ⱦĺָ
+		int ret = dlevmar_der(expfun,       //ֵ֮ϵĺָ
+			jacexpfun,                     //ſ˱Ⱦĺָ
 			p,                            //ʼĴһ
 			x,                            //ֵ
 			m,                            //ά
@@ -943,8 +834,10 @@ void WaveData::Optimize(vector<float> &srcWave, vector <GaussParameter> &wavePar
 			1000,                        //
 			NULL,                        //opts,       //һЩ
 			info,                        //СһЩҪΪNULL
-			NULL, NULL, NULL            //һЩڴָ룬ʱҪ
+			m_LMWork.data(), NULL, NULL    //ʹԤڴ棬Э͸ݲҪ
 		);
+		if (ret > 0)
+			m_LMIterations += ret;
 		/*printf("Levenberg-Marquardt returned in %g iter, reason %g, sumsq %g [%g]\n", info[5], info[6], info[1], info[0]);
 		printf("Bestfit parameters: A:%.7g b:%.7g sigma:%.7g A:%.7g b:%.7g sigma:%.7g\n", p[0], p[1], p[2], p[3], p[4], p[5]);
 		printf("ʱ: %.7g ns\n", abs(p[4] - p[1]));*/
@@ -980,8 +873,8 @@ void WaveData::Optimize(vector<float> &srcWave, vector <GaussParameter> &wavePar
 
 		double info[LM_INFO_SZ];
 		// õں
-		int ret = dlevmar_der(expfun6,    //ֵ֮ϵĺָ
-			jacexpfun6,                    //ſ˱Ⱦĺָ
+		int ret = dlevmar_der(expfun,       //ֵ֮ϵĺָ
+			jacexpfun,                     //ſ˱Ⱦĺָ
 			p,                            //ʼĴһ
 			x,                            //ֵ
 			m,                            //ά
@@ -989,8 +882,10 @@ void WaveData::Optimize(vector<float> &srcWave, vector <GaussParameter> &wavePar
 			1000,                        //
 			NULL,                        //opts,       //һЩ
 			info,                        //СһЩҪΪNULL
-			NULL, NULL, NULL            //һЩڴָ룬ʱҪ
+			m_LMWork.data(), NULL, NULL    //ʹԤڴ棬Э͸ݲҪ
 		);
+		if (ret > 0)
+			m_LMIterations += ret;
 		/*printf("Levenberg-Marquardt returned in %g iter, reason %g, sumsq %g [%g]\n", info[5], info[6], info[1], info[0]);
 		printf("Bestfit parameters: A:%.7g b:%.7g sigma:%.7g A:%.7g b:%.7g sigma:%.7g\n", p[0], p[1], p[2], p[3], p[4], p[5]);
 		printf("ʱ: %.7g ns\n", abs(p[4] - p[1]));*/
@@ -1016,7 +911,8 @@ void WaveData::Optimize(vector<float> &srcWave, vector <GaussParameter> &wavePar
 /*ܣ	ˮ
 //ݣ	ȡĿСֱ޳ȡһֵΪˮزʱΪˮ׻زˮ
 */
-void WaveData::CalcuDepth(vector <GaussParameter> &waveParam, float &BorGDepth) {
+void WaveData::CalcuDepth(GaussList &waveParam, float &BorGDepth) {
+	GaussList::iterator gaussPraIter;
 	if (waveParam.size() <= 1) {
 		BorGDepth = 0;
 	}
@@ -1125,7 +1021,8 @@ ostream &operator<<(ostream &stream, const WaveData &wavedata) {
 /*ܣ	ͨ˹ֽˮ
 //ݣ	ȡֱֵӼ
 */
-void WaveData::CalcuDepthByGauss(vector<GaussParameter> &waveParam, float &BorGDepth) {
+void WaveData::CalcuDepthByGauss(GaussList &waveParam, float &BorGDepth) {
+	GaussList::iterator gaussPraIter;
 	if ((waveParam.size() > 1) && (waveParam.size() < 7)) {
 		gaussPraIter = waveParam.begin();
 		float tbegin = gaussPraIter->b;
@@ -5,6 +5,7 @@
 #include "HS_Lidar.h"
 #include "TimeConvert.h"
 #include "levmar.h"
+#include "SmallVector.h"
 using namespace std;
 
 
@@ -18,8 +19,21 @@ struct GaussParameter
 };
 
 
+#define GaussInlineCount 32	//˹б洢ڴ
+
+//˹б
+typedef SmallVector<GaussParameter, GaussInlineCount> GaussList;
+
+
 //ݵı׼
-float calculateSigma(vector<float> resultSet);
+float calculateSigma(const vector<float> &resultSet);
+float calculateSigma(const float *resultSet, int n);
+
+//320ǳˮε5˹ƽ˸2㲻
+void gaussian(float src[], float dst[]);
+
+//˹0..n-1ϵӵߣȡcount=1
+void GaussianCurve(const GaussParameter *param, int count, float *curve, int n);
 
 
 //
@@ -28,26 +42,33 @@ class WaveData
 public:
 	WaveData();
 	~WaveData();
+	void Reset();															//λݹ֡
 	void GetData(HS_Lidar &hs);												//ȡȤ
 	void Filter(vector<float> &srcWave,float &noise);						//˲ƽ
 	void FilterWithRegion(vector<float> &srcWave, float &noise,int* ans);//˲ƽ+ȡΧ
-	void Resolve(vector<float> &srcWave,vector<GaussParameter> &waveParam,float &noise);	//ֽ˹
-	void Optimize(vector<float> &srcWave,vector<GaussParameter> &waveParam);//ŻLM
+	void Resolve(vector<float> &srcWave,GaussList &waveParam,float &noise);	//ֽ˹
+	void Optimize(vector<float> &srcWave,GaussList &waveParam);//ŻLM
 
-	static bool ostreamFlag;												//Ȥͨ
+	static thread_local bool ostreamFlag;									//Ȥͨݣ̷ֱ߳ã
 	friend ostream &operator<<(ostream &stream, const WaveData &wavedata);	//ԶϢ
 
 	Time m_time;									//UTCʱ
+	int64_t m_unixTime;								//UTCʱ䣨UnixԪ
 	vector<float> m_BlueWave;						//CH2ͨ
 	vector<float> m_GreenWave;						//CH3ͨ
 	float m_BlueNoise;								//CH2ͨ
 	float m_GreenNoise;								//CH3ͨ
-	vector<GaussParameter> m_BlueGauPra;			//CH2ݸ˹
-	vector<GaussParameter> m_GreenGauPra;			//CH3ݸ˹
-	vector<GaussParameter>::iterator gaussPraIter;	//˹ṹ
+	GaussList m_BlueGauPra;							//CH2ݸ˹
+	GaussList m_GreenGauPra;						//CH3ݸ˹
 
 	float blueDepth;								//CH2ͨļˮ
 	float greenDepth;								//CH3ͨļˮ
-	void CalcuDepth(vector<GaussParameter> &waveParam,float &BorGDepth);	//ݻزݼˮ
-	void CalcuDepthByGauss(vector<GaussParameter> &waveParam, float &BorGDepth);    //ͨ˹ֽ
+	int m_LMIterations;								//֡LMϼ
+	void CalcuDepth(GaussList &waveParam,float &BorGDepth);	//ݻزݼˮ
+	void CalcuDepthByGauss(GaussList &waveParam, float &BorGDepth);    //ͨ˹ֽ
+
+private:
+	vector<float> m_FilterBuffer;					//˲
+	vector<double> m_LMWork;						//LM
+	GPSDAYCACHE m_DayCache;							//GPSջ棨Resetʱ
 };
\ No newline at end of file
@@ -0,0 +1,121 @@
+/*************************************************
+Description:̳߳
+                ֡Ĳηֽ⡢LMȼҸ֡
+                ȡ̰߳һ̳֡߳زдٰ֡˳д
+**************************************************/
+#include "WorkerPool.h"
+#include "Trace.h"
+#include <algorithm>
+
+
+WorkerPool::WorkerPool(int threads)
+{
+	m_stop = false;
+	if (threads <= 0)
+		threads = (int)thread::hardware_concurrency();
+	for (int i = 1; i < threads; i++)
+		m_workers.push_back(thread(&WorkerPool::workerMain, this));
+}
+
+
+WorkerPool::~WorkerPool()
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (size_t i = 0; i < m_workers.size(); i++)
+		m_workers[i].join();
+}
+
+
+/*************************************************
+Function:       ύ
+Description:	β߳ȡͬһjobwaitǰٴύ
+Input:          job: count: task:һ񣨲Ϊ±꣩
+Output:
+*************************************************/
+void WorkerPool::start(PoolJob &job, int count, const function<void(int)> &task)
+{
+	job.m_task = task;
+	job.m_count = count;
+	job.m_next.store(0);
+	job.m_finished = 0;
+	if (count <= 0)
+		return;
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_jobs.push_back(&job);
+	}
+	m_wake.notify_all();
+}
+
+
+void WorkerPool::finishOne(PoolJob &job)
+{
+	lock_guard<mutex> lock(m_mutex);
+	if (++job.m_finished == job.m_count)
+		m_done.notify_all();
+}
+
+
+/*************************************************
+Function:       ȴ
+Description:	߳ȡʣȴ̴߳е
+Input:          job:ύ
+Output:
+*************************************************/
+void WorkerPool::wait(PoolJob &job)
+{
+	for (;;)
+	{
+		int index = job.m_next.fetch_add(1);
+		if (index >= job.m_count)
+			break;
+		job.m_task(index);
+		finishOne(job);
+	}
+
+	unique_lock<mutex> lock(m_mutex);
+	m_done.wait(lock, [&] { return job.m_finished >= job.m_count; });
+	deque<PoolJob *>::iterator it = find(m_jobs.begin(), m_jobs.end(), &job);
+	if (it != m_jobs.end())
+		m_jobs.erase(it);
+}
+
+
+void WorkerPool::run(int count, const function<void(int)> &task)
+{
+	PoolJob job;
+	start(job, count, task);
+	wait(job);
+}
+
+
+void WorkerPool::workerMain()
+{
+	TraceThreadName("worker");
+	unique_lock<mutex> lock(m_mutex);
+	for (;;)
+	{
+		m_wake.wait(lock, [&] { return m_stop || !m_jobs.empty(); });
+		if (m_jobs.empty())
+			return;
+
+		PoolJob *job = m_jobs.front();
+		int index = job->m_next.fetch_add(1);
+		if (index >= job->m_count)
+		{
+			//꣬ƳУеȡ߳ɣ
+			m_jobs.pop_front();
+			continue;
+		}
+
+		lock.unlock();
+		job->m_task(index);
+		lock.lock();
+		if (++job->m_finished == job->m_count)
+			m_done.notify_all();
+	}
+}
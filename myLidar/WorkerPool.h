@@ -0,0 +1,50 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <deque>
+#include <functional>
+using namespace std;
+
+
+//һβcount±0..count-1̳߳ظ̶̬߳ȡɵ̼߳ȡԶ
+class PoolJob
+{
+public:
+	PoolJob() : m_count(0), m_next(0), m_finished(0) {}
+
+private:
+	friend class WorkerPool;
+	function<void(int)> m_task;
+	int m_count;
+	atomic<int> m_next;				//һδȡ
+	int m_finished;					//ɵ̳߳صڸ£
+};
+
+
+//̶СĹ̳߳أĸļ̹á
+//ύ߳̿Լ£ȡһݣwaitʱ߳Ҳȡ
+class WorkerPool
+{
+public:
+	explicit WorkerPool(int threads);	//threadsΪ̣߳߳0Ϊ
+	~WorkerPool();
+
+	int threads() const { return (int)m_workers.size() + 1; }
+	void start(PoolJob &job, int count, const function<void(int)> &task);	//ύ
+	void wait(PoolJob &job);			//봦ֱȫɣ֮jobٴύ
+	void run(int count, const function<void(int)> &task);		//ύȴ
+
+private:
+	void workerMain();
+	void finishOne(PoolJob &job);
+
+	vector<thread> m_workers;
+	mutex m_mutex;
+	condition_variable m_wake;			//˳
+	condition_variable m_done;			//ȫ
+	deque<PoolJob *> m_jobs;			//δȡ
+	bool m_stop;
+};
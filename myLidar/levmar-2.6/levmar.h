@@ -39,6 +39,8 @@
  * Bellow, an attempt is made to issue a warning if this option is turned on and OpenMP
  * is being used (note that this will work only if omp.h is included before levmar.h)
  */
+/* myLidar: frames are fitted on a worker pool; the retained memory is kept per thread
+ * (see __STATIC__ in Axb_core.c), so the solvers stay reentrant */
 #define LINSOLVERS_RETAIN_MEMORY
 #if (defined(_OPENMP))
 # ifdef LINSOLVERS_RETAIN_MEMORY
@@ -32,6 +32,10 @@
 #include "compiler.h"
 #include "misc.h"
 
+/* myLidar: keep the thread's retained solver memory across minimizations instead of
+ * releasing it at the end of each call; WaveData releases it when the thread exits */
+#undef LINSOLVERS_RETAIN_MEMORY
+
 #define EPSILON       1E-12
 #define ONE_THIRD     0.3333333334 /* 1.0/3.0 */
 
@@ -3,19 +3,84 @@
 #include "stdafx.h"
 #include "stdio.h"
 #include "ReadFile.h"
+#include "BatchRun.h"
+#include "WorkerPool.h"
+#include "Trace.h"
+#include "BufferedFile.h"
+#include "SimdKernels.h"
+#include <memory>
 using namespace std;
 
+#define MaxPathLength 4096		//˵ļ·
+
 float angle = 0;
 
-int main()
+int main(int argc, char *argv[])
 {
+	BatchOptions options;
+	//ûMYLIDAR_TRACEΪ·ʱ¼ʱߣ˳ʱдChrome trace JSON
+	const char *tracePath = getenv("MYLIDAR_TRACE");
+	if (tracePath != NULL)
+	{
+		options.tracePath = tracePath;
+	}
+	//ûMYLIDAR_COUNTERSʱͳƸӸ׶εӲ
+	options.stats.counters = getenv("MYLIDAR_COUNTERS") != NULL;
+	//ûMYLIDAR_ISAscalarsse4.2avx2avx512ʱָȵָĬϰCPUԶѡ
+	const char *isaName = getenv("MYLIDAR_ISA");
+	if (isaName != NULL)
+	{
+		options.isa = isaName;
+	}
+
+	//вʱΪѡڻΪ˵֡
+	if (argc > 1)
+	{
+		if (!ParseBatchArgs(argc, argv, options))
+			return 2;
+	}
+	else
+	{
+		options.threads = 1;
+	}
+
+	if (!options.tracePath.empty())
+	{
+		TraceStart(options.tracePath.c_str());
+	}
+	if (!options.isa.empty())
+	{
+		CpuIsa isa;
+		if (CpuIsaFromName(options.isa.c_str(), isa))
+			SetKernelIsa(isa);
+		else
+			printf("Unknown ISA %s, using %s.\n", options.isa.c_str(), CpuIsaName(Kernels().isa));
+	}
+
+	if (argc > 1 && !options.interactive)
+	{
+		return RunBatch(options) == 0 ? 0 : 1;
+	}
+
+	//˵--interactiveʱʹе߳ʽдļѡ
+	unique_ptr<WorkerPool> pool;
+	if (options.threads != 1)
+	{
+		pool.reset(new WorkerPool(options.threads));
+	}
+
 	int flag = 1;
 	while (flag)
 	{
 		printf("Enter the absolute path to the file to be processed:\n");
-		char name[100];
-		scanf("%s", name);
+		char name[MaxPathLength];
+		if (scanf("%4095s", name) != 1)
+			break;				//
 		ReadFile myfile;
+		myfile.setStatsOptions(options.stats);
+		myfile.setOutputFormat(options.format);
+		myfile.setWriteOptions(options.write);
+		myfile.setWorkerPool(pool.get(), options.batchSize);
 		bool ret = myfile.setFilename(name);
 		if (ret)
 		{
@@ -31,6 +96,7 @@ int main()
 			printf("7:ReadDeepOutLas.\n");
 			printf("===================================\n\n");
 			scanf("%d", &flag);
+			ResetWriterStats();
 			switch (flag)
 			{
 			case 0: {
@@ -83,6 +149,8 @@ int main()
 				break;
 			}
 			}
+			if (options.write.background)
+				PrintWriterStats();
 		}
 		else
 			continue;
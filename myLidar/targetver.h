@@ -5,4 +5,6 @@
 // ҪΪǰ Windows ƽ̨Ӧó WinSDKVer.h
 //  _WIN32_WINNT ΪҪֵ֧ƽ̨Ȼٰ SDKDDKVer.h
 
+#ifdef _WIN32
 #include <SDKDDKVer.h>
+#endif
@@ -0,0 +1,559 @@
+/*************************************************
+Description:δ׶ε΢׼
+                Ժϳɲκͺϳԭʼ֡Ϊ룬׶βÿ㣨ÿΣĺʱ
+                ns/shotshots/sΪJSONͬ汾Ƚ
+**************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include "../myLidar/WaveData.h"
+#include "../myLidar/DeepWave.h"
+#include "../myLidar/HS_Lidar.h"
+#include "../myLidar/TimeConvert.h"
+#include "../myLidar/SyntheticData.h"
+#include "../myLidar/SimdKernels.h"
+using namespace std;
+
+float angle = 0;							//WaveData/DeepWaveˮõ
+
+#define BenchPoolSize 64					//ÿѭʹõĺϳ
+#define BenchShallowLength 320				//ǳˮγ
+#define BenchDeepLength 1006				//ʵˮλز
+#define BenchDefaultMinTime 0.5				//ÿԵĬʱ䣨s
+#define BenchDefaultRepetitions 5			//ÿԵĬظ
+
+
+//ѡ
+struct BenchOptions
+{
+	const char *filter;			//ֻưַĲ
+	double minTime;				//ÿԵʱ䣨s
+	int repetitions;			//ظȡֵ
+	const char *jsonPath;		//JSON·NULLʱ
+
+	BenchOptions() : filter(NULL), minTime(BenchDefaultMinTime), repetitions(BenchDefaultRepetitions), jsonPath(NULL) {}
+};
+
+
+//Խ
+struct BenchResult
+{
+	string name;
+	uint64_t shots;				//ʱļ
+	double nsPerShot;			//ظֵ
+	double nsPerShotMin;		//ظСֵ
+	double shotsPerSecond;
+};
+
+
+static volatile double g_sink;			//ۼӸ׶εⱻŻ
+static vector<BenchResult> g_results;
+
+
+/*************************************************
+Function:       һ
+Description:    ȱֱһʱ1msȷٰʱظʱ
+                ÿظns/shotȡֵfn(i)i
+Input:          name: options:ѡ fn:㴦
+Output:         g_resultsӡ
+*************************************************/
+template <class Fn>
+static void runBench(const char *name, const BenchOptions &options, Fn fn)
+{
+	typedef chrono::steady_clock Clock;
+	if (options.filter != NULL && strstr(name, options.filter) == NULL)
+	{
+		return;
+	}
+
+	//ԤȲȷ
+	uint64_t batch = 1;
+	uint64_t next = 0;
+	for (;;)
+	{
+		Clock::time_point start = Clock::now();
+		for (uint64_t i = 0; i < batch; i++)
+		{
+			fn(next++);
+		}
+		double seconds = chrono::duration<double>(Clock::now() - start).count();
+		if (seconds >= 1e-3)
+		{
+			double perRep = options.minTime / options.repetitions;
+			batch = max((uint64_t)1, (uint64_t)(batch * perRep / seconds));
+			break;
+		}
+		batch *= 2;
+	}
+
+	vector<double> nsPerShot;
+	uint64_t shots = 0;
+	for (int r = 0; r < options.repetitions; r++)
+	{
+		Clock::time_point start = Clock::now();
+		for (uint64_t i = 0; i < batch; i++)
+		{
+			fn(next++);
+		}
+		double ns = chrono::duration<double, nano>(Clock::now() - start).count();
+		nsPerShot.push_back(ns / batch);
+		shots += batch;
+	}
+
+	sort(nsPerShot.begin(), nsPerShot.end());
+	BenchResult result;
+	result.name = name;
+	result.shots = shots;
+	result.nsPerShot = nsPerShot[nsPerShot.size() / 2];
+	result.nsPerShotMin = nsPerShot[0];
+	result.shotsPerSecond = 1e9 / result.nsPerShot;
+	g_results.push_back(result);
+	printf("%-28s %12.1f %12.1f %14.0f %12llu\n", name, result.nsPerShot, result.nsPerShotMin,
+		result.shotsPerSecond, (unsigned long long)shots);
+	fflush(stdout);
+}
+
+
+/*************************************************
+Function:       ϳɻز
+Description:    ϵɸ˹ټӸ˹ȡֵ
+Input:          rng: n: params:˹ baseline: noise:׼
+Output:         
+*************************************************/
+static vector<float> makeWave(mt19937 &rng, int n, const vector<GaussParameter> &params, float baseline, float noise)
+{
+	normal_distribution<float> gauss(0, noise);
+	vector<float> wave(n, baseline);
+	for (size_t k = 0; k < params.size(); k++)
+	{
+		const GaussParameter &p = params[k];
+		for (int i = 0; i < n; i++)
+		{
+			float t = (i - p.b) / p.sigma;
+			wave[i] += p.A * exp(-t * t / 2);
+		}
+	}
+	for (int i = 0; i < n; i++)
+	{
+		wave[i] = max(0.0f, floor(wave[i] + gauss(rng) + 0.5f));
+	}
+	return wave;
+}
+
+
+//ǳˮΣˮزһˮ׻ز
+static vector<float> makeShallowWave(mt19937 &rng)
+{
+	uniform_real_distribution<float> u(0, 1);
+	float surface = 60 + 20 * u(rng);
+	vector<GaussParameter> params;
+	params.push_back({ 600 + 300 * u(rng), surface, 3 + u(rng), true });
+	params.push_back({ 100 + 200 * u(rng), surface + 30 + 120 * u(rng), 4 + 2 * u(rng), false });
+	return makeWave(rng, BenchShallowLength, params, 200, 3);
+}
+
+
+//ˮλزˮزˮɢˮ׻زΪn
+static vector<float> makeDeepWave(mt19937 &rng, int n)
+{
+	uniform_real_distribution<float> u(0, 1);
+	float surface = 0.1f * n * (1 + u(rng));
+	vector<GaussParameter> params;
+	params.push_back({ 500 + 300 * u(rng), surface, 3 + u(rng), true });
+	params.push_back({ 60, surface + 12, 10, true });
+	params.push_back({ 40 + 80 * u(rng), surface + (n - surface) * (0.3f + 0.4f * u(rng)), 5 + 3 * u(rng), false });
+	return makeWave(rng, n, params, 150, 2);
+}
+
+
+//countӵȥκŶĳֵOptimize룩
+static void makeOptimizeCase(mt19937 &rng, int count, vector<float> &wave, GaussList &initial)
+{
+	uniform_real_distribution<float> u(0, 1);
+	vector<GaussParameter> params;
+	float spacing = 240.0f / count;
+	for (int k = 0; k < count; k++)
+	{
+		params.push_back({ 100 + 500 * u(rng), 40 + spacing * (k + 0.5f), 3 + 3 * u(rng), k == 0 });
+	}
+	wave = makeWave(rng, BenchShallowLength, params, 0, 2);
+
+	initial.clear();
+	for (int k = 0; k < count; k++)
+	{
+		GaussParameter p = params[k];
+		p.A *= 0.9f + 0.2f * u(rng);
+		p.b += 3 * (u(rng) - 0.5f);
+		p.sigma *= 0.85f + 0.3f * u(rng);
+		initial.push_back(p);
+	}
+}
+
+
+/*************************************************
+Function:       ϳԭʼļ
+Description:    дBenchPoolSize֡ĩβʹһ֡CH4֮ĶȡԽļβ
+                ʵһCH4һ֡ͬͷʱᱻλز룩
+Input:          deepLength:λزȣ0Ϊǳˮ֡
+Output:         offsets:֡ʼλãʱļ
+*************************************************/
+static FILE *makeFrameFile(int deepLength, vector<long> &offsets)
+{
+	SynthOptions synthOptions;
+	synthOptions.seed = deepLength + 1;
+	synthOptions.deep = deepLength > 0;
+	synthOptions.deepLength = deepLength;
+	HsSynthesizer synth(synthOptions);
+
+	vector<uint8_t> data;
+	SynthTruth truth;
+	offsets.clear();
+	for (int k = 0; k < BenchPoolSize; k++)
+	{
+		offsets.push_back((long)data.size());
+		synth.frame(k, data, truth);
+	}
+	data.resize(data.size() + 65536, 0);
+
+	FILE *fp = tmpfile();
+	if (fp == NULL)
+	{
+		return NULL;
+	}
+	fwrite(data.data(), 1, data.size(), fp);
+	fflush(fp);
+	return fp;
+}
+
+
+static void benchShallow(const BenchOptions &options)
+{
+	mt19937 rng(1);
+	vector<vector<float>> raw, filtered;
+	for (int k = 0; k < BenchPoolSize; k++)
+	{
+		raw.push_back(makeShallowWave(rng));
+	}
+
+	WaveData wd;
+	vector<float> wave;
+	wave.reserve(BenchShallowLength);
+	float noise;
+
+	//˲ĲκΪResolve
+	vector<float> noises;
+	for (int k = 0; k < BenchPoolSize; k++)
+	{
+		wave = raw[k];
+		wd.Filter(wave, noise);
+		filtered.push_back(wave);
+		noises.push_back(noise);
+	}
+
+	vector<float> dst(BenchShallowLength);
+	runBench("gaussian", options, [&](uint64_t i)
+	{
+		gaussian(raw[i % BenchPoolSize].data(), dst.data());
+		g_sink = g_sink + dst[160];
+	});
+
+	runBench("Filter", options, [&](uint64_t i)
+	{
+		wave.assign(raw[i % BenchPoolSize].begin(), raw[i % BenchPoolSize].end());
+		wd.Filter(wave, noise);
+		g_sink = g_sink + noise;
+	});
+
+	runBench("FilterWithRegion", options, [&](uint64_t i)
+	{
+		int region[2];
+		wave.assign(raw[i % BenchPoolSize].begin(), raw[i % BenchPoolSize].end());
+		wd.FilterWithRegion(wave, noise, region);
+		g_sink = g_sink + noise + region[0];
+	});
+
+	GaussList params;
+	runBench("Resolve", options, [&](uint64_t i)
+	{
+		size_t k = i % BenchPoolSize;
+		wave.assign(filtered[k].begin(), filtered[k].end());
+		params.clear();
+		wd.Resolve(wave, params, noises[k]);
+		g_sink = g_sink + params.size();
+	});
+
+	//Optimizeֱ
+	for (int count = 2; count <= 6; count++)
+	{
+		vector<vector<float>> waves(BenchPoolSize);
+		vector<GaussList> initial(BenchPoolSize);
+		for (int k = 0; k < BenchPoolSize; k++)
+		{
+			makeOptimizeCase(rng, count, waves[k], initial[k]);
+		}
+
+		char name[32];
+		sprintf(name, "Optimize/%d", count);
+		runBench(name, options, [&](uint64_t i)
+		{
+			size_t k = i % BenchPoolSize;
+			wave.assign(waves[k].begin(), waves[k].end());
+			params = initial[k];
+			wd.Optimize(wave, params);
+			g_sink = g_sink + params[0].b;
+		});
+	}
+}
+
+
+static void benchDeep(const BenchOptions &options)
+{
+	mt19937 rng(2);
+	PeakWorkspace ws;
+	vector<int> peaks;
+
+	//ֵ⣺ǳˮȡʵˮȺ͸ˮ
+	const int lengths[] = { BenchShallowLength, BenchDeepLength, 4096, 16384 };
+	for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++)
+	{
+		int n = lengths[l];
+		vector<vector<float>> waves;
+		for (int k = 0; k < BenchPoolSize; k++)
+		{
+			waves.push_back(makeDeepWave(rng, n));
+			float floorValue = *min_element(waves[k].begin(), waves[k].end());
+			for (int i = 0; i < n; i++)
+			{
+				waves[k][i] -= floorValue;
+			}
+		}
+		ws.reserve(n);
+
+		char name[32];
+		sprintf(name, "FindLocalMaxima/%d", n);
+		runBench(name, options, [&](uint64_t i)
+		{
+			const vector<float> &w = waves[i % BenchPoolSize];
+			FindLocalMaxima(w.data(), n, 3, 800, 1, 20, ws, peaks);
+			g_sink = g_sink + peaks.size();
+		});
+	}
+
+	//ˮ˲β޳
+	const int deepLengths[] = { BenchDeepLength, 4096 };
+	DeepWave dw;
+	vector<float> wave;
+	float noise;
+	for (size_t l = 0; l < sizeof(deepLengths) / sizeof(deepLengths[0]); l++)
+	{
+		int n = deepLengths[l];
+		vector<vector<float>> waves;
+		for (int k = 0; k < BenchPoolSize; k++)
+		{
+			waves.push_back(makeDeepWave(rng, n));
+		}
+		wave.reserve(n);
+
+		char name[32];
+		sprintf(name, "DeepFilter/%d", n);
+		runBench(name, options, [&](uint64_t i)
+		{
+			const vector<float> &w = waves[i % BenchPoolSize];
+			wave.assign(w.begin(), w.end());
+			dw.DeepFilter(wave, noise);
+			g_sink = g_sink + noise;
+		});
+	}
+}
+
+
+static void benchDecode(const BenchOptions &options)
+{
+	HS_Lidar hs;
+	vector<long> offsets;
+
+	FILE *fp = makeFrameFile(0, offsets);
+	if (fp != NULL)
+	{
+		runBench("initData", options, [&](uint64_t i)
+		{
+			fseek(fp, offsets[i % BenchPoolSize], SEEK_SET);
+			hs.initData(fp);
+			g_sink = g_sink + hs.CH2.nD0[100];
+		});
+		fclose(fp);
+	}
+	else
+	{
+		printf("initData skipped: cannot create temporary file.\n");
+	}
+
+	fp = makeFrameFile(BenchDeepLength, offsets);
+	if (fp != NULL)
+	{
+		runBench("initDeepData", options, [&](uint64_t i)
+		{
+			fseek(fp, offsets[i % BenchPoolSize], SEEK_SET);
+			hs.initDeepData(fp);
+			g_sink = g_sink + hs.deepData2.size();
+		});
+		fclose(fp);
+	}
+	else
+	{
+		printf("initDeepData skipped: cannot create temporary file.\n");
+	}
+}
+
+
+static void benchTime(const BenchOptions &options)
+{
+	//һھȷֲʱ
+	vector<GPSTIME> times(1024);
+	for (size_t k = 0; k < times.size(); k++)
+	{
+		times[k].wn = 2040;
+		times[k].tow.sn = (long)(k * 590);
+		times[k].tow.tos = 0.25;
+	}
+
+	COMMONTIME ct;
+	runBench("GPSTimeToCommonTime", options, [&](uint64_t i)
+	{
+		GPSTimeToCommonTime(&times[i % times.size()], &ct);
+		g_sink = g_sink + ct.second;
+	});
+
+	//10kHzƵʱ
+	GPSDAYCACHE cache;
+	InitGPSDayCache(&cache);
+	runBench("GPSTimeToCommonTimeCached", options, [&](uint64_t i)
+	{
+		GPSTimeToCommonTimeCached(2040, 200000.0 + (i % 1000000) * 1e-4, &cache, &ct);
+		g_sink = g_sink + ct.second;
+	});
+}
+
+
+static const char *compilerName()
+{
+	static char name[64];
+#if defined(__clang__)
+	sprintf(name, "clang %d.%d.%d", __clang_major__, __clang_minor__, __clang_patchlevel__);
+#elif defined(__GNUC__)
+	sprintf(name, "gcc %d.%d.%d", __GNUC__, __GNUC_MINOR__, __GNUC_PATCHLEVEL__);
+#elif defined(_MSC_VER)
+	sprintf(name, "msvc %d", _MSC_VER);
+#else
+	sprintf(name, "unknown");
+#endif
+	return name;
+}
+
+
+/*************************************************
+Function:       дJSON
+Description:    ͺ͸Եns/shotshots/s
+Input:          path:· options:ѡ
+Output:         Ƿдɹ
+*************************************************/
+static bool writeJson(const char *path, const BenchOptions &options)
+{
+	FILE *fp = fopen(path, "w");
+	if (fp == NULL)
+	{
+		return false;
+	}
+
+#ifdef NDEBUG
+	const char *buildType = "release";
+#else
+	const char *buildType = "debug";
+#endif
+	//CMakeʱΪָ͡LTOPGO
+#ifdef MYLIDAR_BUILD_PROFILE
+	const char *profile = MYLIDAR_BUILD_PROFILE;
+#else
+	const char *profile = "";
+#endif
+	fprintf(fp, "{\n");
+	fprintf(fp, "  \"build\": {\"compiler\": \"%s\", \"type\": \"%s\", \"profile\": \"%s\", \"pointerBits\": %d, \"date\": \"%s %s\"},\n",
+		compilerName(), buildType, profile, (int)(sizeof(void *) * 8), __DATE__, __TIME__);
+	fprintf(fp, "  \"isa\": {\"used\": \"%s\", \"detected\": \"%s\", \"forced\": %s},\n", CpuIsaName(Kernels().isa),
+		CpuIsaName(DetectedCpuIsa()), KernelIsaForced() ? "true" : "false");
+	fprintf(fp, "  \"minTime\": %g,\n  \"repetitions\": %d,\n  \"benchmarks\": [\n", options.minTime, options.repetitions);
+	for (size_t k = 0; k < g_results.size(); k++)
+	{
+		const BenchResult &r = g_results[k];
+		fprintf(fp, "    {\"name\": \"%s\", \"shots\": %llu, \"nsPerShot\": %.3f, \"nsPerShotMin\": %.3f, \"shotsPerSecond\": %.1f}%s\n",
+			r.name.c_str(), (unsigned long long)r.shots, r.nsPerShot, r.nsPerShotMin, r.shotsPerSecond,
+			k + 1 < g_results.size() ? "," : "");
+	}
+	fprintf(fp, "  ]\n}\n");
+	return fclose(fp) == 0;
+}
+
+
+static void usage()
+{
+	printf("Usage: myLidarBench [--filter text] [--min-time seconds] [--repetitions n] [--json path] [--isa scalar|sse4.2|avx2|avx512]\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+	BenchOptions options;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+			options.filter = argv[++i];
+		else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+			options.minTime = atof(argv[++i]);
+		else if (strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc)
+			options.repetitions = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+			options.jsonPath = argv[++i];
+		else if (strcmp(argv[i], "--isa") == 0 && i + 1 < argc)
+		{
+			//ָȵָȽϸʵֵ
+			CpuIsa isa;
+			if (!CpuIsaFromName(argv[++i], isa))
+			{
+				usage();
+				return 1;
+			}
+			SetKernelIsa(isa);
+		}
+		else
+		{
+			usage();
+			return 1;
+		}
+	}
+	if (!(options.minTime > 0) || options.repetitions < 1)
+	{
+		usage();
+		return 1;
+	}
+
+	printf("SIMD: %s (detected %s)\n", CpuIsaName(Kernels().isa), CpuIsaName(DetectedCpuIsa()));
+	printf("%-28s %12s %12s %14s %12s\n", "benchmark", "ns/shot", "min ns/shot", "shots/s", "shots");
+	benchShallow(options);
+	benchDeep(options);
+	benchDecode(options);
+	benchTime(options);
+
+	if (options.jsonPath != NULL && !writeJson(options.jsonPath, options))
+	{
+		printf("Cannot write %s\n", options.jsonPath);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,152 @@
+/*************************************************
+Description:ϳHSԭʼļй
+                С֪ˮֵĲļ˵;Ȳ
+**************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <chrono>
+#include "../myLidar/SyntheticData.h"
+using namespace std;
+
+
+static void usage()
+{
+	printf("Usage: myLidarSynth <output> [options]\n"
+		"  --frames N              number of frames\n"
+		"  --size BYTES            file size when --frames is not given (suffix K/M/G)\n"
+		"  --deep                  add second-segment (deep) echoes to CH1-CH3\n"
+		"  --deep-length N         second-segment length (rounded up to 8k+6, default 1006)\n"
+		"  --depth MIN:MAX         depth range in metres (default 2:15)\n"
+		"  --angle A               incidence angle as entered in myLidar (default 0)\n"
+		"  --noise SIGMA           noise standard deviation (default 0.2)\n"
+		"  --corrupt RATE          probability that a frame is corrupted (default 0)\n"
+		"  --corrupt-kinds LIST    comma list of bitflip,badsync,truncate,junk (default all)\n"
+		"  --pulse-rate HZ         pulse rate (default 5000)\n"
+		"  --seed N                random seed (default 1)\n"
+		"  --truth PATH            ground-truth CSV (default <output>.truth.csv, \"-\" for none)\n"
+		"  --background            write through the background writer thread\n");
+}
+
+
+//K/M/G׺ֽ
+static uint64_t parseSize(const char *text)
+{
+	char *end;
+	double value = strtod(text, &end);
+	switch (*end)
+	{
+	case 'k': case 'K': value *= 1024.0; break;
+	case 'm': case 'M': value *= 1024.0 * 1024; break;
+	case 'g': case 'G': value *= 1024.0 * 1024 * 1024; break;
+	default: break;
+	}
+	return value > 0 ? (uint64_t)value : 0;
+}
+
+
+//б
+static bool parseKinds(const char *text, uint32_t &kinds)
+{
+	const char *names[] = { "", "bitflip", "badsync", "truncate", "junk" };
+	kinds = 0;
+	string list = text;
+	size_t begin = 0;
+	while (begin <= list.size())
+	{
+		size_t end = list.find(',', begin);
+		if (end == string::npos)
+			end = list.size();
+		string name = list.substr(begin, end - begin);
+		int kind = 0;
+		for (int k = SYNTH_BITFLIP; k <= SYNTH_JUNK; k++)
+		{
+			if (name == names[k])
+				kind = k;
+		}
+		if (kind == 0)
+			return false;
+		kinds |= 1u << kind;
+		begin = end + 1;
+	}
+	return true;
+}
+
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2 || argv[1][0] == '-')
+	{
+		usage();
+		return 1;
+	}
+
+	const char *output = argv[1];
+	string truthPath = string(output) + ".truth.csv";
+	SynthOptions options;
+	WriteOptions writeOptions;
+	uint64_t frames = 0;
+	uint64_t bytes = 0;
+	for (int i = 2; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--frames") == 0 && hasValue)
+			frames = strtoull(argv[++i], NULL, 10);
+		else if (strcmp(argv[i], "--size") == 0 && hasValue)
+			bytes = parseSize(argv[++i]);
+		else if (strcmp(argv[i], "--deep") == 0)
+			options.deep = true;
+		else if (strcmp(argv[i], "--deep-length") == 0 && hasValue)
+			options.deepLength = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--depth") == 0 && hasValue)
+		{
+			if (sscanf(argv[++i], "%lf:%lf", &options.minDepth, &options.maxDepth) != 2 || options.minDepth > options.maxDepth)
+			{
+				usage();
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--angle") == 0 && hasValue)
+			options.angle = atof(argv[++i]);
+		else if (strcmp(argv[i], "--noise") == 0 && hasValue)
+			options.noise = atof(argv[++i]);
+		else if (strcmp(argv[i], "--corrupt") == 0 && hasValue)
+			options.corruptRate = atof(argv[++i]);
+		else if (strcmp(argv[i], "--corrupt-kinds") == 0 && hasValue)
+		{
+			if (!parseKinds(argv[++i], options.corruptKinds))
+			{
+				usage();
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--pulse-rate") == 0 && hasValue)
+			options.pulseRate = atof(argv[++i]);
+		else if (strcmp(argv[i], "--seed") == 0 && hasValue)
+			options.seed = strtoull(argv[++i], NULL, 10);
+		else if (strcmp(argv[i], "--truth") == 0 && hasValue)
+			truthPath = argv[++i];
+		else if (strcmp(argv[i], "--background") == 0)
+			writeOptions.background = true;
+		else
+		{
+			usage();
+			return 1;
+		}
+	}
+	if ((frames == 0 && bytes == 0) || !(options.pulseRate > 0))
+	{
+		usage();
+		return 1;
+	}
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	SynthStats stats;
+	bool ok = GenerateRawFile(output, truthPath == "-" ? NULL : truthPath.c_str(), options, frames, bytes, writeOptions, stats);
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	printf("%s: %llu frames, %.1f MB, %llu corrupted, %.2f s (%.1f MB/s)%s\n", output,
+		(unsigned long long)stats.frames, stats.bytes / 1048576.0, (unsigned long long)stats.corrupted,
+		seconds, stats.bytes / 1048576.0 / seconds, ok ? "" : ", write failed");
+	return ok ? 0 : 1;
+}